@@ -0,0 +1,225 @@
+/*
+    ==========================================================
+    MODULE 11: READING THOUSANDS OF FILES - BLOCKING VS. ASYNC
+    ==========================================================
+    readFile() in 4_menu_file_operations.cpp opens one file,
+    reads it to the end with an ifstream, and only then moves on.
+    With thousands of files the disk sees one request at a time.
+
+    This program writes `--files` files of `--kb` KiB each (with
+    overwriteFileAsync), evicts them from the page cache before
+    every run, and reads them all back:
+
+    1. files/ifstream          one file after the other, ifstream
+    2. files/async_threads     readFileAsync, thread-pool backend
+                               (8 threads doing pread)
+    3. files/async_uring       readFileAsync, io_uring backend
+                               (128 requests in flight)
+    4. reads/uring_fixed       files opened beforehand, io_uring
+                               with 64 registered buffers reused
+                               as completions arrive
+
+    Key Concepts:
+    - Eviction uses posix_fadvise(POSIX_FADV_DONTNEED), so every
+      run reads from the device. Pass --cached to skip it and
+      measure the page-cache (CPU) path instead.
+    - "per submit" is the number of requests handed to the
+      kernel by one io_uring_enter() system call.
+
+    Compile & run:
+        g++ -std=c++17 -O2 -pthread 11_async_file_io.cpp -o asyncio
+        ./asyncio --bench-samples=3
+        ./asyncio --files=10000 --kb=16 --bench-samples=3
+*/
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include "../28.Compiler and Low-Level Optimizations/benchmark.h"
+#include "async_io.h"
+#include "student_store.h"
+using namespace std;
+
+const string DIR = "async_io_files";
+
+string fileName(size_t i) { return DIR + "/file_" + to_string(i) + ".txt"; }
+
+void evict(size_t files) {
+    for (size_t i = 0; i < files; ++i) {
+        int fd = open(fileName(i).c_str(), O_RDONLY);
+        if (fd < 0) continue;
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t files = 2000, kb = 64;
+    bool cached = false;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.rfind("--files=", 0) == 0) files = strtoull(arg.c_str() + 8, nullptr, 10);
+        if (arg.rfind("--kb=", 0) == 0) kb = strtoull(arg.c_str() + 5, nullptr, 10);
+        if (arg == "--cached") cached = true;
+    }
+    const size_t fileBytes = kb << 10;
+
+    // Writing the test files is itself asynchronous.
+    mkdir(DIR.c_str(), 0755);
+    {
+        fastio::AsyncIo io;
+        bool uring = io.backend() == fastio::IoBackend::IoUring;
+        cout << "Backend: " << (uring ? "io_uring" : "thread pool") << "\n";
+        vector<future<void>> written;
+        for (size_t i = 0; i < files; ++i)
+            written.push_back(fastio::overwriteFileAsync(
+                io, fileName(i), string(fileBytes, static_cast<char>('a' + i % 26))));
+        for (future<void>& w : written) w.get();
+    }
+    cout << files << " files of " << kb << " KiB in " << DIR << "/\n\n";
+
+    auto setUp = [&](bench::State& state) {
+        state.pauseTiming();
+        if (!cached) evict(files);
+        state.resumeTiming();
+    };
+
+    bench::registerCase("files/ifstream", [&](bench::State& state) {
+        for (auto _ : state) {
+            setUp(state);
+            size_t total = 0;
+            for (size_t i = 0; i < files; ++i) {
+                ifstream file(fileName(i), ios::binary);
+                ostringstream contents;
+                contents << file.rdbuf();
+                total += contents.str().size();
+            }
+            bench::DoNotOptimize(total);
+        }
+        state.setBytesProcessed(files * fileBytes);
+    });
+
+    auto readAll = [&](fastio::IoBackend backend) {
+        return [&, backend](bench::State& state) {
+            fastio::AsyncIoOptions options;
+            options.backend = backend;
+            fastio::AsyncIo io(options);
+            for (auto _ : state) {
+                setUp(state);
+                vector<future<string>> contents;
+                contents.reserve(files);
+                for (size_t i = 0; i < files; ++i)
+                    contents.push_back(fastio::readFileAsync(io, fileName(i)));
+                size_t total = 0;
+                for (future<string>& c : contents) total += c.get().size();
+                bench::DoNotOptimize(total);
+            }
+            state.setBytesProcessed(files * fileBytes);
+            fastio::AsyncIo::Stats stats = io.stats();
+            if (stats.submits)
+                state.setCounter("per submit", double(stats.requests) / stats.submits);
+        };
+    };
+    bench::registerCase("files/async_threads", readAll(fastio::IoBackend::ThreadPool));
+    bench::registerCase("files/async_uring", readAll(fastio::IoBackend::Auto));
+
+    bench::registerCase("reads/uring_fixed", [&](bench::State& state) {
+        constexpr size_t kSlots = 64;
+        vector<char> memory(kSlots * fileBytes);
+        fastio::AsyncIoOptions options;
+        for (size_t s = 0; s < kSlots; ++s)
+            options.buffers.push_back({memory.data() + s * fileBytes, fileBytes});
+        fastio::AsyncIo io(options);
+        vector<int> fds(files);
+        for (auto _ : state) {
+            setUp(state);
+            state.pauseTiming();
+            for (size_t i = 0; i < files; ++i) fds[i] = open(fileName(i).c_str(), O_RDONLY);
+            state.resumeTiming();
+
+            // Each slot reads one file, then moves on to the next unread one.
+            atomic<size_t> nextFile{0}, total{0};
+            function<void(size_t)> start = [&](size_t slot) {
+                size_t i = nextFile++;
+                if (i >= files) return;
+                char* buf = memory.data() + slot * fileBytes;
+                io.read(fds[i], buf, fileBytes, 0, [&, slot](long r) {
+                    if (r > 0) total += static_cast<size_t>(r);
+                    start(slot);
+                }, static_cast<int>(slot));
+            };
+            for (size_t s = 0; s < kSlots; ++s) start(s);
+            io.drain();
+            bench::DoNotOptimize(total.load());
+
+            state.pauseTiming();
+            for (int fd : fds) close(fd);
+            state.resumeTiming();
+        }
+        state.setBytesProcessed(files * fileBytes);
+        fastio::AsyncIo::Stats stats = io.stats();
+        if (stats.submits)
+            state.setCounter("per submit", double(stats.requests) / stats.submits);
+    });
+
+    int rc = bench::runAll(argc, argv);
+    for (size_t i = 0; i < files; ++i) remove(fileName(i).c_str());
+    rmdir(DIR.c_str());
+
+    // Binary Student records, read asynchronously from a student_store.h file.
+    const string storeFile = "async_students.bin";
+    remove(storeFile.c_str());
+    {
+        fastio::StudentWriter writer(storeFile);
+        for (int i = 0; i < 1000; ++i) {
+            fastio::Student s = {};
+            snprintf(s.name, sizeof(s.name), "Student %d", i);
+            s.age = 18 + i % 10;
+            s.gpa = 2.0f + (i % 20) / 10.0f;
+            writer.append(s);
+        }
+    }
+    fastio::AsyncIo io;
+    vector<fastio::Student> some = fastio::readStudentsAsync(io, storeFile, 500, 3).get();
+    cout << "\nRecords 500-502 of " << storeFile << ":\n";
+    for (const fastio::Student& s : some)
+        cout << "  " << s.name << ", age " << s.age << ", gpa " << s.gpa << '\n';
+    try {
+        fastio::readStudentsAsync(io, storeFile, 999, 5).get();
+    } catch (const out_of_range& e) {
+        cout << "Reading past the end: " << e.what() << '\n';
+    }
+    remove(storeFile.c_str());
+    return rc;
+}
+
+/*
+    What to expect (on an NVMe disk; numbers vary with the device):
+    - files/ifstream keeps one request in flight and runs at a
+      fraction of the disk bandwidth.
+    - files/async_threads keeps up to 8 requests in flight: several
+      times faster, at the cost of 8 threads and a context switch
+      per read.
+    - files/async_uring keeps up to 128 in flight from a single
+      thread and submits dozens of reads per system call; it is the
+      fastest, or as fast as the thread pool on devices with a
+      shallow queue.
+    - reads/uring_fixed shows the steady state of a server: files
+      already open and no allocation per read.
+    - With --cached all cases are limited by memory copies, and the
+      difference shrinks to the system-call and thread overhead.
+    - The last lines show records 500-502 ("Student 500", ...) and
+      the out_of_range error for records 999..1004.
+*/
@@ -0,0 +1,201 @@
+/*
+    ==========================================================
+    MODULE 12: LOGGING FROM MANY THREADS - COUT VS. ASYNC LOGGER
+    ==========================================================
+    printSuccess() in color_helper_functions.cpp writes
+    `GREEN << message << RESET << std::endl` to std::cout. This
+    program has several threads log short coloured messages and
+    measures messages/s and the time each logging call takes:
+
+    1. cout_endl          the original printSuccess(): one
+                          write() per message (std::endl)
+    2. cout_newline       the same with '\n': cout buffers
+    3. async/block        fastio::AsyncLogger, OverflowPolicy::Block
+    4. async/drop         OverflowPolicy::Drop with 4 KiB rings:
+                          a burst larger than the ring is cut
+
+    Each case reports, besides the rate:
+    - p50 ns / p99 ns   time spent inside one logging call
+    - dropped           messages lost (async/drop)
+    - per write         messages per write() (async cases)
+
+    Key Concepts:
+    - Output goes to /dev/null (standard output is redirected
+      while the cases run), so the numbers measure the logging
+      path, not the terminal.
+    - cout is used as the original helpers use it: with
+      sync_with_stdio(true), each << locks the stream, and lines
+      of different threads can interleave.
+    - The logger's call does not write: it copies into the
+      thread's ring and returns. The flusher writes the batches.
+
+    Compile & run:
+        g++ -std=c++17 -O2 -pthread 12_async_logging.cpp -o asynclog
+        ./asynclog --bench-samples=3
+        ./asynclog --threads=16 --messages=20000 --bench-samples=3
+*/
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../28.Compiler and Low-Level Optimizations/benchmark.h"
+#include "append_log.h"
+#include "async_logger.h"
+using namespace std;
+
+const string GREEN = "\033[32m";
+const string RESET = "\033[0m";
+
+// Sends standard output to /dev/null for the lifetime of the object.
+class DiscardStdout {
+public:
+    DiscardStdout() {
+        cout.flush();
+        saved_ = dup(STDOUT_FILENO);
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        close(null);
+    }
+    ~DiscardStdout() {
+        cout.flush();
+        dup2(saved_, STDOUT_FILENO);
+        close(saved_);
+    }
+
+private:
+    int saved_;
+};
+
+// Runs `threads` threads that each log `messages` messages with `log`, and
+// records how long every call takes.
+template <class Log>
+fastio::LatencyHistogram runThreads(int threads, int messages, Log log) {
+    vector<fastio::LatencyHistogram> perThread(threads);
+    vector<thread> pool;
+    for (int t = 0; t < threads; ++t)
+        pool.emplace_back([&, t] {
+            string message = "worker " + to_string(t) + " finished request ";
+            const size_t prefix = message.size();
+            for (int i = 0; i < messages; ++i) {
+                message.resize(prefix);
+                message += to_string(i);
+                auto start = chrono::steady_clock::now();
+                log(message);
+                perThread[t].record(static_cast<uint64_t>(
+                    chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start)
+                        .count()));
+            }
+        });
+    for (thread& th : pool) th.join();
+    fastio::LatencyHistogram all;
+    for (const fastio::LatencyHistogram& h : perThread) all.merge(h);
+    return all;
+}
+
+void report(bench::State& state, const fastio::LatencyHistogram& latency, size_t messages) {
+    state.setItemsProcessed(messages);
+    state.setCounter("p50 ns", static_cast<double>(latency.percentile(0.50)));
+    state.setCounter("p99 ns", static_cast<double>(latency.percentile(0.99)));
+}
+
+int main(int argc, char** argv) {
+    int threads = 4, messages = 100000;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.rfind("--threads=", 0) == 0) threads = atoi(arg.c_str() + 10);
+        if (arg.rfind("--messages=", 0) == 0) messages = atoi(arg.c_str() + 11);
+    }
+    const size_t total = static_cast<size_t>(threads) * messages;
+    cout << threads << " threads x " << messages << " messages, written to /dev/null\n\n";
+
+    bench::registerCase("cout_endl", [&](bench::State& state) {
+        fastio::LatencyHistogram latency;
+        DiscardStdout discard;
+        for (auto _ : state)
+            latency.merge(runThreads(threads, messages, [](const string& message) {
+                cout << GREEN << message << RESET << endl;
+            }));
+        report(state, latency, total);
+    });
+
+    bench::registerCase("cout_newline", [&](bench::State& state) {
+        fastio::LatencyHistogram latency;
+        DiscardStdout discard;
+        for (auto _ : state) {
+            latency.merge(runThreads(threads, messages, [](const string& message) {
+                cout << GREEN << message << RESET << '\n';
+            }));
+            cout.flush();
+        }
+        report(state, latency, total);
+    });
+
+    auto asyncCase = [&](const string& name, fastio::OverflowPolicy overflow, size_t ringBytes) {
+        bench::registerCase(name, [&, overflow, ringBytes](bench::State& state) {
+            fastio::LatencyHistogram latency;
+            fastio::AsyncLogger::Stats stats;
+            DiscardStdout discard;
+            for (auto _ : state) {
+                fastio::AsyncLoggerOptions options;
+                options.overflow = overflow;
+                options.ringBytes = ringBytes;
+                fastio::AsyncLogger logger(options);
+                latency.merge(runThreads(threads, messages, [&](const string& message) {
+                    logger.log(fastio::Severity::Success, message);
+                }));
+                logger.flush();
+                stats = logger.stats();
+            }
+            report(state, latency, total);
+            state.setCounter("dropped", static_cast<double>(stats.dropped));
+            state.setCounter("per write", static_cast<double>(stats.records) / stats.writes);
+        });
+    };
+    asyncCase("async/block", fastio::OverflowPolicy::Block, 64 * 1024);
+    asyncCase("async/drop", fastio::OverflowPolicy::Drop, 4 * 1024);
+
+    int rc = bench::runAll(argc, argv);
+    cout << endl;
+
+    // The same logger on the terminal: severity picks the colour.
+    fastio::AsyncLogger logger;
+    vector<thread> workers;
+    for (int t = 0; t < 3; ++t)
+        workers.emplace_back([&logger, t] {
+            logger.log(fastio::Severity::Info, "worker " + to_string(t) + " starting");
+            logger.log(t == 2 ? fastio::Severity::Error : fastio::Severity::Success,
+                       "worker " + to_string(t) + (t == 2 ? " failed" : " done"));
+        });
+    for (thread& w : workers) w.join();
+    logger.flush();
+    return rc;
+}
+
+/*
+    What to expect:
+    - cout_endl makes one write() system call per message. Even
+      to /dev/null that costs a few hundred nanoseconds per call;
+      on a terminal or a pipe, many microseconds.
+    - cout_newline saves the system calls but still locks the
+      stream for each <<; the lines of different threads can
+      come out mixed.
+    - async/block is the fastest of the lossless cases, about
+      twice the rate of cout_endl: the call is a copy into the
+      thread's own ring, with the lowest p50 and p99, and one
+      write() carries thousands of messages ("per write").
+    - async/drop never waits: it has the lowest p99, and with
+      4 KiB rings most of each burst is dropped ("dropped"); the
+      output says so in "[N messages dropped]" lines.
+    - With more cores than threads, cout_endl and cout_newline
+      also contend for the stream's lock, and the gap to the
+      async cases widens.
+    - The last lines show the logger on the terminal: "starting"
+      lines uncoloured, "done" in green, "failed" in red.
+*/
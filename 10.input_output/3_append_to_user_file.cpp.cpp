@@ -6,7 +6,8 @@
           existing file instead of overwriting it.
 
     Key Features:
-    - Use `std::ofstream` with the `std::ios::app` flag.
+    - Open the file in append mode (`std::ios::app` for an
+      `std::ofstream`, O_APPEND for `fastio::AppendLog`).
     - Append user-provided data to the end of the file.
     - Handle file opening errors gracefully.
 
@@ -17,11 +18,19 @@
     New Concepts:
     - `std::ios::app` (append mode): Ensures that data is added
       to the end of the file without erasing existing contents.
+    - The append goes through `fastio::AppendLog` (append_log.h)
+      instead of an `ofstream`: one file descriptor opened with
+      O_APPEND and kept open, and `commit()` returns once the line
+      is on the disk. A program that appends many lines should
+      keep such a log open instead of reopening the file for
+      every line.
 */
 
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <system_error>
+#include "append_log.h"
 using namespace std;
 
 int main() {
@@ -35,26 +44,28 @@ int main() {
     // 1. Opening the File in Append Mode
     // ==========================================================
     /*
-        To append data, we use the `std::ios::app` flag with `std::ofstream`.
-        This ensures that data is added to the end of the file 
-        without overwriting its existing content.
+        `fastio::AppendLog` opens the file with O_APPEND, the
+        system-call form of `std::ios::app`: data is added to the
+        end of the file without overwriting its existing content.
+        The log keeps the file open, so further commits cost no
+        open()/close(). With Durability::EveryBatch, commit()
+        returns once the line is on the disk, where `endl` would
+        only hand it to the kernel.
     */
-    ofstream userFile(filename, ios::app); // Open in append mode
-    if (!userFile) {
-        cerr << "Error: Could not open the file '" << filename << "' for appending." << endl;
-        return 1; // Exit the program if the file could not be opened
-    }
-
-    // Prompt the user for content to append
-    cout << "Enter the content to append to '" << filename << "':" << endl;
-    string content;
-    getline(cin, content); // Read the content from the user
+    try {
+        fastio::AppendLog log(filename, {fastio::Durability::EveryBatch}); // Open in append mode
 
-    // Write the content to the file
-    userFile << content << endl;
+        // Prompt the user for content to append
+        cout << "Enter the content to append to '" << filename << "':" << endl;
+        string content;
+        getline(cin, content); // Read the content from the user
 
-    // Close the file
-    userFile.close();
+        // Write the content to the file and wait until it is on the disk
+        log.commit(content + '\n');
+    } catch (const system_error& e) {
+        cerr << "Error: Could not append to the file '" << filename << "': " << e.what() << endl;
+        return 1; // Exit the program if the file could not be opened or written
+    }
     cout << "Data appended to '" << filename << "' successfully." << endl;
 
     // ==========================================================
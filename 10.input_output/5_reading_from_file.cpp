@@ -7,8 +7,10 @@
     
     1. Using `std::ifstream` to read files.
     2. Reading line-by-line using `getline`.
-    3. Reading specific formats (e.g., numbers, words).
+    3. Reading specific formats (e.g., numbers, words) and
+       reporting the tokens that are not numbers.
     4. Handling file reading errors.
+    5. Zero-copy reading with a memory-mapped file (mapped_file.h).
 
     Practical Applications:
     - Reading configuration files.
@@ -26,7 +28,11 @@
 #include <iostream>
 #include <fstream>
 #include <string>
-#include <sstream> // For string streams
+#include <string_view>
+#include <system_error>
+
+#include "mapped_file.h"   // MappedFile, lines(), tokens()
+#include "number_parser.h" // parseNumbers()
 using namespace std;
 
 int main() {
@@ -83,28 +89,34 @@ int main() {
     // ==========================================================
     /*
         Structured data often contains numbers that need to 
-        be processed. Using `std::istringstream`, we can parse 
-        lines containing multiple numbers.
+        be processed. `fastio::parseNumbers` (number_parser.h) 
+        converts every whitespace-separated token of the file with 
+        `std::from_chars`: no string stream per line, and a token 
+        that is not a number is reported with its line and column 
+        instead of silently ending the line.
     */
-    inputFile.open(filename); // Re-open the file for reading
-    if (!inputFile) {
-        cerr << "Error: Could not open the file '" << filename << "' for reading." << endl;
-        return 1;
-    }
+    try {
+        fastio::MappedFile numbersFile(filename);
+        fastio::NumberList<int> numbers = fastio::parseNumbers<int>(numbersFile.data(), 5);
 
-    cout << "Extracting numbers from the file:" << endl;
-    while (getline(inputFile, line)) { // Read each line
-        istringstream iss(line); // Create a string stream
-        int number;
-        while (iss >> number) { // Extract numbers from the line
+        cout << "Extracting numbers from the file:" << endl;
+        for (int number : numbers.values) {
             cout << number << " "; // Print each number
         }
+        cout << endl;
+        for (const fastio::ParseError& e : numbers.errors) {
+            cout << "  skipped " << e.message() << endl;
+        }
+        if (numbers.errorCount > numbers.errors.size()) {
+            cout << "  ... and " << numbers.errorCount - numbers.errors.size()
+                 << " more non-numeric tokens" << endl;
+        }
+    } catch (const system_error& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
     }
     cout << endl;
 
-    inputFile.close(); // Close the file
-    cout << endl;
-
     // ==========================================================
     // 4. Handling Errors While Reading
     // ==========================================================
@@ -121,5 +133,36 @@ int main() {
         inputFile.close();
     }
 
+    // ==========================================================
+    // 5. Zero-Copy Reading with a Memory-Mapped File
+    // ==========================================================
+    /*
+        Sections 1-3 copy every byte into a new `std::string`. For 
+        large files, map the file instead: lines and words become 
+        `std::string_view`s pointing straight into the file's pages. 
+        (See 7_fast_file_reading.cpp for the speed difference.)
+    */
+    try {
+        fastio::MappedFile mapped(filename);
+        cout << "Lines via MappedFile (" << (mapped.mapped() ? "mmap" : "read()") << "):" << endl;
+        for (string_view l : fastio::lines(mapped.data())) {
+            cout << l << endl;
+        }
+
+        size_t wordCount = 0;
+        for (string_view w : fastio::tokens(mapped.data())) {
+            (void)w;
+            ++wordCount;
+        }
+        cout << "Words: " << wordCount << endl;
+
+        // Chunked iteration: bounded memory, chunks end on a line boundary.
+        size_t chunks = 0;
+        mapped.forEachChunk(1 << 20, [&](string_view) { ++chunks; });
+        cout << "Chunks of 1 MiB: " << chunks << endl;
+    } catch (const system_error& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+
     return 0; // End of the program
 }
\ No newline at end of file
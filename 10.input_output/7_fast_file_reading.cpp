@@ -0,0 +1,199 @@
+/*
+    ==========================================================
+    MODULE 7: FAST FILE READING - STREAMS VS. mmap
+    ==========================================================
+    5_reading_from_file.cpp reads a file with `getline` and with
+    `>>`. Both are convenient, but each line or word is copied
+    into a `std::string`, and delimiters are found one character
+    at a time inside the stream machinery.
+
+    This program generates a log-like text file and measures, in
+    GB/s, how fast it can be split into lines and into words:
+
+    1. lines/getline           std::getline into a std::string
+    2. lines/memchr            mmap + memchr for each '\n'
+    3. lines/mapped            fastio::lines over a MappedFile
+    4. lines/read_chunks       read() in 4 MiB blocks + fastio::lines
+    5. words/extract           file >> word
+    6. words/scalar            mmap + one isSpace() test per char
+    7. words/mapped            fastio::tokens over a MappedFile
+
+    fastio::lines and fastio::tokens use delimiter_scanner.h, which
+    classifies 64 bytes at a time with SIMD compares and walks the
+    resulting bitmaps; cases 2 and 6 are the byte-at-a-time
+    baselines it replaces.
+
+    Key Concepts:
+    - The file is generated once, so it is in the page cache: the
+      numbers measure CPU cost, not the disk.
+    - `bytes/s` in the report is the file size divided by the time
+      of one full pass.
+
+    Compile & run:
+        g++ -std=c++17 -O2 -march=native 7_fast_file_reading.cpp -o fastread
+        ./fastread --bench-samples=5
+        ./fastread --size-mb=2048 --bench-samples=3
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "../28.Compiler and Low-Level Optimizations/benchmark.h"
+#include "mapped_file.h"
+using namespace std;
+
+const string FILENAME = "fast_reading_test.txt";
+
+// Writes about `megabytes` MB of lines such as
+// "2024-01-17 12:00:03 INFO worker-7 request 123456 took 42 ms".
+size_t generateFile(size_t megabytes) {
+    ofstream out(FILENAME, ios::binary);
+    const char* levels[] = {"INFO", "WARN", "DEBUG", "ERROR"};
+    size_t written = 0, target = megabytes << 20;
+    unsigned x = 12345;
+    char line[128];
+    while (written < target) {
+        x = x * 1103515245u + 12345u;
+        int len = snprintf(line, sizeof(line), "2024-01-17 12:%02u:%02u %s worker-%u request %u took %u ms\n",
+                           (x >> 8) % 60, (x >> 14) % 60, levels[(x >> 20) % 4], (x >> 3) % 16,
+                           x % 1000000, (x >> 11) % 500);
+        out.write(line, len);
+        written += static_cast<size_t>(len);
+    }
+    return written;
+}
+
+int main(int argc, char** argv) {
+    size_t megabytes = 64;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.rfind("--size-mb=", 0) == 0) megabytes = strtoull(arg.c_str() + 10, nullptr, 10);
+    }
+    const size_t bytes = generateFile(megabytes);
+    cout << "Test file: " << FILENAME << " (" << (bytes >> 20) << " MiB)\n\n";
+
+    bench::registerCase("lines/getline", [bytes](bench::State& state) {
+        for (auto _ : state) {
+            ifstream in(FILENAME);
+            string line;
+            size_t count = 0;
+            while (getline(in, line)) ++count;
+            bench::DoNotOptimize(count);
+        }
+        state.setBytesProcessed(bytes);
+    });
+
+    bench::registerCase("lines/memchr", [bytes](bench::State& state) {
+        for (auto _ : state) {
+            fastio::MappedFile file(FILENAME);
+            string_view text = file.data();
+            size_t count = 0, pos = 0;
+            while (pos < text.size()) {
+                const void* nl = memchr(text.data() + pos, '\n', text.size() - pos);
+                size_t end = nl ? static_cast<const char*>(nl) - text.data() : text.size();
+                bench::DoNotOptimize(text.substr(pos, end - pos));
+                ++count;
+                pos = end + 1;
+            }
+            bench::DoNotOptimize(count);
+        }
+        state.setBytesProcessed(bytes);
+    });
+
+    bench::registerCase("lines/mapped", [bytes](bench::State& state) {
+        for (auto _ : state) {
+            fastio::MappedFile file(FILENAME);
+            size_t count = 0;
+            for (string_view line : fastio::lines(file.data())) {
+                bench::DoNotOptimize(line);
+                ++count;
+            }
+            bench::DoNotOptimize(count);
+        }
+        state.setBytesProcessed(bytes);
+    });
+
+    bench::registerCase("lines/read_chunks", [bytes](bench::State& state) {
+        for (auto _ : state) {
+            fastio::MappedFile file(FILENAME, fastio::MappedFile::Mode::Read);
+            size_t count = 0;
+            file.forEachChunk(fastio::MappedFile::kReadBlock, [&](string_view chunk) {
+                for (string_view line : fastio::lines(chunk)) {
+                    bench::DoNotOptimize(line);
+                    ++count;
+                }
+            });
+            bench::DoNotOptimize(count);
+        }
+        state.setBytesProcessed(bytes);
+    });
+
+    bench::registerCase("words/extract", [bytes](bench::State& state) {
+        for (auto _ : state) {
+            ifstream in(FILENAME);
+            string word;
+            size_t count = 0;
+            while (in >> word) ++count;
+            bench::DoNotOptimize(count);
+        }
+        state.setBytesProcessed(bytes);
+    });
+
+    bench::registerCase("words/scalar", [bytes](bench::State& state) {
+        for (auto _ : state) {
+            fastio::MappedFile file(FILENAME);
+            string_view text = file.data();
+            size_t count = 0, pos = 0;
+            for (;;) {
+                while (pos < text.size() && fastio::isSpace(text[pos])) ++pos;
+                if (pos >= text.size()) break;
+                size_t start = pos;
+                while (pos < text.size() && !fastio::isSpace(text[pos])) ++pos;
+                bench::DoNotOptimize(text.substr(start, pos - start));
+                ++count;
+            }
+            bench::DoNotOptimize(count);
+        }
+        state.setBytesProcessed(bytes);
+    });
+
+    bench::registerCase("words/mapped", [bytes](bench::State& state) {
+        for (auto _ : state) {
+            fastio::MappedFile file(FILENAME);
+            size_t count = 0;
+            for (string_view word : fastio::tokens(file.data())) {
+                bench::DoNotOptimize(word);
+                ++count;
+            }
+            bench::DoNotOptimize(count);
+        }
+        state.setBytesProcessed(bytes);
+    });
+
+    int rc = bench::runAll(argc, argv);
+    remove(FILENAME.c_str());
+    return rc;
+}
+
+/*
+    What to expect:
+    - lines/mapped is about 2x faster than lines/getline: no copy
+      into a std::string. It runs at the same speed as
+      lines/memchr (glibc's memchr is itself vectorized); at
+      ~3 GB/s both are limited by page faults on the mapping.
+    - lines/read_chunks is close to lines/mapped: one copy from the
+      page cache in 4 MiB blocks is cheap compared with per-line
+      stream overhead.
+    - words/scalar is about 4x faster than words/extract, which
+      also pays for locale-aware whitespace tests on every char.
+    - words/mapped is another ~1.5x faster than words/scalar: the
+      byte loop mispredicts the end of almost every word, the
+      bitmap scanner classifies 64 bytes per step and extracts the
+      word boundaries branch-free. Without -march=native (SSE2
+      instead of AVX2) it is only slightly slower.
+*/
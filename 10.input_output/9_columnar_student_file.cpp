@@ -0,0 +1,177 @@
+/*
+    ==========================================================
+    MODULE 9: ROWS VS. COLUMNS - SCANNING STUDENT FILES
+    ==========================================================
+    The same students are stored twice:
+    - row-wise with student_store.h (64 bytes per student), and
+    - column-wise with student_columns.h (a name dictionary, a
+      bit-packed age column and a float32 gpa column).
+
+    The program then answers three analytics queries on both files
+    and reports rows/s and the bytes each query has to read:
+
+    1. avg_gpa      average gpa
+                    rows: decode every record, columns: SIMD sum of
+                    the gpa column (plus a scalar loop for reference)
+    2. avg_age      average age
+                    columns: unpack 4-bit values
+    3. count_name   how many students are called "Emma 42"
+                    rows: compare strings, columns: look the name up
+                    once in the dictionary, then compare codes
+
+    Key Concepts:
+    - A scan costs roughly what it reads: the gpa column is 1/16 of
+      the row file, the age column 1/128.
+    - Both files are mapped and in the page cache, so the numbers
+      measure memory traffic and decoding, not the disk.
+
+    Compile & run:
+        g++ -std=c++17 -O2 -march=native 9_columnar_student_file.cpp -o columns
+        ./columns --bench-samples=5
+        ./columns --rows=20000000 --bench-samples=3
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../28.Compiler and Low-Level Optimizations/benchmark.h"
+#include "student_columns.h"
+#include "student_store.h"
+using namespace std;
+
+const string ROW_FILE = "students_rows.bin";
+const string COLUMN_FILE = "students_columns.bin";
+
+fastio::Student makeStudent(size_t i) {
+    static const char* names[] = {"Alice", "Bob", "Chloe", "David", "Emma", "Farid", "Grace", "Hugo"};
+    unsigned x = static_cast<unsigned>(i) * 2654435761u;
+    fastio::Student s = {};
+    snprintf(s.name, sizeof(s.name), "%s %u", names[x % 8], (x >> 8) % 1000);
+    s.age = 18 + static_cast<int>((x >> 20) % 12);
+    s.gpa = 2.0f + static_cast<float>((x >> 4) % 21) / 10.0f;
+    return s;
+}
+
+int main(int argc, char** argv) {
+    size_t rows = 2000000;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.rfind("--rows=", 0) == 0) rows = strtoull(arg.c_str() + 7, nullptr, 10);
+    }
+
+    vector<fastio::Student> students;
+    students.reserve(rows);
+    for (size_t i = 0; i < rows; ++i) students.push_back(makeStudent(i));
+    remove(ROW_FILE.c_str());
+    {
+        fastio::StudentWriter writer(ROW_FILE);
+        writer.append(students.begin(), students.end());
+    }
+    fastio::writeStudentColumns(COLUMN_FILE, students);
+    students = {};
+
+    fastio::StudentStore rowStore(ROW_FILE);
+    fastio::StudentColumns columns(COLUMN_FILE);
+    const size_t rowBytes = rows * fastio::studentfile::kRecordSize;
+    cout << rows << " students\n"
+         << "  row file:     " << rowBytes / 1e6 << " MB\n"
+         << "  name column:  " << columns.columnBytes(fastio::Column::Name) / 1e6 << " MB\n"
+         << "  age column:   " << columns.columnBytes(fastio::Column::Age) / 1e6 << " MB\n"
+         << "  gpa column:   " << columns.columnBytes(fastio::Column::Gpa) / 1e6 << " MB\n\n";
+
+    auto reads = [](bench::State& state, size_t items, size_t bytes) {
+        state.setItemsProcessed(items);
+        state.setCounter("MB read", bytes / 1e6);
+    };
+
+    bench::registerCase("avg_gpa/rows", [&](bench::State& state) {
+        for (auto _ : state) {
+            double total = 0.0;
+            for (size_t i = 0; i < rowStore.size(); ++i) total += rowStore[i].gpa;
+            bench::DoNotOptimize(total);
+        }
+        reads(state, rows, rowBytes);
+    });
+
+    bench::registerCase("avg_gpa/columns_scalar", [&](bench::State& state) {
+        for (auto _ : state) {
+            double total = 0.0;
+            for (size_t i = 0; i < columns.size(); ++i) total += columns.gpa(i);
+            bench::DoNotOptimize(total);
+        }
+        reads(state, rows, columns.columnBytes(fastio::Column::Gpa));
+    });
+
+    bench::registerCase("avg_gpa/columns_simd", [&](bench::State& state) {
+        for (auto _ : state) {
+            double average = columns.averageGpa();
+            bench::DoNotOptimize(average);
+        }
+        reads(state, rows, columns.columnBytes(fastio::Column::Gpa));
+    });
+
+    bench::registerCase("avg_age/rows", [&](bench::State& state) {
+        for (auto _ : state) {
+            long long total = 0;
+            for (size_t i = 0; i < rowStore.size(); ++i) total += rowStore[i].age;
+            bench::DoNotOptimize(total);
+        }
+        reads(state, rows, rowBytes);
+    });
+
+    bench::registerCase("avg_age/columns", [&](bench::State& state) {
+        for (auto _ : state) {
+            double average = columns.averageAge();
+            bench::DoNotOptimize(average);
+        }
+        reads(state, rows, columns.columnBytes(fastio::Column::Age));
+    });
+
+    bench::registerCase("count_name/rows", [&](bench::State& state) {
+        for (auto _ : state) {
+            size_t count = 0;
+            for (size_t i = 0; i < rowStore.size(); ++i) count += rowStore.name(i) == "Emma 42";
+            bench::DoNotOptimize(count);
+        }
+        reads(state, rows, rowBytes);
+    });
+
+    bench::registerCase("count_name/columns", [&](bench::State& state) {
+        for (auto _ : state) {
+            size_t count = columns.countName("Emma 42");
+            bench::DoNotOptimize(count);
+        }
+        reads(state, rows, columns.columnBytes(fastio::Column::Name));
+    });
+
+    cout << "Average gpa: rows " << [&] {
+        double total = 0.0;
+        for (size_t i = 0; i < rowStore.size(); ++i) total += rowStore[i].gpa;
+        return total / rows;
+    }() << ", columns " << columns.averageGpa() << "\n";
+    cout << "Students called 'Emma 42': " << columns.countName("Emma 42") << "\n\n";
+
+    int rc = bench::runAll(argc, argv);
+    remove(ROW_FILE.c_str());
+    remove(COLUMN_FILE.c_str());
+    return rc;
+}
+
+/*
+    What to expect:
+    - The column file is about 1/10 of the row file: names are
+      stored once each (8000 distinct) plus a 13-bit code per row,
+      ages in 4 bits, gpa in 4 bytes.
+    - avg_gpa/columns_simd is ~25x faster than avg_gpa/rows: it
+      reads 1/16 of the bytes and converts and adds 8 floats per
+      instruction (about half that speed with SSE2 only).
+    - avg_gpa/columns_scalar sits in between (~4x slower than the
+      SIMD scan): the bytes are few, but one float at a time.
+    - avg_age/columns and count_name/columns read a few bits per
+      row, one unaligned load each; they run 5-10x faster than
+      the row scans.
+*/
@@ -0,0 +1,342 @@
+/*
+    ==========================================================
+    append_log.h - GROUP-COMMIT APPEND LOG
+    ==========================================================
+    The append functions of 3_append_to_user_file.cpp.cpp and
+    4_menu_file_operations.cpp do, for every line:
+
+        ofstream file(filename, ios::app);   // open()
+        file << content << endl;             // write() + flush
+        file.close();                        // close()
+
+    That is three system calls per record, and nothing is on the
+    disk until the kernel decides to write it back.
+
+    `AppendLog` keeps one file descriptor open for its lifetime
+    and lets all threads share it:
+    1. `append(bytes)` copies the record into an in-memory batch
+       and returns a ticket; it does not touch the file.
+    2. `wait(ticket)` blocks until the record is committed. The
+       first waiter becomes the leader: it takes the whole batch,
+       writes it with one write() and, depending on the
+       durability mode, fdatasync()s it. Records appended
+       meanwhile form the next batch, written by the next leader:
+       the more appenders wait, the larger the batches ("group
+       commit"), so one write() and one fdatasync() are shared by
+       many records. No thread is woken up just to write.
+    3. `commit(bytes)` is append() followed by wait().
+
+    Durability:
+    - Durability::None       committed = handed to the kernel with
+                             write(); survives a crash of the
+                             program, not of the machine.
+    - Durability::Interval   committed = written; a background
+                             thread fdatasync()s every
+                             syncInterval if anything was written,
+                             bounding what a power failure can
+                             lose.
+    - Durability::EveryBatch committed = on the disk: a batch is
+                             acknowledged only after fdatasync().
+
+    API:
+    - `AppendLog log("app.log", {Durability::EveryBatch});`
+    - `log.commit("line\n");`            append and wait
+    - `auto t = log.append("line\n"); ... log.wait(t);`
+    - `log.flush();`                     everything written and synced
+    - `log.stats()`                      records, batches, syncs and
+                                         the commit latency histogram
+      `stats.latency.percentile(0.99)`   in nanoseconds
+
+    Key Concepts:
+    - The file is opened with O_APPEND: other writers (an
+      ofstream, another process) still append at the end.
+    - The commit latency of a record is measured from the start
+      of append() to the moment its batch is committed.
+    - An I/O error is rethrown (as
+      std::system_error) by every later append(), wait() and
+      commit().
+*/
+
+#ifndef APPEND_LOG_H
+#define APPEND_LOG_H
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace fastio {
+
+enum class Durability { None, Interval, EveryBatch };
+
+struct AppendLogOptions {
+    Durability durability = Durability::EveryBatch;
+    std::chrono::milliseconds syncInterval{10};  // Durability::Interval only
+    std::size_t maxBatchBytes = 1 << 20;         // append() commits beyond this
+};
+
+// Log-linear histogram of nanosecond values: 16 buckets per power of two,
+// so a percentile is accurate to about 6%, in a fixed 8 KiB.
+class LatencyHistogram {
+public:
+    void record(std::uint64_t ns) {
+        ++buckets_[bucketOf(ns)];
+        ++count_;
+        max_ = std::max(max_, ns);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (std::size_t i = 0; i < kBuckets; ++i) buckets_[i] += other.buckets_[i];
+        count_ += other.count_;
+        max_ = std::max(max_, other.max_);
+    }
+
+    // Smallest bucket bound below which a fraction q (0..1) of the values lie.
+    std::uint64_t percentile(double q) const {
+        if (count_ == 0) return 0;
+        std::uint64_t rank = static_cast<std::uint64_t>(q * static_cast<double>(count_));
+        rank = std::min(std::max<std::uint64_t>(rank, 1), count_);
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < kBuckets; ++i) {
+            seen += buckets_[i];
+            if (seen >= rank) return std::min(upperBound(i), max_);
+        }
+        return max_;
+    }
+
+    std::uint64_t count() const { return count_; }
+    std::uint64_t max() const { return max_; }
+
+private:
+    static constexpr std::size_t kBuckets = 61 * 16;
+
+    static std::size_t bucketOf(std::uint64_t v) {
+        if (v < 16) return static_cast<std::size_t>(v);
+        unsigned e = 63u - static_cast<unsigned>(__builtin_clzll(v));  // 4..63
+        return (e - 3) * 16 + ((v >> (e - 4)) & 15);
+    }
+
+    static std::uint64_t upperBound(std::size_t i) {
+        if (i < 16) return i;
+        unsigned e = static_cast<unsigned>(i / 16) + 3;
+        std::uint64_t base = std::uint64_t(1) << e;
+        std::uint64_t step = std::uint64_t(1) << (e - 4);
+        return base + (i % 16 + 1) * step - 1;
+    }
+
+    std::array<std::uint64_t, kBuckets> buckets_{};
+    std::uint64_t count_ = 0;
+    std::uint64_t max_ = 0;
+};
+
+class AppendLog {
+public:
+    using Ticket = std::uint64_t;
+
+    struct Stats {
+        std::uint64_t records = 0;
+        std::uint64_t batches = 0;
+        std::uint64_t syncs = 0;
+        std::uint64_t bytes = 0;
+        LatencyHistogram latency;
+    };
+
+    explicit AppendLog(const std::string& path, AppendLogOptions options = {})
+        : path_(path), options_(options) {
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd_ < 0) throwErrno("open");
+        if (options_.durability == Durability::Interval)
+            syncer_ = std::thread([this] { syncPeriodically(); });
+    }
+
+    AppendLog(const AppendLog&) = delete;
+    AppendLog& operator=(const AppendLog&) = delete;
+
+    // Commits every pending record, syncs unless Durability::None, closes.
+    ~AppendLog() {
+        try {
+            flush();
+        } catch (...) {
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        syncerWake_.notify_one();
+        if (syncer_.joinable()) syncer_.join();
+        ::close(fd_);
+    }
+
+    // Queues bytes (written verbatim: include the '\n') and returns the
+    // ticket to wait() for. Only touches the file when the batch is full.
+    Ticket append(std::string_view bytes) {
+        const Clock::time_point start = Clock::now();
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (error_) std::rethrow_exception(error_);
+        if (!pending_.started.empty() &&
+            pending_.bytes.size() + bytes.size() > options_.maxBatchBytes)
+            commitUpTo(lock, appended_);
+        pending_.bytes.insert(pending_.bytes.end(), bytes.begin(), bytes.end());
+        pending_.started.push_back(start);
+        return ++appended_;
+    }
+
+    // Blocks until the record with this ticket (and every earlier one) is
+    // committed.
+    void wait(Ticket ticket) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        commitUpTo(lock, ticket);
+    }
+
+    void commit(std::string_view bytes) { wait(append(bytes)); }
+
+    // Commits every record appended so far and, unless Durability::None,
+    // syncs the file: an explicit durability point.
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        commitUpTo(lock, appended_);
+        if (options_.durability == Durability::None) return;
+        lock.unlock();
+        if (::fdatasync(fd_) != 0) throwErrno("fdatasync");
+        lock.lock();
+        ++stats_.syncs;
+    }
+
+    Stats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Batch {
+        std::vector<char> bytes;
+        std::vector<Clock::time_point> started;  // one per record
+
+        void clear() {
+            bytes.clear();
+            started.clear();
+        }
+    };
+
+    [[noreturn]] void throwErrno(const char* what) const {
+        throw std::system_error(errno, std::generic_category(), std::string(what) + " " + path_);
+    }
+
+    void writeAll(const char* p, std::size_t n) {
+        while (n > 0) {
+            ssize_t w = ::write(fd_, p, n);
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                throwErrno("write");
+            }
+            p += w;
+            n -= static_cast<std::size_t>(w);
+        }
+    }
+
+    // Called with the lock held; returns once `ticket` is committed. If no
+    // batch is being written, this thread becomes the leader: it takes
+    // every pending record and writes them with one write() (and one
+    // fdatasync()). Otherwise it waits for the current leader, whose batch
+    // may already contain its record.
+    void commitUpTo(std::unique_lock<std::mutex>& lock, Ticket ticket) {
+        while (committed_ < ticket) {
+            if (error_) std::rethrow_exception(error_);
+            if (writing_) {
+                committedCv_.wait(lock);
+                continue;
+            }
+            writing_ = true;
+            std::swap(leaderBatch_, pending_);
+            const Ticket last = appended_;
+            lock.unlock();
+
+            std::exception_ptr error;
+            try {
+                writeAll(leaderBatch_.bytes.data(), leaderBatch_.bytes.size());
+                if (options_.durability == Durability::EveryBatch && ::fdatasync(fd_) != 0)
+                    throwErrno("fdatasync");
+            } catch (...) {
+                error = std::current_exception();
+            }
+            const Clock::time_point done = Clock::now();
+
+            lock.lock();
+            writing_ = false;
+            if (error) {
+                error_ = error;
+            } else {
+                committed_ = last;
+                dirty_ = true;
+                ++stats_.batches;
+                stats_.syncs += options_.durability == Durability::EveryBatch;
+                stats_.records += leaderBatch_.started.size();
+                stats_.bytes += leaderBatch_.bytes.size();
+                for (Clock::time_point t : leaderBatch_.started)
+                    stats_.latency.record(static_cast<std::uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(done - t).count()));
+            }
+            leaderBatch_.clear();
+            committedCv_.notify_all();
+        }
+    }
+
+    // Durability::Interval: syncs whatever was written in the last interval.
+    void syncPeriodically() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            syncerWake_.wait_for(lock, options_.syncInterval);
+            if (!dirty_ || error_) continue;
+            dirty_ = false;
+            lock.unlock();
+            int rc = ::fdatasync(fd_);
+            int err = errno;
+            lock.lock();
+            if (rc != 0) {
+                error_ = std::make_exception_ptr(
+                    std::system_error(err, std::generic_category(), "fdatasync " + path_));
+                committedCv_.notify_all();
+            } else {
+                ++stats_.syncs;
+            }
+        }
+    }
+
+    std::string path_;
+    AppendLogOptions options_;
+    int fd_ = -1;
+
+    mutable std::mutex mutex_;
+    std::condition_variable committedCv_;  // committed_ advanced, or error_ set
+    std::condition_variable syncerWake_;    // stopping_ set
+    Batch pending_;                         // appended, not yet taken by a leader
+    Batch leaderBatch_;                     // owned by the leader while writing_
+    bool writing_ = false;
+    Ticket appended_ = 0;
+    Ticket committed_ = 0;
+    bool dirty_ = false;                    // written since the last sync
+    bool stopping_ = false;
+    std::exception_ptr error_;
+    Stats stats_;
+
+    std::thread syncer_;
+};
+
+}  // namespace fastio
+
+#endif  // APPEND_LOG_H
@@ -0,0 +1,671 @@
+/*
+    ==========================================================
+    async_io.h - ASYNCHRONOUS FILE I/O WITH io_uring
+    ==========================================================
+    Every file access in this folder blocks: `readFile()` waits
+    for the disk, then the next file is opened. A disk (NVMe in
+    particular) serves many requests in parallel, but a program
+    that issues one at a time keeps a single request in flight.
+
+    `AsyncIo` queues reads and writes and completes them in the
+    background, so thousands can be in flight at once:
+    - On Linux 5.7+ it uses io_uring: requests are written into a
+      ring shared with the kernel, and one io_uring_enter() call
+      submits a whole batch and waits for completions. A single
+      completion thread owns the ring; it submits up to
+      `queueDepth` requests at a time and runs the callbacks.
+    - Where io_uring is unavailable (older kernel, seccomp,
+      containers that disable it), `threads` worker threads do
+      blocking pread()/pwrite() instead: same API, same results.
+
+    API:
+    - `AsyncIo io;`                            io_uring if possible
+      `AsyncIo io({IoBackend::ThreadPool});`   force the fallback
+    - `io.read(fd, buf, n, offset, cb)`        cb(long result) runs on
+      `io.write(fd, buf, n, offset, cb)`       the completion thread;
+                                               result = bytes or -errno
+    - `std::future<long> f = io.read(fd, buf, n, offset);`
+    - `io.drain();`                            wait for everything
+    - Registered buffers: pass them in `options.buffers`, then
+      `io.read(fd, buf, n, offset, cb, bufferIndex)`: the kernel
+      skips mapping the pages on every request.
+
+    File helpers (open() itself is synchronous):
+    - `readFileAsync(io, path)`                future<std::string>
+    - `overwriteFileAsync(io, path, text)`     future<void>
+    - `readStudentsAsync(io, path, first, count)`
+                                               future<vector<Student>>
+                                               (student_store.h format)
+
+    Key Concepts:
+    - Like pread(), a single read() may transfer fewer bytes than
+      asked; the file helpers continue until the end.
+    - Callbacks must not block: they run on the thread that reaps
+      completions. They may queue further requests.
+    - Requests beyond queueDepth wait in a user-space queue, so
+      read() and write() never block.
+    - If io_uring_enter() itself fails, the ring is closed and every
+      request in flight, queued, or queued later completes with that
+      error (-errno), so drain() still returns.
+*/
+
+#ifndef ASYNC_IO_H
+#define ASYNC_IO_H
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "student_store.h"
+
+namespace fastio {
+
+namespace asyncio {
+
+// The raw io_uring interface (liburing is not required): the submission
+// and completion rings are mapped from the kernel and indexed with
+// head/tail counters. Only the completion thread touches a Ring.
+class Ring {
+public:
+    // Returns false if io_uring is not available.
+    bool open(unsigned entries, const std::vector<iovec>& buffers) {
+        io_uring_params p = {};
+        int fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+        if (fd < 0) return false;
+        // IORING_OP_READ/WRITE need 5.6; FAST_POLL marks 5.7.
+        if (!(p.features & IORING_FEAT_FAST_POLL)) {
+            ::close(fd);
+            return false;
+        }
+        fd_ = fd;
+        sqLen_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cqLen_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        const bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) sqLen_ = cqLen_ = std::max(sqLen_, cqLen_);
+        sq_ = map(sqLen_, IORING_OFF_SQ_RING);
+        cq_ = single ? sq_ : map(cqLen_, IORING_OFF_CQ_RING);
+        sqesLen_ = p.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(map(sqesLen_, IORING_OFF_SQES));
+        if (!sq_ || !cq_ || !sqes_) {
+            close();
+            return false;
+        }
+
+        char* sq = static_cast<char*>(sq_);
+        char* cq = static_cast<char*>(cq_);
+        sqTail_ = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        sqMask_ = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        sqArray_ = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        sqEntries_ = p.sq_entries;
+        cqHead_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        cqMask_ = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+
+        if (!buffers.empty() &&
+            ::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_BUFFERS, buffers.data(),
+                      static_cast<unsigned>(buffers.size())) < 0) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    ~Ring() { close(); }
+
+    // Unmaps the rings and closes the io_uring fd; the kernel cancels the
+    // requests still in flight. Safe to call twice.
+    void close() {
+        if (sqes_) ::munmap(sqes_, sqesLen_);
+        if (cq_ && cq_ != sq_) ::munmap(cq_, cqLen_);
+        if (sq_) ::munmap(sq_, sqLen_);
+        if (fd_ >= 0) ::close(fd_);
+        sq_ = cq_ = nullptr;
+        sqes_ = nullptr;
+        fd_ = -1;
+    }
+
+    unsigned entries() const { return sqEntries_; }
+
+    // Fills the next submission entry; enter() hands it to the kernel.
+    io_uring_sqe* next() {
+        unsigned tail = *sqTail_ + unsubmitted_;
+        unsigned index = tail & sqMask_;
+        io_uring_sqe* sqe = &sqes_[index];
+        *sqe = {};
+        sqArray_[index] = index;
+        ++unsubmitted_;
+        return sqe;
+    }
+
+    // Submits the queued entries and waits for at least minComplete
+    // completions, in one system call. Returns -errno on failure.
+    int enter(unsigned minComplete) {
+        __atomic_store_n(sqTail_, *sqTail_ + unsubmitted_, __ATOMIC_RELEASE);
+        unsigned toSubmit = unsubmitted_;
+        unsubmitted_ = 0;
+        for (;;) {
+            long r = ::syscall(__NR_io_uring_enter, fd_, toSubmit, minComplete,
+                               minComplete ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            if (r >= 0) return 0;
+            if (errno != EINTR) return -errno;
+            toSubmit = 0;  // interrupted while waiting: the entries are in
+        }
+    }
+
+    // Calls f(user_data, res) for every completion available.
+    template <class F>
+    void reap(F&& f) {
+        unsigned head = *cqHead_;
+        unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = cqes_[head & cqMask_];
+            f(cqe.user_data, cqe.res);
+        }
+        __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+    }
+
+private:
+    void* map(std::size_t len, off_t offset) {
+        void* p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                         offset);
+        return p == MAP_FAILED ? nullptr : p;
+    }
+
+    int fd_ = -1;
+    void* sq_ = nullptr;
+    void* cq_ = nullptr;
+    io_uring_sqe* sqes_ = nullptr;
+    std::size_t sqLen_ = 0, cqLen_ = 0, sqesLen_ = 0;
+    unsigned* sqTail_ = nullptr;
+    unsigned* sqArray_ = nullptr;
+    unsigned sqMask_ = 0, sqEntries_ = 0;
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned unsubmitted_ = 0;
+};
+
+}  // namespace asyncio
+
+enum class IoBackend { Auto, IoUring, ThreadPool };
+
+struct AsyncIoOptions {
+    IoBackend backend = IoBackend::Auto;
+    unsigned queueDepth = 128;   // requests in flight (io_uring)
+    unsigned threads = 8;        // worker threads (fallback)
+    std::vector<iovec> buffers;  // registered buffers (io_uring)
+};
+
+class AsyncIo {
+public:
+    using Callback = std::function<void(long result)>;  // bytes, or -errno
+
+    struct Stats {
+        std::uint64_t requests = 0;
+        std::uint64_t submits = 0;  // io_uring_enter() calls that submitted
+    };
+
+    explicit AsyncIo(AsyncIoOptions options = {}) : options_(std::move(options)) {
+        if (options_.backend != IoBackend::ThreadPool &&
+            ring_.open(std::max(options_.queueDepth, 2u), options_.buffers)) {
+            backend_ = IoBackend::IoUring;
+            wakeFd_ = ::eventfd(0, EFD_CLOEXEC);
+            if (wakeFd_ < 0)
+                throw std::system_error(errno, std::generic_category(), "eventfd");
+            workers_.emplace_back([this] { runRing(); });
+            return;
+        }
+        if (options_.backend == IoBackend::IoUring)
+            throw std::system_error(ENOSYS, std::generic_category(), "io_uring_setup");
+        backend_ = IoBackend::ThreadPool;
+        for (unsigned i = 0; i < std::max(options_.threads, 1u); ++i)
+            workers_.emplace_back([this] { runWorker(); });
+    }
+
+    AsyncIo(const AsyncIo&) = delete;
+    AsyncIo& operator=(const AsyncIo&) = delete;
+
+    // Completes every queued request, then stops.
+    ~AsyncIo() {
+        drain();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake();
+        work_.notify_all();
+        for (std::thread& t : workers_) t.join();
+        if (wakeFd_ >= 0) ::close(wakeFd_);
+    }
+
+    IoBackend backend() const { return backend_; }
+
+    void read(int fd, void* buf, std::size_t n, off_t offset, Callback done,
+              int bufferIndex = -1) {
+        submit({IORING_OP_READ, fd, buf, n, offset, bufferIndex, std::move(done)});
+    }
+
+    void write(int fd, const void* buf, std::size_t n, off_t offset, Callback done,
+               int bufferIndex = -1) {
+        submit({IORING_OP_WRITE, fd, const_cast<void*>(buf), n, offset, bufferIndex,
+                std::move(done)});
+    }
+
+    std::future<long> read(int fd, void* buf, std::size_t n, off_t offset) {
+        auto promise = std::make_shared<std::promise<long>>();
+        std::future<long> f = promise->get_future();
+        read(fd, buf, n, offset, [promise](long r) { promise->set_value(r); });
+        return f;
+    }
+
+    std::future<long> write(int fd, const void* buf, std::size_t n, off_t offset) {
+        auto promise = std::make_shared<std::promise<long>>();
+        std::future<long> f = promise->get_future();
+        write(fd, buf, n, offset, [promise](long r) { promise->set_value(r); });
+        return f;
+    }
+
+    // Blocks until every request queued so far, and every request their
+    // callbacks queued, has completed.
+    void drain() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [this] { return outstanding_ == 0; });
+    }
+
+    Stats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    struct Request {
+        std::uint8_t op;  // IORING_OP_READ or IORING_OP_WRITE
+        int fd;
+        void* buf;
+        std::size_t len;
+        off_t offset;
+        int bufferIndex;
+        Callback done;
+    };
+
+    static constexpr std::uint64_t kWakeTag = 0;
+
+    void submit(Request request) {
+        bool wakeRing;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(std::make_unique<Request>(std::move(request)));
+            ++outstanding_;
+            ++stats_.requests;
+            wakeRing = ringSleeping_;
+            ringSleeping_ = false;
+        }
+        if (backend_ == IoBackend::IoUring && wakeRing) wake();
+        // Thread pool, or a ring that failed: runRing() waits on work_.
+        work_.notify_one();
+    }
+
+    void wake() {
+        if (wakeFd_ < 0) return;
+        std::uint64_t one = 1;
+        while (::write(wakeFd_, &one, sizeof(one)) < 0 && errno == EINTR) {
+        }
+    }
+
+    void finish(Request& request, long result) {
+        request.done(result);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--outstanding_ == 0) idle_.notify_all();
+    }
+
+    // io_uring backend: the only thread that touches the ring. Each loop
+    // moves queued requests into free ring slots and submits them together
+    // with waiting for completions, in one io_uring_enter(). An eventfd read
+    // stays queued in the ring so that submit() can wake the loop up; it
+    // reads into wakeValue_, which outlives the ring.
+    void runRing() {
+        const unsigned depth = ring_.entries() - 1;  // one slot for the eventfd read
+        std::unordered_set<Request*> inFlight;
+        bool wakeArmed = false;
+        std::vector<std::unique_ptr<Request>> batch;
+
+        for (;;) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (stopping_ && queue_.empty() && inFlight.empty()) return;
+                while (!queue_.empty() && inFlight.size() + batch.size() < depth) {
+                    batch.push_back(std::move(queue_.front()));
+                    queue_.pop_front();
+                }
+                if (!batch.empty()) ++stats_.submits;
+                // enter() below sleeps until a completion: unless requests are
+                // still waiting for a free slot, a new request must wake us.
+                ringSleeping_ = queue_.empty();
+            }
+            for (std::unique_ptr<Request>& r : batch) {
+                io_uring_sqe* sqe = ring_.next();
+                const bool fixed = r->bufferIndex >= 0;
+                std::uint8_t op = r->op;
+                if (fixed) op = op == IORING_OP_READ ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+                sqe->opcode = op;
+                sqe->fd = r->fd;
+                sqe->addr = reinterpret_cast<std::uint64_t>(r->buf);
+                sqe->len = static_cast<std::uint32_t>(std::min<std::size_t>(r->len, 1u << 30));
+                sqe->off = static_cast<std::uint64_t>(r->offset);
+                if (fixed) sqe->buf_index = static_cast<std::uint16_t>(r->bufferIndex);
+                inFlight.insert(r.get());
+                sqe->user_data = reinterpret_cast<std::uint64_t>(r.release());
+            }
+            batch.clear();
+            if (!wakeArmed) {
+                io_uring_sqe* sqe = ring_.next();
+                sqe->opcode = IORING_OP_READ;
+                sqe->fd = wakeFd_;
+                sqe->addr = reinterpret_cast<std::uint64_t>(&wakeValue_);
+                sqe->len = sizeof(wakeValue_);
+                sqe->user_data = kWakeTag;
+                wakeArmed = true;
+            }
+
+            int rc = ring_.enter(1);
+            ring_.reap([&](std::uint64_t tag, int res) {
+                if (tag == kWakeTag) {
+                    wakeArmed = false;
+                    return;
+                }
+                std::unique_ptr<Request> r(reinterpret_cast<Request*>(tag));
+                inFlight.erase(r.get());
+                finish(*r, res);
+            });
+            if (rc < 0 && rc != -EBUSY) return failRing(rc, inFlight);
+        }
+    }
+
+    // The ring itself failed (not a single request). Closing it cancels
+    // what the kernel still holds; those requests, and every request queued
+    // now or later, complete with the error until the destructor stops us.
+    void failRing(int error, std::unordered_set<Request*>& inFlight) {
+        ring_.close();
+        for (Request* request : inFlight) {
+            std::unique_ptr<Request> r(request);
+            finish(*r, error);
+        }
+        inFlight.clear();
+        for (;;) {
+            std::deque<std::unique_ptr<Request>> failed;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                work_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+                if (queue_.empty()) return;
+                failed.swap(queue_);
+            }
+            for (std::unique_ptr<Request>& r : failed) finish(*r, error);
+        }
+    }
+
+    // Thread-pool backend: blocking pread()/pwrite(), same results.
+    void runWorker() {
+        for (;;) {
+            std::unique_ptr<Request> r;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                work_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+                if (queue_.empty()) return;
+                r = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            ssize_t n;
+            do {
+                n = r->op == IORING_OP_READ ? ::pread(r->fd, r->buf, r->len, r->offset)
+                                            : ::pwrite(r->fd, r->buf, r->len, r->offset);
+            } while (n < 0 && errno == EINTR);
+            finish(*r, n < 0 ? -errno : static_cast<long>(n));
+        }
+    }
+
+    AsyncIoOptions options_;
+    IoBackend backend_ = IoBackend::ThreadPool;
+    std::uint64_t wakeValue_ = 0;  // target of the eventfd read; declared before ring_
+    asyncio::Ring ring_;
+    int wakeFd_ = -1;
+
+    mutable std::mutex mutex_;
+    std::condition_variable work_;  // queue_ not empty, or stop (thread pool, failed ring)
+    std::condition_variable idle_;  // outstanding_ dropped to 0
+    std::deque<std::unique_ptr<Request>> queue_;
+    std::size_t outstanding_ = 0;   // queued + in flight
+    bool ringSleeping_ = false;
+    bool stopping_ = false;
+    Stats stats_;
+
+    std::vector<std::thread> workers_;
+};
+
+// ==========================================================
+// Asynchronous versions of the file operations of this folder
+// ==========================================================
+
+namespace asyncio {
+
+[[noreturn]] inline void throwErrno(int error, const char* what, const std::string& path) {
+    throw std::system_error(error, std::generic_category(), std::string(what) + " " + path);
+}
+
+inline std::exception_ptr errnoException(long result, const char* what, const std::string& path) {
+    return std::make_exception_ptr(std::system_error(static_cast<int>(-result),
+                                                     std::generic_category(),
+                                                     std::string(what) + " " + path));
+}
+
+// Reads from fd until `data` is full (or, if `grow`, until end of file),
+// then closes fd and fulfils the promise.
+struct ReadAll : std::enable_shared_from_this<ReadAll> {
+    AsyncIo& io;
+    int fd;
+    std::string path;
+    std::string data;
+    std::size_t done = 0;
+    bool grow;
+    std::promise<std::string> promise;
+
+    ReadAll(AsyncIo& io, int fd, std::string path, std::size_t size, bool grow)
+        : io(io), fd(fd), path(std::move(path)), data(size, '\0'), grow(grow) {}
+
+    void next() {
+        auto self = shared_from_this();
+        io.read(fd, &data[done], data.size() - done, static_cast<off_t>(done),
+                [self](long r) { self->completed(r); });
+    }
+
+    void completed(long r) {
+        if (r < 0) {
+            ::close(fd);
+            promise.set_exception(errnoException(r, "read", path));
+            return;
+        }
+        done += static_cast<std::size_t>(r);
+        if (r > 0 && done < data.size()) return next();
+        if (r > 0 && grow) {
+            data.resize(data.size() * 2);
+            return next();
+        }
+        ::close(fd);
+        data.resize(done);
+        promise.set_value(std::move(data));
+    }
+};
+
+// Writes all of `data` to fd, then closes it and fulfils the promise.
+struct WriteAll : std::enable_shared_from_this<WriteAll> {
+    AsyncIo& io;
+    int fd;
+    std::string path;
+    std::string data;
+    std::size_t done = 0;
+    std::promise<void> promise;
+
+    WriteAll(AsyncIo& io, int fd, std::string path, std::string data)
+        : io(io), fd(fd), path(std::move(path)), data(std::move(data)) {}
+
+    void next() {
+        auto self = shared_from_this();
+        io.write(fd, data.data() + done, data.size() - done, static_cast<off_t>(done),
+                 [self](long r) { self->completed(r); });
+    }
+
+    void completed(long r) {
+        if (r <= 0) {
+            ::close(fd);
+            promise.set_exception(errnoException(r < 0 ? r : -EIO, "write", path));
+            return;
+        }
+        done += static_cast<std::size_t>(r);
+        if (done < data.size()) return next();
+        if (::close(fd) != 0)
+            promise.set_exception(errnoException(-errno, "close", path));
+        else
+            promise.set_value();
+    }
+};
+
+}  // namespace asyncio
+
+// Asynchronous readFile(): the whole file as a string.
+inline std::future<std::string> readFileAsync(AsyncIo& io, const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) asyncio::throwErrno(errno, "open", path);
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        int error = errno;
+        ::close(fd);
+        asyncio::throwErrno(error, "fstat", path);
+    }
+    // Files that report no size (/proc, pipes) are read until end of file.
+    const bool sizeKnown = st.st_size > 0;
+    auto state = std::make_shared<asyncio::ReadAll>(
+        io, fd, path, sizeKnown ? static_cast<std::size_t>(st.st_size) : 4096, !sizeKnown);
+    std::future<std::string> f = state->promise.get_future();
+    state->next();
+    return f;
+}
+
+// Asynchronous overwriteFile(): replaces the contents of path with text.
+inline std::future<void> overwriteFileAsync(AsyncIo& io, const std::string& path,
+                                            std::string text) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) asyncio::throwErrno(errno, "open", path);
+    auto state = std::make_shared<asyncio::WriteAll>(io, fd, path, std::move(text));
+    std::future<void> f = state->promise.get_future();
+    if (state->data.empty()) {
+        ::close(fd);
+        state->promise.set_value();
+    } else {
+        state->next();
+    }
+    return f;
+}
+
+// Asynchronous read of `count` records starting at record `first` of a
+// student_store.h file. The header and the records are read in parallel;
+// a bad header or a range past the end throws from get().
+inline std::future<std::vector<Student>> readStudentsAsync(AsyncIo& io,
+                                                           const std::string& path,
+                                                           std::uint64_t first, std::size_t count) {
+    using namespace studentfile;
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) asyncio::throwErrno(errno, "open", path);
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        int error = errno;
+        ::close(fd);
+        asyncio::throwErrno(error, "fstat", path);
+    }
+
+    struct State {
+        int fd;
+        std::string path;
+        std::uint64_t fileSize, first;
+        std::size_t count;
+        unsigned char header[kHeaderSize] = {};
+        std::vector<unsigned char> records;
+        std::size_t recordBytes = 0;  // read, may be short
+        std::atomic<int> pending{2};
+        std::atomic<long> error{0};
+        std::promise<std::vector<Student>> promise;
+
+        void completed(long r, bool isRecords) {
+            if (r < 0) {
+                long none = 0;
+                error.compare_exchange_strong(none, r);
+            } else if (isRecords) {
+                recordBytes = static_cast<std::size_t>(r);
+            }
+            if (--pending > 0) return;
+            ::close(fd);
+            if (error) {
+                promise.set_exception(asyncio::errnoException(error, "read", path));
+                return;
+            }
+            try {
+                std::uint64_t stored = checkHeader(header, fileSize, path);
+                if (first > stored || count > stored - first)
+                    throw std::out_of_range(path + ": records " + std::to_string(first) +
+                                            ".." + std::to_string(first + count) + " of " +
+                                            std::to_string(stored));
+                if (recordBytes < records.size())
+                    throw std::runtime_error(path + ": truncated while reading");
+                std::vector<Student> out(count);
+                for (std::size_t i = 0; i < count; ++i)
+                    out[i] = decode(records.data() + i * kRecordSize);
+                promise.set_value(std::move(out));
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+        }
+    };
+
+    auto state = std::make_shared<State>();
+    state->fd = fd;
+    state->path = path;
+    state->fileSize = static_cast<std::uint64_t>(st.st_size);
+    state->first = first;
+    state->count = count;
+    state->records.resize(count * kRecordSize);
+    std::future<std::vector<Student>> f = state->promise.get_future();
+    io.read(fd, state->header, kHeaderSize, 0,
+            [state](long r) { state->completed(r, false); });
+    io.read(fd, state->records.data(), state->records.size(),
+            static_cast<off_t>(kHeaderSize + first * kRecordSize),
+            [state](long r) { state->completed(r, true); });
+    return f;
+}
+
+}  // namespace fastio
+
+#endif  // ASYNC_IO_H
@@ -0,0 +1,515 @@
+/*
+    ==========================================================
+    async_logger.h - ASYNCHRONOUS COLOURED CONSOLE LOGGER
+    ==========================================================
+    The helpers of color_helper_functions.cpp print every
+    message with
+
+        std::cout << GREEN << message << RESET << std::endl;
+
+    so each call formats on the calling thread, takes the
+    stream's lock and, because of std::endl, makes a write()
+    system call. With many threads logging, they all queue up on
+    that one stream.
+
+    `AsyncLogger` moves the output off the logging threads:
+    1. Every thread gets its own ring buffer the first time it
+       logs. log() copies the text plus a 16-byte header
+       (timestamp, severity, colour) into it: no lock, no system
+       call, no string concatenation. Only the owning thread
+       writes to a ring and only the flusher reads from it, so
+       two atomic positions are enough (single producer, single
+       consumer).
+    2. One background flusher thread collects the records of all
+       rings, orders them by timestamp, adds the colour escape
+       codes and the newline, and hands the whole batch to the
+       file descriptor with one write().
+    3. The flusher sleeps while nothing is logged. While records
+       keep arriving it wakes every flushInterval, or at once
+       when a ring is half full.
+
+    Memory is bounded: ringBytes per thread that has logged. When
+    a ring is full, OverflowPolicy decides:
+    - Block   log() waits for the flusher (nothing is lost; a
+              slow terminal slows the logging threads down).
+    - Drop    log() discards the record and returns false; the
+              flusher prints "[N messages dropped]" in its place.
+
+    API:
+    - `AsyncLogger logger;`                      stdout, Block
+    - `logger.log(Severity::Error, "disk full");` red line
+    - `logger.log(Severity::Info, Color::Cyan, text);`
+    - `logger.flush();`   returns once everything logged before
+                          it (by this thread) is written
+    - `logger.stats()`    records, dropped, batches, writes
+    - `consoleLogger()`   a process-wide logger for stdout
+
+    Key Concepts:
+    - Severity::Prompt prints no newline. A prompt must be on the
+      screen before the program reads the answer, so call
+      flush() after it.
+    - Records of one thread keep their order. Records of
+      different threads are ordered by their timestamps within a
+      batch.
+    - A record is at most ringBytes / 2 long; longer text is cut.
+    - The destructor writes every record still queued. Output
+      from cout/printf on the same descriptor is not ordered
+      with the logger's: flush one before using the other.
+    - A failed write() drops its batch and is counted in
+      stats().writeErrors; logging never throws.
+*/
+
+#ifndef ASYNC_LOGGER_H
+#define ASYNC_LOGGER_H
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace fastio {
+
+enum class Severity : std::uint8_t { Prompt, Info, Success, Warning, Error };
+enum class Color : std::uint8_t { Default, Red, Green, Yellow, Cyan };
+enum class OverflowPolicy { Block, Drop };
+
+struct AsyncLoggerOptions {
+    int fd = STDOUT_FILENO;                      // not closed by the logger
+    std::size_t ringBytes = 64 * 1024;           // per thread, rounded up to a power of two
+    OverflowPolicy overflow = OverflowPolicy::Block;
+    std::chrono::milliseconds flushInterval{5};  // batching delay while records arrive
+    bool colors = true;                          // emit ANSI escape codes
+};
+
+inline Color defaultColor(Severity severity) {
+    switch (severity) {
+        case Severity::Prompt: return Color::Cyan;
+        case Severity::Success: return Color::Green;
+        case Severity::Warning: return Color::Yellow;
+        case Severity::Error: return Color::Red;
+        default: return Color::Default;
+    }
+}
+
+class AsyncLogger {
+public:
+    struct Stats {
+        std::uint64_t records = 0;      // written
+        std::uint64_t dropped = 0;      // OverflowPolicy::Drop
+        std::uint64_t batches = 0;
+        std::uint64_t writes = 0;       // write() system calls
+        std::uint64_t bytes = 0;
+        std::uint64_t writeErrors = 0;
+    };
+
+    explicit AsyncLogger(AsyncLoggerOptions options = {})
+        : options_(options), id_(nextLoggerId()) {
+        std::size_t capacity = 256;
+        while (capacity < options_.ringBytes) capacity *= 2;
+        options_.ringBytes = capacity;
+        flusher_ = std::thread([this] { run(); });
+    }
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    // Writes every queued record, then stops the flusher. No thread may
+    // log while (or after) the logger is destroyed.
+    ~AsyncLogger() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wakeCv_.notify_one();
+        flusher_.join();
+        for (const std::shared_ptr<Ring>& ring : rings_)
+            ring->loggerGone.store(true, std::memory_order_release);
+    }
+
+    bool log(Severity severity, std::string_view text) {
+        return log(severity, defaultColor(severity), text);
+    }
+
+    // Queues one record. Returns false if it was dropped (ring full under
+    // OverflowPolicy::Drop).
+    bool log(Severity severity, Color color, std::string_view text) {
+        Ring& ring = ringOfThisThread();
+        const std::size_t maxText = options_.ringBytes / 2 - sizeof(RecordHeader);
+        if (text.size() > maxText) text = text.substr(0, maxText);
+
+        RecordHeader header;
+        header.time = static_cast<std::uint64_t>(Clock::now().time_since_epoch().count());
+        header.length = static_cast<std::uint32_t>(text.size());
+        header.severity = severity;
+        header.color = color;
+
+        while (!tryPush(ring, header, text)) {
+            if (options_.overflow == OverflowPolicy::Drop) {
+                ring.dropped.store(ring.dropped.load(std::memory_order_relaxed) + 1,
+                                   std::memory_order_relaxed);
+                return false;
+            }
+            waitForSpace();
+        }
+
+        // Pairs with the fence in run(): either the flusher sees the new
+        // tail, or this thread sees that it went idle and wakes it.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (idle_.load(std::memory_order_relaxed)) {
+            wake();
+        } else if (halfFull(ring) && !urgent_.load(std::memory_order_relaxed) &&
+                   !urgent_.exchange(true)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            wakeCv_.notify_one();
+        }
+        return true;
+    }
+
+    // Blocks until every record logged before the call, by this thread or
+    // by threads it synchronised with, has been written.
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const std::uint64_t request = ++flushRequested_;
+        idle_.store(false, std::memory_order_relaxed);
+        wakeCv_.notify_one();
+        flushedCv_.wait(lock, [&] { return flushDone_ >= request; });
+    }
+
+    Stats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct RecordHeader {
+        std::uint64_t time;    // Clock ticks
+        std::uint32_t length;  // bytes of text; kPadding: skip to the end of the ring
+        Severity severity;
+        Color color;
+        std::uint8_t unused[2] = {};
+    };
+    static_assert(sizeof(RecordHeader) == 16, "records are 16-byte aligned");
+    static constexpr std::uint32_t kPadding = 0xFFFFFFFF;
+
+    static std::size_t recordSize(std::size_t textBytes) {
+        return (sizeof(RecordHeader) + textBytes + 15) & ~std::size_t(15);
+    }
+
+    // Single-producer single-consumer byte ring. Positions only grow; the
+    // offset in data is position & mask.
+    struct Ring {
+        explicit Ring(std::size_t capacity) : data(new char[capacity]), mask(capacity - 1) {}
+
+        alignas(64) std::atomic<std::uint64_t> tail{0};  // written by the owning thread
+        std::uint64_t cachedHead = 0;                     // owner's last view of head
+        std::atomic<std::uint64_t> dropped{0};            // written by the owning thread
+        alignas(64) std::atomic<std::uint64_t> head{0};  // written by the flusher
+        std::uint64_t reportedDropped = 0;                // flusher only
+        std::atomic<bool> closed{false};                  // the owning thread has exited
+        std::atomic<bool> loggerGone{false};              // the logger was destroyed
+        std::unique_ptr<char[]> data;
+        std::size_t mask;
+    };
+
+    // The rings of the calling thread, one per logger it has used. Marks
+    // them closed when the thread exits so the flusher can release them.
+    struct ThreadRings {
+        std::vector<std::pair<std::uint64_t, std::shared_ptr<Ring>>> rings;
+
+        ~ThreadRings() {
+            for (auto& entry : rings) entry.second->closed.store(true, std::memory_order_release);
+        }
+    };
+
+    static std::uint64_t nextLoggerId() {
+        static std::atomic<std::uint64_t> next{1};
+        return next++;
+    }
+
+    static ThreadRings& threadRings() {
+        thread_local ThreadRings rings;
+        return rings;
+    }
+
+    Ring& ringOfThisThread() {
+        ThreadRings& mine = threadRings();
+        for (auto& entry : mine.rings)
+            if (entry.first == id_) return *entry.second;
+
+        // First record of this thread: forget rings of destroyed loggers,
+        // then register a new one with the flusher.
+        mine.rings.erase(std::remove_if(mine.rings.begin(), mine.rings.end(),
+                                        [](const auto& entry) {
+                                            return entry.second->loggerGone.load(
+                                                std::memory_order_acquire);
+                                        }),
+                         mine.rings.end());
+        auto ring = std::make_shared<Ring>(options_.ringBytes);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            rings_.push_back(ring);
+        }
+        mine.rings.emplace_back(id_, ring);
+        return *ring;
+    }
+
+    // Owning thread only.
+    bool tryPush(Ring& ring, const RecordHeader& header, std::string_view text) {
+        const std::size_t capacity = ring.mask + 1;
+        const std::size_t size = recordSize(text.size());
+        std::uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+        std::size_t offset = static_cast<std::size_t>(tail & ring.mask);
+        const std::size_t toEnd = capacity - offset;
+        const std::size_t needed = size <= toEnd ? size : toEnd + size;  // records never wrap
+        if (tail + needed - ring.cachedHead > capacity) {
+            ring.cachedHead = ring.head.load(std::memory_order_acquire);
+            if (tail + needed - ring.cachedHead > capacity) return false;
+        }
+        if (size > toEnd) {
+            std::memcpy(ring.data.get() + offset + offsetof(RecordHeader, length), &kPadding,
+                        sizeof(kPadding));
+            tail += toEnd;
+            offset = 0;
+        }
+        std::memcpy(ring.data.get() + offset, &header, sizeof(header));
+        if (!text.empty())
+            std::memcpy(ring.data.get() + offset + sizeof(header), text.data(), text.size());
+        ring.tail.store(tail + size, std::memory_order_release);
+        return true;
+    }
+
+    // Owning thread only. Reads head (the flusher's cache line) only when the
+    // cached value says the ring might be half full.
+    bool halfFull(Ring& ring) const {
+        const std::uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+        const std::size_t half = options_.ringBytes / 2;
+        if (tail - ring.cachedHead <= half) return false;
+        ring.cachedHead = ring.head.load(std::memory_order_acquire);
+        return tail - ring.cachedHead > half;
+    }
+
+    void wake() {
+        if (idle_.exchange(false)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            wakeCv_.notify_one();
+        }
+    }
+
+    // OverflowPolicy::Block: the ring is full; wait for the next pass.
+    void waitForSpace() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        urgent_.store(true, std::memory_order_relaxed);
+        idle_.store(false, std::memory_order_relaxed);
+        wakeCv_.notify_one();
+        ++blocked_;
+        const std::uint64_t pass = passes_;
+        spaceCv_.wait_for(lock, std::chrono::milliseconds(1), [&] { return passes_ != pass; });
+        --blocked_;
+    }
+
+    struct Entry {
+        std::uint64_t time;
+        const char* record;
+    };
+
+    static bool hasRecords(const Ring& ring) {
+        return ring.tail.load(std::memory_order_acquire) !=
+               ring.head.load(std::memory_order_relaxed);
+    }
+
+    // One pass: everything queued in `rings` right now goes out in one
+    // batch. Flusher thread only.
+    Stats drain(const std::vector<std::shared_ptr<Ring>>& rings) {
+        Stats pass;
+        entries_.clear();
+        ends_.resize(rings.size());
+        std::string dropNotes;
+        for (std::size_t i = 0; i < rings.size(); ++i) {
+            Ring& ring = *rings[i];
+            const std::size_t capacity = ring.mask + 1;
+            const std::uint64_t end = ring.tail.load(std::memory_order_acquire);
+            std::uint64_t pos = ring.head.load(std::memory_order_relaxed);
+            while (pos != end) {
+                const char* record = ring.data.get() + (pos & ring.mask);
+                RecordHeader header;
+                std::memcpy(&header, record, sizeof(header));
+                if (header.length == kPadding) {
+                    pos += capacity - (pos & ring.mask);
+                    continue;
+                }
+                entries_.push_back({header.time, record});
+                pos += recordSize(header.length);
+            }
+            ends_[i] = end;
+
+            const std::uint64_t dropped = ring.dropped.load(std::memory_order_relaxed);
+            if (dropped != ring.reportedDropped) {
+                dropNotes += "[" + std::to_string(dropped - ring.reportedDropped) +
+                             " messages dropped]\n";
+                pass.dropped += dropped - ring.reportedDropped;
+                ring.reportedDropped = dropped;
+            }
+        }
+        if (entries_.empty() && dropNotes.empty()) return pass;
+
+        std::stable_sort(entries_.begin(), entries_.end(),
+                         [](const Entry& a, const Entry& b) { return a.time < b.time; });
+        static constexpr const char* kEscapes[] = {"", "\033[31m", "\033[32m", "\033[33m",
+                                                   "\033[36m"};
+        out_.clear();
+        for (const Entry& entry : entries_) {
+            RecordHeader header;
+            std::memcpy(&header, entry.record, sizeof(header));
+            const bool colored = options_.colors && header.color != Color::Default;
+            if (colored) out_ += kEscapes[static_cast<int>(header.color)];
+            out_.append(entry.record + sizeof(header), header.length);
+            if (colored) out_ += "\033[0m";
+            if (header.severity != Severity::Prompt) out_ += '\n';
+        }
+        out_ += dropNotes;
+        ++pass.batches;
+        pass.records = entries_.size();
+        pass.bytes = out_.size();
+        if (!writeAll(out_.data(), out_.size(), pass.writes)) ++pass.writeErrors;
+
+        // The batch is out of the rings: give the space back.
+        for (std::size_t i = 0; i < rings.size(); ++i)
+            rings[i]->head.store(ends_[i], std::memory_order_release);
+        return pass;
+    }
+
+    bool writeAll(const char* p, std::size_t n, std::uint64_t& writes) {
+        while (n > 0) {
+            ssize_t w = ::write(options_.fd, p, n);
+            ++writes;
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            p += w;
+            n -= static_cast<std::size_t>(w);
+        }
+        return true;
+    }
+
+    void add(const Stats& pass) {
+        stats_.records += pass.records;
+        stats_.dropped += pass.dropped;
+        stats_.batches += pass.batches;
+        stats_.writes += pass.writes;
+        stats_.bytes += pass.bytes;
+        stats_.writeErrors += pass.writeErrors;
+    }
+
+    // The flusher thread.
+    void run() {
+        std::vector<std::shared_ptr<Ring>> rings;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            const std::uint64_t request = flushRequested_;
+            const bool stopping = stopping_;
+            urgent_.store(false, std::memory_order_relaxed);
+            rings = rings_;
+            lock.unlock();
+
+            Stats pass = drain(rings);
+
+            lock.lock();
+            add(pass);
+            ++passes_;
+            flushDone_ = request;
+            flushedCv_.notify_all();
+            if (blocked_ > 0) spaceCv_.notify_all();
+            // Release the rings of threads that have exited, once empty.
+            rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                        [](const std::shared_ptr<Ring>& ring) {
+                                            return ring->closed.load(std::memory_order_acquire) &&
+                                                   !hasRecords(*ring);
+                                        }),
+                         rings_.end());
+            if (stopping) {
+                if (std::none_of(rings_.begin(), rings_.end(),
+                                 [](const std::shared_ptr<Ring>& ring) {
+                                     return hasRecords(*ring);
+                                 }))
+                    return;
+                continue;
+            }
+            if (flushRequested_ != request || urgent_.load(std::memory_order_relaxed)) continue;
+
+            if (pass.records > 0) {
+                // Busy: let the next batch build up for one interval.
+                wakeCv_.wait_for(lock, options_.flushInterval, [&] {
+                    return stopping_ || flushRequested_ != request ||
+                           urgent_.load(std::memory_order_relaxed);
+                });
+                continue;
+            }
+
+            // Nothing came in during the last pass: sleep until log() wakes us.
+            idle_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (std::any_of(rings_.begin(), rings_.end(),
+                            [](const std::shared_ptr<Ring>& ring) { return hasRecords(*ring); })) {
+                idle_.store(false, std::memory_order_relaxed);
+                continue;
+            }
+            wakeCv_.wait(lock, [&] {
+                return stopping_ || flushRequested_ != request ||
+                       !idle_.load(std::memory_order_relaxed);
+            });
+            idle_.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    AsyncLoggerOptions options_;
+    const std::uint64_t id_;
+
+    mutable std::mutex mutex_;               // everything below but the atomics
+    std::condition_variable wakeCv_;         // wakes the flusher
+    std::condition_variable flushedCv_;      // flushDone_ advanced
+    std::condition_variable spaceCv_;        // a pass freed ring space
+    std::vector<std::shared_ptr<Ring>> rings_;
+    std::uint64_t flushRequested_ = 0;
+    std::uint64_t flushDone_ = 0;
+    std::uint64_t passes_ = 0;
+    int blocked_ = 0;                        // threads in waitForSpace()
+    bool stopping_ = false;
+    Stats stats_;
+
+    std::atomic<bool> idle_{false};          // the flusher sleeps until woken
+    std::atomic<bool> urgent_{false};        // a ring is half full or full
+
+    // Flusher only.
+    std::vector<Entry> entries_;
+    std::vector<std::uint64_t> ends_;
+    std::string out_;
+
+    std::thread flusher_;
+};
+
+// The process-wide logger behind printSuccess()/printError()/printPrompt():
+// standard output, OverflowPolicy::Block. Destroyed (and drained) at exit.
+inline AsyncLogger& consoleLogger() {
+    static AsyncLogger logger;
+    return logger;
+}
+
+}  // namespace fastio
+
+#endif  // ASYNC_LOGGER_H
@@ -9,30 +9,30 @@
    **Key Concepts**
    - Defining functions for colored output
    - Using helper functions to color text for input, success, and error messages
+   - Handing the output to an asynchronous logger (async_logger.h)
+
+   Compile with: g++ -std=c++17 -pthread color_helper_functions.cpp
 */
 
 #include <iostream>
 #include <string>
 
-// ANSI escape codes for colors
-const std::string RED     = "\033[31m";
-const std::string GREEN   = "\033[32m";
-const std::string CYAN    = "\033[36m";
-const std::string RESET   = "\033[0m";
+#include "async_logger.h"
 
 // Function to output a message in cyan (for prompts)
 void printPrompt(const std::string& message) {
-    std::cout << CYAN << message << RESET;
+    fastio::consoleLogger().log(fastio::Severity::Prompt, message);
+    fastio::consoleLogger().flush();  // The prompt must be visible before we read
 }
 
 // Function to output a message in green (for success messages)
 void printSuccess(const std::string& message) {
-    std::cout << GREEN << message << RESET << std::endl;
+    fastio::consoleLogger().log(fastio::Severity::Success, message);
 }
 
 // Function to output a message in red (for error messages)
 void printError(const std::string& message) {
-    std::cout << RED << message << RESET << std::endl;
+    fastio::consoleLogger().log(fastio::Severity::Error, message);
 }
 
 int main() {
@@ -69,4 +69,18 @@ Explanation:
 2. Encapsulation:
    - Encapsulating color formatting in functions reduces repetition and 
      centralizes color usage, making the code more readable and easier to update.
+   - Because every message goes through these three functions, they could
+     move from `std::cout << color << message << RESET << std::endl` to an
+     asynchronous logger without changing any caller.
+
+3. Asynchronous Output:
+   - The helpers do not write to the terminal themselves: they pass the text,
+     with its severity, to `fastio::consoleLogger()`. The color comes from
+     the severity (prompt: cyan, success: green, error: red), and a
+     background thread writes the messages in batches.
+   - `std::endl` flushed (one system call) after every message; now many
+     messages share one write(), and no thread waits for the terminal.
+     See 12_async_logging.cpp for the measurements.
+   - printPrompt() calls flush(): the user must see the question before
+     `std::getline` waits for the answer.
 */
\ No newline at end of file
@@ -0,0 +1,184 @@
+/*
+    ==========================================================
+    delimiter_scanner.h - SIMD NEWLINE AND WHITESPACE SCANNING
+    ==========================================================
+    Splitting text into lines or words is a search for delimiter
+    bytes. Testing one character at a time costs a load, a few
+    compares and a branch per byte. SIMD instructions test 16
+    (SSE2) or 32 (AVX2) bytes at once:
+
+        _mm256_cmpeq_epi8(chunk, '\n')  -> 0xFF where the byte is '\n'
+        _mm256_movemask_epi8(result)    -> one bit per byte
+
+    Doing this for a 64-byte block gives two 64-bit bitmaps:
+    - newline: bit i set if byte i is '\n'
+    - space:   bit i set if byte i is ' ', '\t', '\n', '\v', '\f'
+               or '\r'
+
+    Word boundaries are the bits where "is space" changes:
+    space ^ (space << 1). Each bitmap is then flattened into an
+    array of positions with "count trailing zeros", eight bits per
+    step, so the loop does not mispredict a branch on every word
+    as a byte-at-a-time scan does.
+
+    API (used by fastio::lines() and fastio::tokens()):
+    - `DelimiterScanner scan(text, DelimiterScanner::Kind::Newline);`
+    - `scan.next()`   the next '\n' position, or npos at the end
+    - Kind::WordBoundary yields start, end, start, end, ... of the
+      whitespace-separated words, like `file >> word` sees them.
+
+    Key Concepts:
+    - AVX2 is used when compiled with -mavx2 (or -march=native),
+      SSE2 otherwise on x86-64, and a portable loop elsewhere.
+    - The last partial block is copied into a padded 64-byte
+      buffer, so no load ever reads past the end of the text.
+*/
+
+#ifndef DELIMITER_SCANNER_H
+#define DELIMITER_SCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace fastio {
+
+struct BlockMasks {
+    std::uint64_t newline;
+    std::uint64_t space;
+};
+
+// Classifies the 64 bytes at p.
+inline BlockMasks classify64(const char* p) {
+#if defined(__AVX2__)
+    const __m256i nl = _mm256_set1_epi8('\n');
+    const __m256i sp = _mm256_set1_epi8(' ');
+    const __m256i nine = _mm256_set1_epi8(9);
+    const __m256i four = _mm256_set1_epi8(4);
+    auto masks = [&](__m256i x, std::uint32_t& n, std::uint32_t& s) {
+        // '\t'..'\r' are 9..13: (x - 9) <= 4 as unsigned bytes.
+        __m256i t = _mm256_sub_epi8(x, nine);
+        __m256i ctrl = _mm256_cmpeq_epi8(_mm256_min_epu8(t, four), t);
+        __m256i space = _mm256_or_si256(ctrl, _mm256_cmpeq_epi8(x, sp));
+        n = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, nl)));
+        s = static_cast<std::uint32_t>(_mm256_movemask_epi8(space));
+    };
+    std::uint32_t n0, s0, n1, s1;
+    masks(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), n0, s0);
+    masks(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32)), n1, s1);
+    return {n0 | (std::uint64_t(n1) << 32), s0 | (std::uint64_t(s1) << 32)};
+#elif defined(__SSE2__)
+    const __m128i nl = _mm_set1_epi8('\n');
+    const __m128i sp = _mm_set1_epi8(' ');
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i four = _mm_set1_epi8(4);
+    BlockMasks m = {0, 0};
+    for (int i = 0; i < 4; ++i) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+        __m128i t = _mm_sub_epi8(x, nine);
+        __m128i ctrl = _mm_cmpeq_epi8(_mm_min_epu8(t, four), t);
+        __m128i space = _mm_or_si128(ctrl, _mm_cmpeq_epi8(x, sp));
+        m.newline |= std::uint64_t(std::uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(x, nl)))) << (16 * i);
+        m.space |= std::uint64_t(std::uint16_t(_mm_movemask_epi8(space))) << (16 * i);
+    }
+    return m;
+#else
+    BlockMasks m = {0, 0};
+    for (int i = 0; i < 64; ++i) {
+        unsigned char c = static_cast<unsigned char>(p[i]);
+        std::uint64_t bit = std::uint64_t(1) << i;
+        if (c == '\n') m.newline |= bit;
+        if (c == ' ' || static_cast<unsigned char>(c - 9) <= 4) m.space |= bit;
+    }
+    return m;
+#endif
+}
+
+// Appends base + index of every set bit of `bits` to out, lowest first, and
+// returns the count. Bits are extracted eight at a time without testing
+// each one, so the loop branches once per eight positions instead of once
+// per position (out needs room for 8 slack entries).
+inline std::size_t flatten(std::uint64_t bits, std::size_t base, std::size_t* out) {
+    std::size_t count = static_cast<std::size_t>(__builtin_popcountll(bits));
+    for (std::size_t i = 0; i < count; i += 8) {
+        for (int k = 0; k < 8; ++k) {
+            out[i + k] = base + static_cast<std::size_t>(__builtin_ctzll(bits | (std::uint64_t(1) << 63)));
+            bits &= bits - 1;
+        }
+    }
+    return count;
+}
+
+class DelimiterScanner {
+public:
+    enum class Kind {
+        Newline,      // every '\n'
+        WordBoundary  // start, end, start, end, ... of whitespace-separated words
+    };
+
+    static constexpr std::size_t kBlock = 64;
+    static constexpr std::size_t npos = ~std::size_t(0);
+
+    DelimiterScanner(std::string_view text, Kind kind) : text_(text), kind_(kind) {}
+
+    // The next delimiter position, or npos after the last one. A word that
+    // runs to the end of the text ends at text.size().
+    std::size_t next() {
+        while (head_ == count_)
+            if (!refill()) return npos;
+        return positions_[head_++];
+    }
+
+private:
+    bool refill() {
+        head_ = count_ = 0;
+        if (block_ >= text_.size()) {
+            if (kind_ == Kind::WordBoundary && !prevSpace_) {
+                prevSpace_ = 1;  // close the last word
+                positions_[count_++] = text_.size();
+                return true;
+            }
+            return false;
+        }
+        BlockMasks m = load(block_);
+        std::uint64_t bits;
+        if (kind_ == Kind::Newline) {
+            bits = m.newline;
+        } else {
+            // A word starts or ends wherever "is space" differs from the
+            // byte before; the text starts in the space state.
+            bits = m.space ^ ((m.space << 1) | prevSpace_);
+            prevSpace_ = m.space >> 63;
+        }
+        count_ = flatten(bits, block_, positions_);
+        block_ += kBlock;
+        return true;
+    }
+
+    BlockMasks load(std::size_t start) const {
+        if (start + kBlock <= text_.size()) return classify64(text_.data() + start);
+        // Tail: pad with spaces, which are never newlines and end a word.
+        char padded[kBlock];
+        std::memset(padded, ' ', kBlock);
+        std::memcpy(padded, text_.data() + start, text_.size() - start);
+        return classify64(padded);
+    }
+
+    std::string_view text_;
+    Kind kind_;
+    std::size_t block_ = 0;  // start of the next block to classify
+    std::uint64_t prevSpace_ = 1;
+    std::size_t head_ = 0, count_ = 0;
+    std::size_t positions_[kBlock + 8];
+};
+
+}  // namespace fastio
+
+#endif  // DELIMITER_SCANNER_H
@@ -0,0 +1,389 @@
+/*
+    ==========================================================
+    student_columns.h - A COLUMNAR FILE FORMAT FOR STUDENTS
+    ==========================================================
+    A row file (6_binary_file_handling.cpp, student_store.h) keeps
+    each Student together: name, age and gpa in one 64-byte record.
+    A query such as "average gpa" then reads all 64 bytes of every
+    record to use 4 of them.
+
+    A columnar file stores each field in its own contiguous block,
+    so a scan reads only the column it needs, and each column can
+    use the encoding that suits its values:
+
+        +------------------------+
+        | header (128 bytes)     |  magic "STUDCOL\0", version, row
+        |                        |  count, per column: encoding,
+        |                        |  offset, size
+        +------------------------+
+        | name: dictionary       |  the distinct names once, then
+        |                        |  one bit-packed code per row
+        +------------------------+
+        | age: frame of reference|  min age, then age - min per row,
+        |      + bit-packing     |  in just enough bits (4 for 18-29)
+        +------------------------+
+        | gpa: float32           |  4 bytes per row, scanned with
+        |                        |  SIMD (SSE2/AVX)
+        +------------------------+
+
+    All fields are little-endian and every column starts on a
+    64-byte boundary.
+
+    API:
+    - `writeStudentColumns("students.col", students);`  vector<Student>
+    - `StudentColumns cols("students.col");`            maps the file
+    - `cols.size()`, `cols[i]`, `cols.name(i)`, `cols.age(i)`, `cols.gpa(i)`
+    - `cols.averageGpa()`     SIMD scan of the gpa column only
+    - `cols.averageAge()`     scan of the packed age column only
+    - `cols.countName("Emma")` compares codes, not strings
+    - `cols.columnBytes(Column::Gpa)`  bytes a scan of that column reads
+
+    Key Concepts:
+    - Column files are written once and read many times; appending
+      a row means rewriting the file. Keep student_store.h for
+      data that changes.
+    - Errors: std::system_error for I/O, std::runtime_error for a
+      malformed file.
+*/
+
+#ifndef STUDENT_COLUMNS_H
+#define STUDENT_COLUMNS_H
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "mapped_file.h"
+#include "student_store.h"  // Student, putLE32/getLE32...
+
+namespace fastio {
+
+enum class Column { Name = 0, Age = 1, Gpa = 2 };
+
+namespace columnfile {
+
+using studentfile::getLE32;
+using studentfile::getLE64;
+using studentfile::putLE32;
+using studentfile::putLE64;
+
+constexpr char kMagic[8] = {'S', 'T', 'U', 'D', 'C', 'O', 'L', '\0'};
+constexpr std::uint32_t kVersion = 1;
+constexpr std::size_t kHeaderSize = 128;
+constexpr std::size_t kColumns = 3;
+constexpr std::size_t kDirectoryAt = 24;  // after magic, version, column count, rows
+constexpr std::size_t kEntrySize = 24;    // encoding, reserved, offset, size
+
+enum Encoding : std::uint32_t { kDictionary = 1, kFrameOfReference = 2, kFloat32 = 3 };
+
+inline unsigned bitsFor(std::uint64_t maxValue) {
+    unsigned bits = 0;
+    while (bits < 64 && (maxValue >> bits) != 0) ++bits;
+    return bits;
+}
+
+// Bit-packed unsigned values: value i occupies bits [i * bits, (i + 1) * bits)
+// of a little-endian stream of 64-bit words.
+inline void pack(const std::vector<std::uint64_t>& values, unsigned bits,
+                 std::vector<unsigned char>& out) {
+    std::size_t words = (values.size() * bits + 63) / 64 + 1;  // +1: unpack() loads 8 bytes
+    std::vector<std::uint64_t> w(words, 0);
+    for (std::size_t i = 0; i < values.size() && bits > 0; ++i) {
+        std::size_t bit = i * bits;
+        w[bit / 64] |= values[i] << (bit % 64);
+        if (bit % 64 + bits > 64) w[bit / 64 + 1] |= values[i] >> (64 - bit % 64);
+    }
+    std::size_t at = out.size();
+    out.resize(at + 8 * words);
+    for (std::size_t i = 0; i < words; ++i) putLE64(&out[at + 8 * i], w[i]);
+}
+
+// Value i of a packed stream with bits <= 56: one unaligned 8-byte load at
+// the byte holding its first bit, no branch on word boundaries.
+inline std::uint64_t unpack(const unsigned char* words, unsigned bits, std::size_t i) {
+    std::size_t bit = i * bits;
+    return (getLE64(words + bit / 8) >> (bit % 8)) & ((std::uint64_t(1) << bits) - 1);
+}
+
+inline void alignTo64(std::vector<unsigned char>& out) {
+    out.resize((out.size() + 63) / 64 * 64, 0);
+}
+
+// Sum of n floats, accumulated in double.
+inline double sumFloats(const float* p, std::size_t n) {
+    std::size_t i = 0;
+    double total = 0.0;
+#if defined(__AVX__)
+    __m256d a0 = _mm256_setzero_pd(), a1 = _mm256_setzero_pd();
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(p + i);
+        a0 = _mm256_add_pd(a0, _mm256_cvtps_pd(_mm256_castps256_ps128(x)));
+        a1 = _mm256_add_pd(a1, _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)));
+    }
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, _mm256_add_pd(a0, a1));
+    total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(__SSE2__)
+    __m128d a0 = _mm_setzero_pd(), a1 = _mm_setzero_pd();
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(p + i);
+        a0 = _mm_add_pd(a0, _mm_cvtps_pd(x));
+        a1 = _mm_add_pd(a1, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+    }
+    alignas(16) double lanes[2];
+    _mm_store_pd(lanes, _mm_add_pd(a0, a1));
+    total = lanes[0] + lanes[1];
+#endif
+    for (; i < n; ++i) total += p[i];
+    return total;
+}
+
+}  // namespace columnfile
+
+// ==========================================================
+// Writer
+// ==========================================================
+
+inline void writeStudentColumns(const std::string& path, const std::vector<Student>& rows) {
+    using namespace columnfile;
+    std::vector<unsigned char> out(kHeaderSize, 0);
+    std::uint64_t offsets[kColumns], sizes[kColumns];
+
+    // name: sorted dictionary of distinct names + one code per row.
+    std::map<std::string_view, std::uint32_t> dictionary;
+    auto nameOf = [](const Student& s) { return std::string_view(s.name, strnlen(s.name, 49)); };
+    for (const Student& s : rows) dictionary.emplace(nameOf(s), 0);
+    std::uint32_t next = 0;
+    for (auto& entry : dictionary) entry.second = next++;
+    std::vector<std::uint64_t> codes(rows.size());
+    for (std::size_t i = 0; i < rows.size(); ++i)
+        codes[i] = dictionary[nameOf(rows[i])];
+    unsigned codeBits = bitsFor(dictionary.empty() ? 0 : dictionary.size() - 1);
+
+    offsets[0] = out.size();
+    out.resize(out.size() + 8 + 4 * (dictionary.size() + 1));
+    putLE32(&out[offsets[0]], static_cast<std::uint32_t>(dictionary.size()));
+    putLE32(&out[offsets[0] + 4], codeBits);
+    std::uint32_t textAt = 0, k = 0;
+    for (const auto& entry : dictionary) {
+        putLE32(&out[offsets[0] + 8 + 4 * k++], textAt);
+        textAt += static_cast<std::uint32_t>(entry.first.size());
+    }
+    putLE32(&out[offsets[0] + 8 + 4 * k], textAt);
+    for (const auto& entry : dictionary)
+        out.insert(out.end(), entry.first.begin(), entry.first.end());
+    out.resize((out.size() + 7) / 8 * 8, 0);
+    pack(codes, codeBits, out);
+    sizes[0] = out.size() - offsets[0];
+    alignTo64(out);
+
+    // age: minimum, then age - minimum in the fewest bits.
+    int minAge = 0, maxAge = 0;
+    if (!rows.empty()) {
+        auto mm = std::minmax_element(
+            rows.begin(), rows.end(),
+            [](const Student& a, const Student& b) { return a.age < b.age; });
+        minAge = mm.first->age;
+        maxAge = mm.second->age;
+    }
+    std::vector<std::uint64_t> ages(rows.size());
+    for (std::size_t i = 0; i < rows.size(); ++i)
+        ages[i] = static_cast<std::uint64_t>(static_cast<std::int64_t>(rows[i].age) - minAge);
+    unsigned ageBits =
+        bitsFor(static_cast<std::uint64_t>(static_cast<std::int64_t>(maxAge) - minAge));
+    offsets[1] = out.size();
+    out.resize(out.size() + 8);
+    putLE32(&out[offsets[1]], static_cast<std::uint32_t>(minAge));
+    putLE32(&out[offsets[1] + 4], ageBits);
+    pack(ages, ageBits, out);
+    sizes[1] = out.size() - offsets[1];
+    alignTo64(out);
+
+    // gpa: plain float32.
+    offsets[2] = out.size();
+    out.resize(out.size() + 4 * rows.size());
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        std::uint32_t bits;
+        std::memcpy(&bits, &rows[i].gpa, 4);
+        putLE32(&out[offsets[2] + 4 * i], bits);
+    }
+    sizes[2] = out.size() - offsets[2];
+
+    std::memcpy(out.data(), kMagic, sizeof(kMagic));
+    putLE32(&out[8], kVersion);
+    putLE32(&out[12], kColumns);
+    putLE64(&out[16], rows.size());
+    const std::uint32_t encodings[kColumns] = {kDictionary, kFrameOfReference, kFloat32};
+    for (std::size_t c = 0; c < kColumns; ++c) {
+        unsigned char* e = &out[kDirectoryAt + kEntrySize * c];
+        putLE32(e, encodings[c]);
+        putLE64(e + 8, offsets[c]);
+        putLE64(e + 16, sizes[c]);
+    }
+
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) studentfile::throwErrno("open", path);
+    try {
+        studentfile::writeAll(fd, out.data(), out.size(), path);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+}
+
+// ==========================================================
+// Reader
+// ==========================================================
+
+class StudentColumns {
+public:
+    explicit StudentColumns(const std::string& path) : file_(path) {
+        using namespace columnfile;
+        std::string_view all = file_.data();
+        base_ = reinterpret_cast<const unsigned char*>(all.data());
+        if (all.size() < kHeaderSize || std::memcmp(base_, kMagic, sizeof(kMagic)) != 0)
+            throw std::runtime_error(path + ": not a student column file");
+        if (getLE32(base_ + 8) != kVersion || getLE32(base_ + 12) != kColumns)
+            throw std::runtime_error(path + ": unsupported version");
+        rows_ = getLE64(base_ + 16);
+        const std::uint32_t encodings[kColumns] = {kDictionary, kFrameOfReference, kFloat32};
+        for (std::size_t c = 0; c < kColumns; ++c) {
+            const unsigned char* e = base_ + kDirectoryAt + kEntrySize * c;
+            offset_[c] = getLE64(e + 8);
+            size_[c] = getLE64(e + 16);
+            if (getLE32(e) != encodings[c] || offset_[c] > all.size() ||
+                size_[c] > all.size() - offset_[c])
+                throw std::runtime_error(path + ": bad column directory");
+        }
+
+        const unsigned char* n = base_ + offset_[0];
+        if (size_[0] < 8) throw std::runtime_error(path + ": truncated column");
+        dictSize_ = getLE32(n);
+        codeBits_ = getLE32(n + 4);
+        dictOffsets_ = n + 8;
+        if (8 + 4 * (std::uint64_t(dictSize_) + 1) > size_[0])
+            throw std::runtime_error(path + ": truncated column");
+        dictText_ = reinterpret_cast<const char*>(dictOffsets_ + 4 * (dictSize_ + 1));
+        std::size_t textEnd = 8 + 4 * (dictSize_ + 1) + getLE32(dictOffsets_ + 4 * dictSize_);
+        codes_ = n + (textEnd + 7) / 8 * 8;
+
+        const unsigned char* a = base_ + offset_[1];
+        if (size_[1] < 8) throw std::runtime_error(path + ": truncated column");
+        minAge_ = static_cast<int>(getLE32(a));
+        ageBits_ = getLE32(a + 4);
+        ages_ = a + 8;
+
+        gpa_ = base_ + offset_[2];
+        if (codeBits_ > 32 || ageBits_ > 32 || size_[2] != 4 * rows_ ||
+            packedEnd(codes_, codeBits_) > base_ + offset_[0] + size_[0] ||
+            packedEnd(ages_, ageBits_) > base_ + offset_[1] + size_[1])
+            throw std::runtime_error(path + ": truncated column");
+    }
+
+    std::size_t size() const { return rows_; }
+
+    std::string_view name(std::size_t i) const {
+        return dictionaryEntry(columnfile::unpack(codes_, codeBits_, i));
+    }
+    int age(std::size_t i) const {
+        return minAge_ + static_cast<int>(columnfile::unpack(ages_, ageBits_, i));
+    }
+    float gpa(std::size_t i) const {
+        std::uint32_t bits = columnfile::getLE32(gpa_ + 4 * i);
+        float g;
+        std::memcpy(&g, &bits, 4);
+        return g;
+    }
+
+    Student operator[](std::size_t i) const {
+        Student s = {};
+        std::string_view n = name(i);
+        std::memcpy(s.name, n.data(), std::min(n.size(), sizeof(s.name) - 1));
+        s.age = age(i);
+        s.gpa = gpa(i);
+        return s;
+    }
+
+    // Reads only the gpa column, 8 (AVX) or 4 (SSE2) values per step.
+    double averageGpa() const {
+        if (rows_ == 0) return 0.0;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        return columnfile::sumFloats(reinterpret_cast<const float*>(gpa_), rows_) / rows_;
+#else
+        double total = 0.0;
+        for (std::size_t i = 0; i < rows_; ++i) total += gpa(i);
+        return total / rows_;
+#endif
+    }
+
+    // Reads only the packed age column.
+    double averageAge() const {
+        if (rows_ == 0) return 0.0;
+        std::uint64_t total = 0;
+        for (std::size_t i = 0; i < rows_; ++i) total += columnfile::unpack(ages_, ageBits_, i);
+        return minAge_ + static_cast<double>(total) / rows_;
+    }
+
+    // Rows whose name is exactly `name`: one dictionary lookup, then only
+    // the packed codes are compared.
+    std::size_t countName(std::string_view name) const {
+        std::uint32_t lo = 0, hi = dictSize_;
+        while (lo < hi) {
+            std::uint32_t mid = lo + (hi - lo) / 2;
+            if (dictionaryEntry(mid) < name) lo = mid + 1;
+            else hi = mid;
+        }
+        if (lo == dictSize_ || dictionaryEntry(lo) != name) return 0;
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < rows_; ++i)
+            count += columnfile::unpack(codes_, codeBits_, i) == lo;
+        return count;
+    }
+
+    std::size_t columnBytes(Column c) const { return size_[static_cast<int>(c)]; }
+
+private:
+    std::string_view dictionaryEntry(std::uint64_t code) const {
+        std::uint32_t from = columnfile::getLE32(dictOffsets_ + 4 * code);
+        std::uint32_t to = columnfile::getLE32(dictOffsets_ + 4 * (code + 1));
+        return std::string_view(dictText_ + from, to - from);
+    }
+
+    const unsigned char* packedEnd(const unsigned char* words, unsigned bits) const {
+        return words + 8 * ((rows_ * bits + 63) / 64 + 1);
+    }
+
+    MappedFile file_;
+    const unsigned char* base_ = nullptr;
+    std::uint64_t rows_ = 0;
+    std::uint64_t offset_[columnfile::kColumns] = {};
+    std::uint64_t size_[columnfile::kColumns] = {};
+    std::uint32_t dictSize_ = 0, codeBits_ = 0;
+    const unsigned char* dictOffsets_ = nullptr;
+    const char* dictText_ = nullptr;
+    const unsigned char* codes_ = nullptr;
+    int minAge_ = 0;
+    unsigned ageBits_ = 0;
+    const unsigned char* ages_ = nullptr;
+    const unsigned char* gpa_ = nullptr;
+};
+
+}  // namespace fastio
+
+#endif  // STUDENT_COLUMNS_H
@@ -0,0 +1,444 @@
+/*
+    ==========================================================
+    student_store.h - A FIXED-RECORD BINARY FILE FOR STUDENTS
+    ==========================================================
+    6_binary_file_handling.cpp dumps a `Student` with
+
+        file.write(reinterpret_cast<char*>(&s), sizeof(Student));
+
+    That file can only be read back by a program built with the
+    same compiler, on a CPU with the same byte order: the padding
+    after `name` and the byte order of `age` and `gpa` are whatever
+    the compiler and the CPU chose. And one write() per record is
+    one system call per record.
+
+    This header stores millions of students in a portable file:
+
+        +---------------------------+  offset 0
+        | header (64 bytes)         |  magic "STUDREC\0", version,
+        |                           |  record size, record count
+        +---------------------------+  offset 64
+        | record 0 (64 bytes)       |  name[50], 2 zero bytes,
+        | record 1                  |  age (int32 LE), gpa (IEEE
+        | ...                       |  float32 LE), 4 zero bytes
+        +---------------------------+
+
+    - Every field has a fixed offset and is stored in little-endian
+      order (byte-swapped on big-endian CPUs), so the file is the
+      same on every platform. Padding is explicit and always zero.
+    - `StudentWriter` appends through a 1 MiB buffer: one write()
+      per ~16000 records, and one fdatasync() per flush(), so bulk
+      loads run at disk speed.
+    - `StudentStore` maps the file (MappedFile): record i is at
+      64 + 64 * i, so `store[i]` is O(1) and touches one page.
+    - `NameIndex` is an optional secondary index: record numbers
+      sorted by name, searched with binary search, and saved to a
+      side file ("students.bin.idx") so it is built only once.
+
+    API:
+    - `StudentWriter w("students.bin");`   append (creates the file)
+      `w.append(s); ... w.flush();`        commits; the destructor too
+    - `StudentStore db("students.bin");`   throws on a bad file
+      `db.size()`, `db[i]`, `db.at(i)`, `db.name(i)`
+    - `NameIndex idx(db);` / `NameIndex::load(db, path)`
+      `idx.find("Alice")`                  all record numbers named Alice
+      `idx.save(path)`
+
+    Key Concepts:
+    - I/O errors throw std::system_error, malformed files throw
+      std::runtime_error.
+    - The record count in the header is updated by flush(), after
+      the records are written and synced with fdatasync(), so a
+      crash (even a power loss) during an append loses the records
+      since the last flush() but never exposes half-written ones.
+      A full buffer is only written, not synced: the sync is one
+      per flush() call, not one per MiB.
+    - `NameIndex::load` checks that the saved index is a sorted
+      permutation of the store's records, so an index left over
+      from an older version of the file is rejected.
+*/
+
+#ifndef STUDENT_STORE_H
+#define STUDENT_STORE_H
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "mapped_file.h"
+
+namespace fastio {
+
+struct Student {
+    char name[50];
+    int age;
+    float gpa;
+};
+
+namespace studentfile {
+
+constexpr char kMagic[8] = {'S', 'T', 'U', 'D', 'R', 'E', 'C', '\0'};
+constexpr std::uint32_t kVersion = 1;
+constexpr std::size_t kHeaderSize = 64;
+constexpr std::size_t kRecordSize = 64;
+constexpr std::size_t kNameSize = 50;
+
+// Header field offsets.
+constexpr std::size_t kVersionAt = 8;
+constexpr std::size_t kRecordSizeAt = 12;
+constexpr std::size_t kCountAt = 16;
+
+// Record field offsets (bytes 50-51 and 60-63 are zero padding).
+constexpr std::size_t kAgeAt = 52;
+constexpr std::size_t kGpaAt = 56;
+
+// Little-endian field access. memcpy compiles to a single load or store,
+// plus a byte swap on big-endian CPUs.
+inline std::uint32_t toLE32(std::uint32_t v) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+inline std::uint64_t toLE64(std::uint64_t v) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+inline void putLE32(unsigned char* p, std::uint32_t v) {
+    v = toLE32(v);
+    std::memcpy(p, &v, 4);
+}
+
+inline void putLE64(unsigned char* p, std::uint64_t v) {
+    v = toLE64(v);
+    std::memcpy(p, &v, 8);
+}
+
+inline std::uint32_t getLE32(const unsigned char* p) {
+    std::uint32_t v;
+    std::memcpy(&v, p, 4);
+    return toLE32(v);
+}
+
+inline std::uint64_t getLE64(const unsigned char* p) {
+    std::uint64_t v;
+    std::memcpy(&v, p, 8);
+    return toLE64(v);
+}
+
+inline void encode(const Student& s, unsigned char* out) {
+    std::memset(out, 0, kRecordSize);
+    std::size_t len = strnlen(s.name, kNameSize);
+    std::memcpy(out, s.name, len);
+    putLE32(out + kAgeAt, static_cast<std::uint32_t>(s.age));
+    std::uint32_t bits;
+    static_assert(sizeof(float) == 4, "gpa is stored as IEEE float32");
+    std::memcpy(&bits, &s.gpa, 4);
+    putLE32(out + kGpaAt, bits);
+}
+
+inline Student decode(const unsigned char* in) {
+    Student s;
+    std::memcpy(s.name, in, kNameSize);
+    s.name[kNameSize - 1] = '\0';
+    s.age = static_cast<int>(getLE32(in + kAgeAt));
+    std::uint32_t bits = getLE32(in + kGpaAt);
+    std::memcpy(&s.gpa, &bits, 4);
+    return s;
+}
+
+inline void encodeHeader(std::uint64_t count, unsigned char* out) {
+    std::memset(out, 0, kHeaderSize);
+    std::memcpy(out, kMagic, sizeof(kMagic));
+    putLE32(out + kVersionAt, kVersion);
+    putLE32(out + kRecordSizeAt, kRecordSize);
+    putLE64(out + kCountAt, count);
+}
+
+// Returns the record count, or throws if the header is not ours.
+inline std::uint64_t checkHeader(const unsigned char* h, std::uint64_t fileSize,
+                                 const std::string& path) {
+    if (fileSize < kHeaderSize || std::memcmp(h, kMagic, sizeof(kMagic)) != 0)
+        throw std::runtime_error(path + ": not a student record file");
+    if (getLE32(h + kVersionAt) != kVersion)
+        throw std::runtime_error(path + ": unsupported version " +
+                                 std::to_string(getLE32(h + kVersionAt)));
+    if (getLE32(h + kRecordSizeAt) != kRecordSize)
+        throw std::runtime_error(path + ": unexpected record size");
+    std::uint64_t count = getLE64(h + kCountAt);
+    if (count > (fileSize - kHeaderSize) / kRecordSize)
+        throw std::runtime_error(path + ": truncated (header says " + std::to_string(count) +
+                                 " records)");
+    return count;
+}
+
+[[noreturn]] inline void throwErrno(const char* what, const std::string& path) {
+    throw std::system_error(errno, std::generic_category(), std::string(what) + " " + path);
+}
+
+inline void writeAll(int fd, const unsigned char* p, std::size_t n, const std::string& path) {
+    while (n > 0) {
+        ssize_t w = ::write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            throwErrno("write", path);
+        }
+        p += w;
+        n -= static_cast<std::size_t>(w);
+    }
+}
+
+}  // namespace studentfile
+
+// ==========================================================
+// Batched appends
+// ==========================================================
+
+class StudentWriter {
+public:
+    static constexpr std::size_t kBufferSize = 1 << 20;
+
+    // Opens (or creates) path and positions after its last record.
+    explicit StudentWriter(const std::string& path) : path_(path) {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ < 0) studentfile::throwErrno("open", path);
+        try {
+            openAppend();
+        } catch (...) {
+            ::close(fd_);
+            throw;
+        }
+        buffer_.reserve(kBufferSize);
+    }
+
+    ~StudentWriter() {
+        if (fd_ < 0) return;
+        try {
+            flush();
+        } catch (...) {
+            // Destructors must not throw; call flush() to see errors.
+        }
+        ::close(fd_);
+    }
+
+    StudentWriter(const StudentWriter&) = delete;
+    StudentWriter& operator=(const StudentWriter&) = delete;
+
+    void append(const Student& s) {
+        std::size_t old = buffer_.size();
+        buffer_.resize(old + studentfile::kRecordSize);
+        studentfile::encode(s, buffer_.data() + old);
+        ++pending_;
+        if (buffer_.size() + studentfile::kRecordSize > kBufferSize) writeBuffer();
+    }
+
+    template <class It>
+    void append(It first, It last) {
+        for (; first != last; ++first) append(*first);
+    }
+
+    // Writes the buffered records, then commits the new count to the header.
+    // The sync in between keeps the disk from storing the count first.
+    void flush() {
+        writeBuffer();
+        if (pending_ == 0) return;
+        if (::fdatasync(fd_) != 0) studentfile::throwErrno("fdatasync", path_);
+        count_ += pending_;
+        pending_ = 0;
+        unsigned char count[8];
+        studentfile::putLE64(count, count_);
+        if (::pwrite(fd_, count, sizeof(count), studentfile::kCountAt) != sizeof(count))
+            studentfile::throwErrno("pwrite", path_);
+    }
+
+    // Records in the file, including the ones not flushed yet.
+    std::uint64_t size() const { return count_ + pending_; }
+
+private:
+    // Writes a full buffer without a sync; the records stay past the
+    // committed count until the next flush().
+    void writeBuffer() {
+        if (buffer_.empty()) return;
+        studentfile::writeAll(fd_, buffer_.data(), buffer_.size(), path_);
+        buffer_.clear();
+    }
+
+    void openAppend() {
+        using namespace studentfile;
+        struct stat st;
+        if (::fstat(fd_, &st) != 0) throwErrno("fstat", path_);
+        unsigned char header[kHeaderSize];
+        if (st.st_size == 0) {
+            encodeHeader(0, header);
+            writeAll(fd_, header, kHeaderSize, path_);
+        } else {
+            ssize_t n = ::pread(fd_, header, kHeaderSize, 0);
+            if (n < 0) throwErrno("pread", path_);
+            std::uint64_t size = n == static_cast<ssize_t>(kHeaderSize)
+                                     ? static_cast<std::uint64_t>(st.st_size)
+                                     : static_cast<std::uint64_t>(n);
+            count_ = checkHeader(header, size, path_);
+        }
+        // Drop anything past the last committed record (an interrupted append).
+        off_t end = static_cast<off_t>(kHeaderSize + count_ * kRecordSize);
+        if (::ftruncate(fd_, end) != 0) throwErrno("ftruncate", path_);
+        if (::lseek(fd_, end, SEEK_SET) < 0) throwErrno("lseek", path_);
+    }
+
+    std::string path_;
+    int fd_ = -1;
+    std::uint64_t count_ = 0;
+    std::uint64_t pending_ = 0;  // appended since the last flush(), written or not
+    std::vector<unsigned char> buffer_;
+};
+
+// ==========================================================
+// Random access through mmap
+// ==========================================================
+
+class StudentStore {
+public:
+    explicit StudentStore(const std::string& path) : file_(path) {
+        std::string_view all = file_.data();
+        count_ = static_cast<std::size_t>(
+            studentfile::checkHeader(bytes(all.data()), all.size(), path));
+        records_ = bytes(all.data()) + studentfile::kHeaderSize;
+    }
+
+    std::size_t size() const { return count_; }
+
+    Student operator[](std::size_t i) const {
+        return studentfile::decode(records_ + i * studentfile::kRecordSize);
+    }
+
+    Student at(std::size_t i) const {
+        if (i >= count_)
+            throw std::out_of_range("student record " + std::to_string(i) + " of " +
+                                    std::to_string(count_));
+        return (*this)[i];
+    }
+
+    // The name of record i, without copying the record.
+    std::string_view name(std::size_t i) const {
+        const char* p = reinterpret_cast<const char*>(records_ + i * studentfile::kRecordSize);
+        return std::string_view(p, strnlen(p, studentfile::kNameSize - 1));
+    }
+
+private:
+    static const unsigned char* bytes(const char* p) {
+        return reinterpret_cast<const unsigned char*>(p);
+    }
+
+    MappedFile file_;
+    std::size_t count_ = 0;
+    const unsigned char* records_ = nullptr;
+};
+
+// ==========================================================
+// Secondary index: name -> record numbers
+// ==========================================================
+
+class NameIndex {
+public:
+    // Sorts the record numbers of store by name, O(n log n). Record numbers
+    // are stored as 32 bits: throws std::length_error for 2^32 records or more.
+    explicit NameIndex(const StudentStore& store)
+        : store_(&store), order_(checkedSize(store)) {
+        for (std::size_t i = 0; i < order_.size(); ++i) order_[i] = static_cast<std::uint32_t>(i);
+        std::stable_sort(order_.begin(), order_.end(), [&](std::uint32_t a, std::uint32_t b) {
+            return store.name(a) < store.name(b);
+        });
+    }
+
+    // Reads an index written by save(). Throws unless it lists every record
+    // of store once, sorted by name as the constructor sorts them: O(n),
+    // against O(n log n) to rebuild it.
+    static NameIndex load(const StudentStore& store, const std::string& path) {
+        checkedSize(store);
+        MappedFile file(path);
+        std::string_view all = file.data();
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(all.data());
+        if (all.size() < 16 || std::memcmp(p, "STUDIDX", 8) != 0 ||
+            studentfile::getLE64(p + 8) != store.size() || all.size() != 16 + 4 * store.size())
+            throw std::runtime_error(path + ": not an index of this student file");
+        NameIndex index(store, std::vector<std::uint32_t>(store.size()));
+        for (std::size_t i = 0; i < store.size(); ++i) {
+            index.order_[i] = studentfile::getLE32(p + 16 + 4 * i);
+            if (index.order_[i] >= store.size())
+                throw std::runtime_error(path + ": record number out of range");
+        }
+        // Strictly increasing by (name, record number): sorted, and no record
+        // twice, so with n entries below n every record appears once.
+        for (std::size_t i = 1; i < index.order_.size(); ++i) {
+            std::uint32_t a = index.order_[i - 1], b = index.order_[i];
+            std::string_view na = store.name(a), nb = store.name(b);
+            if (nb < na || (nb == na && b <= a))
+                throw std::runtime_error(path + ": not sorted by the names of this student file");
+        }
+        return index;
+    }
+
+    void save(const std::string& path) const {
+        std::vector<unsigned char> out(16 + 4 * order_.size());
+        std::memcpy(out.data(), "STUDIDX", 8);
+        studentfile::putLE64(out.data() + 8, order_.size());
+        for (std::size_t i = 0; i < order_.size(); ++i)
+            studentfile::putLE32(out.data() + 16 + 4 * i, order_[i]);
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) studentfile::throwErrno("open", path);
+        try {
+            studentfile::writeAll(fd, out.data(), out.size(), path);
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+    }
+
+    // Record numbers of every student called name, in file order.
+    std::vector<std::size_t> find(std::string_view name) const {
+        auto range = std::equal_range(order_.begin(), order_.end(), name, Less{store_});
+        return std::vector<std::size_t>(range.first, range.second);
+    }
+
+private:
+    static std::size_t checkedSize(const StudentStore& store) {
+        if (store.size() > std::numeric_limits<std::uint32_t>::max())
+            throw std::length_error("NameIndex: " + std::to_string(store.size()) +
+                                    " records do not fit 32-bit record numbers");
+        return store.size();
+    }
+
+    struct Less {
+        const StudentStore* store;
+        bool operator()(std::uint32_t r, std::string_view n) const { return store->name(r) < n; }
+        bool operator()(std::string_view n, std::uint32_t r) const { return n < store->name(r); }
+    };
+
+    NameIndex(const StudentStore& store, std::vector<std::uint32_t> order)
+        : store_(&store), order_(std::move(order)) {}
+
+    const StudentStore* store_;
+    std::vector<std::uint32_t> order_;  // record numbers sorted by name
+};
+
+}  // namespace fastio
+
+#endif  // STUDENT_STORE_H
@@ -0,0 +1,166 @@
+/* ==========================================================================
+Lesson 10: An Allocation-Free, Cache-Friendly Merge Sort
+
+Theory:
+---------
+complexity.cpp teaches merge sort with the classic recursive version: split
+in two, sort each half, merge into two freshly allocated vectors L and R.
+The complexity is O(n log n), but the constant factor is poor:
+
+- about 2n heap allocations per sort (two vectors per merge),
+- recursion down to single elements, so most calls do almost nothing,
+- a branch per merged element that the CPU cannot predict on random data.
+
+merge_sort.h keeps the algorithm and removes the overheads: insertion sort
+on runs of 32, bottom-up merge passes, one scratch buffer used in ping-pong
+fashion, a branch-free merge loop, and optional parallel merging.
+complexity.cpp's mergeSort(vector<int>&, left, right) now calls it.
+
+Key Points:
+- Same O(n log n), same stability; the gain is purely in the constant.
+- Allocation count per sort goes from ~2n to 0 (caller's buffer) or 1.
+- std::sort (introsort, unstable) is the reference for raw speed;
+  std::stable_sort is the fair comparison for a stable sort.
+- Edge Cases: 1e8 ints need 400 MB for the data plus 400 MB of scratch.
+
+Example:
+---------
+Benchmarks for n = 1e3 .. 1e6 by default (1e3 .. 1e8 with --max-n=100000000):
+    naive_recursive   the original complexity.cpp merge sort
+    msort             merge_sort.h on one thread
+    msort_parallel    merge_sort.h on all hardware threads
+    std_sort, std_stable_sort
+
+Compile & run:
+    g++ -std=c++17 -O2 -pthread "10_Allocation-Free Merge Sort.cpp" -o msort
+    ./msort --bench-samples=5
+    ./msort --bench-samples=3 --max-n=100000000 --bench-format=csv
+========================================================================== */
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../28.Compiler and Low-Level Optimizations/benchmark.h"
+#include "merge_sort.h"
+using namespace std;
+
+// The original version from complexity.cpp, kept for comparison.
+void naiveMerge(vector<int>& arr, int left, int mid, int right) {
+    int n1 = mid - left + 1;
+    int n2 = right - mid;
+    vector<int> L(n1), R(n2);
+    for (int i = 0; i < n1; i++) L[i] = arr[left + i];
+    for (int i = 0; i < n2; i++) R[i] = arr[mid + 1 + i];
+    int i = 0, j = 0, k = left;
+    while (i < n1 && j < n2) {
+        if (L[i] <= R[j])
+            arr[k++] = L[i++];
+        else
+            arr[k++] = R[j++];
+    }
+    while (i < n1) arr[k++] = L[i++];
+    while (j < n2) arr[k++] = R[j++];
+}
+
+void naiveMergeSort(vector<int>& arr, int left, int right) {
+    if (left < right) {
+        int mid = left + (right - left) / 2;
+        naiveMergeSort(arr, left, mid);
+        naiveMergeSort(arr, mid + 1, right);
+        naiveMerge(arr, left, mid, right);
+    }
+}
+
+vector<int> randomInts(size_t n) {
+    mt19937 rng(42);
+    vector<int> v(n);
+    for (int& x : v) x = static_cast<int>(rng());
+    return v;
+}
+
+// Each iteration sorts a fresh copy of the same random input; the copy is
+// not timed.
+template <class Sort>
+void registerSort(const string& name, size_t n, Sort sort) {
+    bench::registerCase(name + "/" + to_string(n), [n, sort](bench::State& state) {
+        const vector<int> input = randomInts(n);
+        vector<int> v;
+        for (auto _ : state) {
+            state.pauseTiming();
+            v = input;
+            state.resumeTiming();
+            sort(v);
+            bench::DoNotOptimize(v.data());
+        }
+        state.setItemsProcessed(n);
+    });
+}
+
+bool checkSorts() {
+    vector<int> input = randomInts(200000);
+    vector<int> expected = input;
+    stable_sort(expected.begin(), expected.end());
+
+    vector<int> a = input;
+    msort::mergeSort(a);
+    msort::Options parallel;
+    parallel.threads = 4;
+    vector<int> b = input;
+    msort::mergeSort(b, parallel);
+
+    // Stability: sort pairs by key only and compare with std::stable_sort.
+    vector<pair<int, int>> pairs(100000);
+    for (size_t i = 0; i < pairs.size(); ++i) pairs[i] = {input[i] % 100, static_cast<int>(i)};
+    vector<pair<int, int>> stableExpected = pairs;
+    auto byKey = [](const pair<int, int>& x, const pair<int, int>& y) { return x.first < y.first; };
+    stable_sort(stableExpected.begin(), stableExpected.end(), byKey);
+    msort::mergeSort(pairs, parallel, byKey);
+
+    return a == expected && b == expected && pairs == stableExpected;
+}
+
+int main(int argc, char** argv) {
+    size_t maxN = 1'000'000;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.rfind("--max-n=", 0) == 0) maxN = strtoull(arg.c_str() + 8, nullptr, 10);
+    }
+
+    cout << "Correctness (sequential, parallel, stability): "
+         << (checkSorts() ? "OK" : "FAILED") << "\n\n";
+
+    msort::Options allThreads;
+    allThreads.threads = 0;
+    for (size_t n = 1000; n <= maxN; n *= 10) {
+        if (n <= 10'000'000) {  // the naive version is too slow beyond this
+            registerSort("naive_recursive", n, [](vector<int>& v) {
+                naiveMergeSort(v, 0, static_cast<int>(v.size()) - 1);
+            });
+        }
+        registerSort("msort", n, [](vector<int>& v) { msort::mergeSort(v); });
+        registerSort("msort_parallel", n, [allThreads](vector<int>& v) {
+            msort::mergeSort(v, allThreads);
+        });
+        registerSort("std_sort", n, [](vector<int>& v) { sort(v.begin(), v.end()); });
+        registerSort("std_stable_sort", n, [](vector<int>& v) {
+            stable_sort(v.begin(), v.end());
+        });
+    }
+    return bench::runAll(argc, argv);
+}
+
+/*
+What to expect (random ints):
+- naive_recursive is the slowest at every size, typically 2.5-3.5x slower
+  than msort: most of its time goes to malloc/free and tiny recursive calls.
+- msort beats std::stable_sort and is close to std::sort (faster on some
+  machines for n >= 1e4, since the branch-free merge does not suffer from
+  the mispredictions of quicksort's partitioning on random data). For tiny
+  inputs std::sort wins.
+- msort_parallel scales with the number of cores once n reaches ~1e5; below
+  parallelThreshold it is the sequential sort.
+*/
@@ -0,0 +1,191 @@
+/* ==========================================================================
+Lesson 11: Measuring Big-O Instead of Asserting It
+
+Theory:
+---------
+complexity.cpp states the class of each algorithm in comments and in a
+hand-written table, and its main() runs everything at n = 5, where every
+algorithm takes nanoseconds. This lesson measures the very same functions
+(complexity.cpp is included with COMPLEXITY_NO_MAIN) at geometrically
+growing sizes and lets complexity_fit.h decide the growth class:
+
+    linearSearch          16 .. 4M      expected O(n)
+    binarySearch          16 .. 4M      expected O(log n)
+    mergeSort             16 .. 1M      expected O(n log n)
+    bubbleSort            16 .. 4096    expected O(n^2)
+    fibonacci             10 .. 30      expected exponential (~1.618^n)
+    generatePermutations   3 .. 9       expected O(n!)
+
+It then reports the fitted constants and the crossover points between the
+algorithms that solve the same problem (linear vs binary search, bubble vs
+merge sort).
+
+Key Points:
+- Timing one size tells you the cost, timing many sizes tells you the class.
+- The fitted constant c is the cost of one "step" of the algorithm, e.g.
+  under a nanosecond per element for a linear scan, a few nanoseconds per
+  comparison for bubble sort.
+- The program exits with status 1 if an algorithm does not fit its expected
+  class, so it can guard against accidental quadratic behaviour.
+- Edge Cases: generatePermutations prints every permutation; its output is
+  discarded while measuring. Each sort call includes copying its input.
+
+Compile & run:
+    g++ -std=c++17 -O2 -pthread "11_Empirical Complexity Fitting.cpp" -o bigo
+    ./bigo --bench-samples=5 --bench-min-time-ms=5
+    ./bigo --fit-format=csv > complexity.csv
+========================================================================== */
+
+#define COMPLEXITY_NO_MAIN
+#include "complexity.cpp"
+
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "../28.Compiler and Low-Level Optimizations/complexity_fit.h"
+
+vector<long long> geometric(long long from, long long to, long long factor) {
+    vector<long long> sizes;
+    for (long long n = from; n <= to; n *= factor) sizes.push_back(n);
+    return sizes;
+}
+
+vector<long long> arithmetic(long long from, long long to, long long step) {
+    vector<long long> sizes;
+    for (long long n = from; n <= to; n += step) sizes.push_back(n);
+    return sizes;
+}
+
+vector<int> sortedInts(long long n) {
+    vector<int> v(n);
+    for (long long i = 0; i < n; ++i) v[i] = static_cast<int>(2 * i);
+    return v;
+}
+
+vector<int> randomInts(long long n) {
+    mt19937 rng(7);
+    vector<int> v(n);
+    for (int& x : v) x = static_cast<int>(rng() % 1000000);
+    return v;
+}
+
+int main(int argc, char** argv) {
+    bench::Options options = bench::parseOptions(argc, argv);
+    string format = "table";
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.rfind("--fit-format=", 0) == 0) format = arg.substr(13);
+    }
+
+    vector<bigo::Series> results;
+
+    // Worst case: the target is absent, so every element is compared.
+    results.push_back(bigo::sweep(
+        "linearSearch", "search", geometric(16, 4 << 20, 4),
+        [](bench::State& state, long long n) {
+            vector<int> v = sortedInts(n);
+            int target = -1;
+            for (auto _ : state) {
+                bench::DoNotOptimize(target);
+                int r = linearSearch(v.data(), static_cast<int>(n), target);
+                bench::DoNotOptimize(r);
+            }
+        },
+        options, {"O(n)"}));
+
+    // Pseudo-random targets, so the branch predictor cannot learn the path.
+    results.push_back(bigo::sweep(
+        "binarySearch", "search", geometric(16, 4 << 20, 4),
+        [](bench::State& state, long long n) {
+            vector<int> v = sortedInts(n);
+            uint32_t x = 2463534242u;
+            for (auto _ : state) {
+                x ^= x << 13;
+                x ^= x >> 17;
+                x ^= x << 5;
+                int target = static_cast<int>(2 * (x % n));
+                int r = binarySearch(v.data(), static_cast<int>(n), target);
+                bench::DoNotOptimize(r);
+            }
+        },
+        options, {"O(log n)"}));
+
+    results.push_back(bigo::sweep(
+        "mergeSort", "sort", geometric(16, 1 << 20, 4),
+        [](bench::State& state, long long n) {
+            const vector<int> input = randomInts(n);
+            vector<int> v;
+            for (auto _ : state) {
+                v = input;
+                mergeSort(v, 0, static_cast<int>(n) - 1);
+                bench::DoNotOptimize(v.data());
+            }
+        },
+        options, {"O(n log n)"}));
+
+    results.push_back(bigo::sweep(
+        "bubbleSort", "sort", geometric(16, 4096, 2),
+        [](bench::State& state, long long n) {
+            const vector<int> input = randomInts(n);
+            vector<int> v;
+            for (auto _ : state) {
+                v = input;
+                bubbleSort(v.data(), static_cast<int>(n));
+                bench::DoNotOptimize(v.data());
+            }
+        },
+        options, {"O(n^2)"}));
+
+    results.push_back(bigo::sweep(
+        "fibonacci", "fibonacci", arithmetic(10, 30, 2),
+        [](bench::State& state, long long n) {
+            int arg = static_cast<int>(n);
+            for (auto _ : state) {
+                bench::DoNotOptimize(arg);
+                int r = fibonacci(arg);
+                bench::DoNotOptimize(r);
+            }
+        },
+        options, {"O(b^n)", "O(2^n)"}));
+
+    ostringstream discard;
+    streambuf* coutBuffer = cout.rdbuf(discard.rdbuf());
+    results.push_back(bigo::sweep(
+        "generatePermutations", "permutations", arithmetic(3, 9, 1),
+        [&discard](bench::State& state, long long n) {
+            string str = string("ABCDEFGHIJ").substr(0, n);
+            for (auto _ : state) {
+                generatePermutations(str, 0, static_cast<int>(n) - 1);
+                discard.str("");
+            }
+        },
+        options, {"O(n!)"}));
+    cout.rdbuf(coutBuffer);
+
+    if (format == "csv")
+        bigo::reportCsv(cout, results);
+    else
+        bigo::reportTable(cout, results);
+
+    for (const bigo::Series& s : results)
+        if (!s.asExpected()) return 1;
+    return 0;
+}
+
+/*
+What to expect:
+- Every algorithm fits its expected class. The rms error is a few percent
+  for the CPU-bound ones; mergeSort fits less tightly because its cost per
+  element rises once the array and its scratch buffer leave the caches.
+- fibonacci fits b^n with b close to the golden ratio 1.618, which is the
+  true growth of the naive recursion (not 2^n).
+- The fitted exponent k of linearSearch is ~1, mergeSort ~1.1-1.25 (the
+  log n factor plus cache effects) and bubbleSort ~2.
+- Crossovers: binarySearch beats linearSearch beyond a few dozen elements.
+  mergeSort (insertion sort below 32 elements) is faster than bubbleSort at
+  every measured size.
+- Try it: break one of the functions in complexity.cpp (e.g. make mergeSort
+  copy the whole array once per element) and watch the fit move to the next
+  class and the exit status become 1.
+*/
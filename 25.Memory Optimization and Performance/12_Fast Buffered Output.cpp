@@ -0,0 +1,155 @@
+/* ==========================================================================
+Lesson 12: Fast Buffered Output - Bypassing iostream
+
+Theory:
+---------
+Lesson 3 removes the flush of std::endl; this lesson removes the rest of
+the iostream machinery. fast_writer.h formats numbers straight into a
+64 KiB buffer (with numfmt::toChars from 5.strings/number_format.h) and
+hands full buffers to write(2). There is no sentry, no locale and no
+virtual call per value.
+
+Key Points:
+- Every case writes to standard output, redirected to /dev/null while
+  it runs, so the numbers measure formatting and buffering only.
+- cout is measured under sync_with_stdio(false), its fastest setting.
+- ints/writer_print goes through the "{}" format parser: the gap to
+  ints/writer is the cost of parsing the format at run time.
+
+Example:
+---------
+    ints/cout            cout << i << '\n'
+    ints/printf          printf("%d\n", i)
+    ints/writer          fastout::Writer << i << '\n'
+    ints/writer_print    out.print("{}\n", i)
+    doubles/cout         cout << x << '\n'  (6 significant digits)
+    doubles/writer       Writer << x << '\n' (shortest round trip)
+
+Compile & run:
+    g++ -std=c++17 -O2 "12_Fast Buffered Output.cpp" -o fastout
+    ./fastout --bench-samples=3                 # 100M integers
+    ./fastout --n=10000000 --bench-samples=5
+========================================================================== */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "../28.Compiler and Low-Level Optimizations/benchmark.h"
+#include "fast_writer.h"
+using namespace std;
+
+// Sends standard output to /dev/null for the lifetime of the object.
+class DiscardStdout {
+public:
+    DiscardStdout() {
+        cout.flush();
+        fflush(stdout);
+        saved_ = dup(STDOUT_FILENO);
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        close(null);
+    }
+    ~DiscardStdout() {
+        cout.flush();
+        fflush(stdout);
+        dup2(saved_, STDOUT_FILENO);
+        close(saved_);
+    }
+
+private:
+    int saved_;
+};
+
+int main(int argc, char** argv) {
+    ios_base::sync_with_stdio(false);
+    long long n = 100000000;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.rfind("--n=", 0) == 0) n = atoll(arg.c_str() + 4);
+    }
+    const long long doubles = n / 10;
+    cout << n << " integers, " << doubles << " doubles per run, written to /dev/null\n\n";
+
+    bench::registerCase("ints/cout", [n](bench::State& state) {
+        DiscardStdout discard;
+        for (auto _ : state) {
+            for (long long i = 0; i < n; ++i) cout << i << '\n';
+            cout.flush();
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("ints/printf", [n](bench::State& state) {
+        DiscardStdout discard;
+        for (auto _ : state) {
+            for (long long i = 0; i < n; ++i) printf("%lld\n", i);
+            fflush(stdout);
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("ints/writer", [n](bench::State& state) {
+        DiscardStdout discard;
+        for (auto _ : state) {
+            fastout::Writer out;
+            for (long long i = 0; i < n; ++i) out << i << '\n';
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("ints/writer_print", [n](bench::State& state) {
+        DiscardStdout discard;
+        for (auto _ : state) {
+            fastout::Writer out;
+            for (long long i = 0; i < n; ++i) out.print("{}\n", i);
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("doubles/cout", [doubles](bench::State& state) {
+        DiscardStdout discard;
+        for (auto _ : state) {
+            for (long long i = 0; i < doubles; ++i) cout << i * 0.001 << '\n';
+            cout.flush();
+        }
+        state.setItemsProcessed(doubles);
+    });
+
+    bench::registerCase("doubles/writer", [doubles](bench::State& state) {
+        DiscardStdout discard;
+        for (auto _ : state) {
+            fastout::Writer out;
+            for (long long i = 0; i < doubles; ++i) out << i * 0.001 << '\n';
+        }
+        state.setItemsProcessed(doubles);
+    });
+
+    int rc = bench::runAll(argc, argv);
+    cout.flush();
+
+    // The same API on the terminal; output appears at flush() (or at the end).
+    fastout::Writer out;
+    out << "\nSample output: " << 42 << ' ' << -7 << ' ' << 0.1 << ' ' << 1e100 << '\n';
+    out.print("{} students, average gpa {}\n", 3, fastout::fixed(3.4666, 2));
+    out.flush();
+    return rc;
+}
+
+/*
+What to expect:
+- ints/writer is 5-10x faster than ints/cout and ints/printf: the time per
+  number drops from 50-100 nanoseconds to under 10.
+- ints/writer_print is 2-3x slower than ints/writer, because the "{}\n"
+  format is scanned on every call, but still faster than cout: a format
+  string costs less than the stream machinery.
+- doubles/writer is several times faster than doubles/cout and prints the
+  shortest exact value (0.001, 1.234) where cout rounds to 6 digits.
+- The last two lines show the same writer on the terminal:
+      Sample output: 42 -7 0.1 1e+100
+      3 students, average gpa 3.47
+*/
@@ -14,6 +14,9 @@ Key Points:
 - Be cautious when mixing C and C++ I/O.
 - Edge Cases: In interactive programs, you may want to flush to ensure output appears
 immediately.
+- Beyond flushing, every `cout <<` still pays for a sentry, a locale lookup and
+  virtual calls. fast_writer.h (Lesson 12) formats into its own buffer and only
+  flushes when it is full or when asked to.
 
 Example:
 ---------
@@ -21,6 +24,7 @@ Comparing output with std::endl and '\\n'.
 ========================================================================== */
 
 #include <iostream>
+#include "fast_writer.h"
 using namespace std;
 
 int main() {
@@ -41,5 +45,14 @@ int main() {
     // Flush once at the end if needed.
     cout.flush();
 
+    // fastout::Writer: the same output without iostream; flush() is the only
+    // flush point besides a full buffer and the end of its lifetime.
+    fastout::Writer out;
+    out << "Using fastout::Writer:\n";
+    for (int i = 0; i < 5; ++i) {
+        out << "Line " << i << '\n';
+    }
+    out.flush();
+
     return 0;
 }
\ No newline at end of file
@@ -61,4 +61,10 @@ int main() {
     cout << "Total deallocated: " << totalDeallocated << " bytes\n";
     cout << "Net memory in use: " << (totalAllocated - totalDeallocated) << " bytes\n";
     return 0;
-}
\ No newline at end of file
+}
+
+/*
+Note: this version is intentionally simple. For a thread-safe tracker that
+needs no map, never prints on the hot path and covers the array, sized and
+aligned forms, see Lesson 6 (alloc_tracker.h / alloc_tracker.cpp).
+*/
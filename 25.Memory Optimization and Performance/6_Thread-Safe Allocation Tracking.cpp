@@ -0,0 +1,133 @@
+/* ==========================================================================
+Lesson 6: Thread-Safe, Low-Overhead Allocation Tracking
+
+Theory:
+---------
+Lesson 5 showed the idea of overloading global new/delete to track memory.
+Its implementation (a global std::map plus a `cout` per call) has three
+problems that make it unusable outside a toy program:
+1. Data races: several threads inserting into one map corrupt it.
+2. Re-entrance: the map allocates its nodes with... operator new.
+3. Cost: a tree lookup and a formatted print per allocation.
+
+alloc_tracker.h / alloc_tracker.cpp fix all three:
+- A 16-byte header in front of every block stores the size, so operator
+  delete needs no lookup table at all.
+- Each thread counts into its own cache-line-aligned slot with plain relaxed
+  stores (one writer per slot = no lock and no atomic read-modify-write).
+- snapshot() sums the slots on demand; nothing is printed on the hot path.
+- All replaceable forms are covered: new/new[], nothrow, sized delete,
+  and C++17 aligned new/delete.
+
+Key Points:
+- The cost of tracking is a few nanoseconds on top of malloc, so it can stay
+  on during load tests.
+- Build alloc_tracker.cpp with -DALLOC_TRACKER_DISABLED to measure that cost
+  against the plain system allocator.
+- Edge Cases: a block freed by a different thread than the one that
+  allocated it is credited to the freeing thread; the totals stay correct.
+
+Example:
+---------
+1. Four threads allocate and free concurrently; the snapshot adds up.
+2. Aligned and array forms go through the same header.
+3. Benchmark of one new/delete pair (compare with the disabled build).
+
+Compile & run:
+    g++ -std=c++17 -O2 -pthread "6_Thread-Safe Allocation Tracking.cpp" alloc_tracker.cpp -o track
+    ./track
+
+    g++ -std=c++17 -O2 -pthread -DALLOC_TRACKER_DISABLED \
+        "6_Thread-Safe Allocation Tracking.cpp" alloc_tracker.cpp -o track_off
+    ./track_off --bench-filter=new_delete
+========================================================================== */
+
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../28.Compiler and Low-Level Optimizations/benchmark.h"
+#include "alloc_tracker.h"
+using namespace std;
+
+// 1. Concurrent allocations: every thread builds and destroys vectors.
+void worker(int id) {
+    for (int round = 0; round < 10000; ++round) {
+        vector<int> v(16 + (round % 64));
+        v[0] = id;
+        auto p = make_unique<double>(round);
+        bench::DoNotOptimize(v.data());
+        bench::DoNotOptimize(*p);
+    }
+}
+
+// 2. An over-aligned type uses operator new(size_t, align_val_t).
+struct alignas(64) CacheLine {
+    char bytes[64];
+};
+
+// 3. Cost of one tracked new/delete pair.
+void newDeletePair(bench::State& state) {
+    for (auto _ : state) {
+        int* p = new int(42);
+        bench::DoNotOptimize(p);
+        delete p;
+    }
+}
+
+void newDeletePairThreads(bench::State& state) {
+    // One iteration = 4 threads doing 10000 pairs each. Per-thread slots mean
+    // the counters add no contention on top of malloc's own.
+    const int threads = 4;
+    const int pairsPerThread = 10000;
+    for (auto _ : state) {
+        vector<thread> pool;
+        for (int t = 0; t < threads; ++t) {
+            pool.emplace_back([] {
+                for (int i = 0; i < pairsPerThread; ++i) {
+                    int* p = new int(42);
+                    bench::DoNotOptimize(p);
+                    delete p;
+                }
+            });
+        }
+        for (auto& th : pool) th.join();
+    }
+    state.setItemsProcessed(threads * pairsPerThread);
+}
+
+int main(int argc, char** argv) {
+    alloctrack::Snapshot before = alloctrack::snapshot();
+
+    vector<thread> threads;
+    for (int i = 0; i < 4; ++i) threads.emplace_back(worker, i);
+    for (auto& t : threads) t.join();
+
+    CacheLine* line = new CacheLine;
+    cout << "CacheLine address % 64 = " << reinterpret_cast<uintptr_t>(line) % 64 << '\n';
+    int* arr = new int[10];
+    delete[] arr;
+    delete line;
+
+    alloctrack::Snapshot after = alloctrack::snapshot();
+    cout << "Allocations made by the worker threads and examples: "
+         << after.allocations - before.allocations << "\n\n";
+    alloctrack::print(cout, after);
+    cout << '\n';
+
+    bench::registerCase("new_delete/single_thread", newDeletePair);
+    bench::registerCase("new_delete/4_threads", newDeletePairThreads);
+    return bench::runAll(argc, argv);
+}
+
+/*
+What to expect:
+- "live bytes" is close to zero after the threads join: everything they
+  allocated was freed, even though the counting was spread over 4 slots.
+- The size histogram shows the vector sizes (64-320 bytes) and the 8-byte
+  doubles from make_unique.
+- new_delete/single_thread with the tracker is within a few ns of the
+  ALLOC_TRACKER_DISABLED build; the std::map version of Lesson 5 costs
+  hundreds of ns (and microseconds with its printing).
+*/
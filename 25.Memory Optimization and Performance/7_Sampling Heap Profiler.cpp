@@ -0,0 +1,118 @@
+/* ==========================================================================
+Lesson 7: Sampling Heap Profiler with Allocation-Site Call Stacks
+
+Theory:
+---------
+Lesson 6's tracker tells you how much memory is live. A heap *profiler*
+tells you which lines of code allocated it. Recording a stack trace for every
+allocation is far too slow (microseconds each), so production profilers
+sample:
+
+- Allocated bytes are treated as a Poisson process: on average one sample
+  every N bytes, with exponentially distributed gaps (no aliasing).
+- A sampled block of s bytes had probability p = 1 - exp(-s/N) of being
+  chosen, so weighting each sample by 1/p gives unbiased totals per stack.
+- The cost on non-sampled allocations is a subtraction and a branch.
+
+heap_profiler.h plugs into alloc_tracker's sampling hook, aggregates samples
+by call stack and writes:
+- a folded-stack file (for flamegraph.pl or https://www.speedscope.app), or
+- a pprof heap profile (`pprof --text ./prof heap.prof`).
+
+Key Points:
+- Sample rate is a trade-off: smaller N = more precise, more overhead.
+- Frees of sampled blocks are matched through a tag in the block header, so
+  the "in use" view shrinks when memory is released.
+- `kill -USR1 <pid>` dumps the profile of a running program.
+- Edge Cases: compile with -g -rdynamic so frames in the executable get
+  names; -fno-omit-frame-pointer gives more reliable stacks at -O2.
+
+Example:
+---------
+The workload of performanceComparison() in
+13.smart pointers/lesson_06_advanced_smart_pointers.cpp: one million
+make_unique<int> and one million make_shared<int>, kept alive in vectors.
+
+Compile & run:
+    g++ -std=c++17 -O2 -g -rdynamic -fno-omit-frame-pointer -pthread \
+        "7_Sampling Heap Profiler.cpp" heap_profiler.cpp alloc_tracker.cpp -o heapprof
+    ./heapprof
+    flamegraph.pl heap.folded > heap.svg
+========================================================================== */
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "alloc_tracker.h"
+#include "heap_profiler.h"
+using namespace std;
+
+const int SIZE = 1'000'000;
+
+vector<unique_ptr<int>> buildUnique() {
+    vector<unique_ptr<int>> v;
+    for (int i = 0; i < SIZE; ++i) v.push_back(make_unique<int>(i));
+    return v;
+}
+
+vector<shared_ptr<int>> buildShared() {
+    vector<shared_ptr<int>> v;
+    for (int i = 0; i < SIZE; ++i) v.push_back(make_shared<int>(i));
+    return v;
+}
+
+// Allocated and freed right away: shows up in "allocated", not in "in use".
+void temporaryStrings() {
+    for (int i = 0; i < SIZE / 10; ++i) {
+        string s(100, 'x');
+        s[0] = static_cast<char>(i);
+    }
+}
+
+int main() {
+    heapprof::Options opt;
+    opt.sampleBytes = 64 * 1024;  // denser than the default for a short demo
+    opt.outputPath = "heap.folded";
+    opt.format = heapprof::Format::Folded;
+    opt.dumpAtExit = false;  // at exit everything is freed: dump while it is live
+    if (!heapprof::start(opt)) {
+        cout << "Heap profiler unavailable (tracker built with ALLOC_TRACKER_DISABLED).\n";
+    }
+
+    auto start = chrono::steady_clock::now();
+    auto uniqueVec = buildUnique();
+    auto sharedVec = buildShared();
+    temporaryStrings();
+    auto end = chrono::steady_clock::now();
+
+    alloctrack::Snapshot snap = alloctrack::snapshot();
+    cout << "Workload took " << chrono::duration_cast<chrono::milliseconds>(end - start).count()
+         << " ms\n";
+    cout << "Exact live bytes (tracker):  " << snap.liveBytes << '\n';
+    cout << "Distinct sampled call sites: " << heapprof::siteCount() << "\n\n";
+
+    cout << "Top allocation sites by estimated in-use bytes:\n";
+    heapprof::report(cout, 5);
+
+    heapprof::dump();
+    cout << "\nFolded profile written to heap.folded\n";
+    return 0;
+}
+
+/*
+What to expect:
+- Two dominant sites: buildShared (make_shared allocates the int and its
+  control block together, ~24 bytes per element) and buildUnique (4-byte
+  ints, padded to the allocator's minimum), plus the vectors' buffers.
+- The estimates are unbiased but noisy. A site of B bytes gets about
+  B / 64 KiB samples, so its relative error is about 1/sqrt(B / 64 KiB):
+  ~5% for buildShared (~23 MB, ~370 samples), ~13% for buildUnique's
+  ~4 MB (~60 samples); deviations of 10-40% on sites of a few MB are
+  normal from run to run. Quartering sampleBytes halves the error. The
+  vector buffers, each larger than 64 KiB, are always sampled and exact.
+- temporaryStrings appears with large "allocated" and ~0 "in use".
+- Compare the runtime with and without heapprof::start(): sampling at 64 KiB
+  costs only a few percent on this allocation-heavy loop.
+*/
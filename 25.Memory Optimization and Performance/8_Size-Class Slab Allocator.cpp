@@ -0,0 +1,172 @@
+/* ==========================================================================
+Lesson 8: A Size-Class Slab Allocator as the Global operator new
+
+Theory:
+---------
+"Object pooling for small object allocations" (good_performance_practices.cpp,
+item 8) usually means a pool per type. Modern allocators apply the same idea
+to *every* small allocation of the program by replacing operator new:
+
+- Round each request up to a size class (16, 32, 48, ..., 32 KiB).
+- Carve 64 KiB slabs into blocks of one class; the slab number tells delete
+  which class a pointer belongs to, so no per-block header is needed.
+- Give each thread a free list per class: new = pop, delete = push,
+  with no lock and no atomic instruction.
+- Move blocks between threads in batches through central lists, so the lock
+  is taken once per ~dozens of allocations instead of once per allocation.
+- Send big requests (> 32 KiB) straight to mmap.
+
+See slab_allocator.h / slab_allocator.cpp for the implementation.
+
+Key Points:
+- The allocator is installed simply by linking slab_allocator.cpp: every
+  new, make_unique, make_shared, vector and string in the program uses it.
+- glibc malloc is already good; the gain comes from skipping its general
+  bookkeeping (chunk headers, bins, arena locks) on the small-object path.
+- Edge Cases: a thread's cached blocks are returned to the central lists
+  when it exits; small-block memory is reused but never given back to the OS.
+  Without a reserved range, small requests are served by malloc instead.
+
+Example:
+---------
+The benchmark of performanceComparison() in
+13.smart pointers/lesson_06_advanced_smart_pointers.cpp: one million
+make_unique<int> and make_shared<int> calls, kept alive in a vector and then
+released, measured with benchmark.h.
+
+Compile & run (and compare with the system allocator):
+    g++ -std=c++17 -O2 -pthread "8_Size-Class Slab Allocator.cpp" slab_allocator.cpp -o slab
+    g++ -std=c++17 -O2 -pthread -DSLAB_ALLOCATOR_DISABLED \
+        "8_Size-Class Slab Allocator.cpp" slab_allocator.cpp -o glibc
+    ./slab && ./glibc
+Exercise the malloc fallback (no range is reserved at all):
+    g++ -std=c++17 -O2 -pthread -DSLAB_ALLOCATOR_MAX_SLABS=0 \
+        "8_Size-Class Slab Allocator.cpp" slab_allocator.cpp -o fallback
+    ./fallback
+========================================================================== */
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "../28.Compiler and Low-Level Optimizations/benchmark.h"
+#include "slab_allocator.h"
+using namespace std;
+
+const int SIZE = 1'000'000;
+
+// 1. make_unique<int> x 1M, as in performanceComparison().
+void uniquePointers(bench::State& state) {
+    for (auto _ : state) {
+        vector<unique_ptr<int>> uniqueVec;
+        uniqueVec.reserve(SIZE);
+        for (int i = 0; i < SIZE; ++i) uniqueVec.push_back(make_unique<int>(i));
+        bench::DoNotOptimize(uniqueVec.data());
+    }
+    state.setItemsProcessed(SIZE);
+}
+
+// 2. make_shared<int> x 1M (one block for the int and its control block).
+void sharedPointers(bench::State& state) {
+    for (auto _ : state) {
+        vector<shared_ptr<int>> sharedVec;
+        sharedVec.reserve(SIZE);
+        for (int i = 0; i < SIZE; ++i) sharedVec.push_back(make_shared<int>(i));
+        bench::DoNotOptimize(sharedVec.data());
+    }
+    state.setItemsProcessed(SIZE);
+}
+
+// 3. A single short-lived allocation: the pure fast path.
+void newDeletePair(bench::State& state) {
+    for (auto _ : state) {
+        int* p = new int(1);
+        bench::DoNotOptimize(p);
+        delete p;
+    }
+}
+
+// 4. Producer/consumer: blocks allocated on one thread, freed on another,
+//    which exercises the batch transfers through the central lists.
+void crossThreadFree(bench::State& state) {
+    const int count = 100000;
+    for (auto _ : state) {
+        vector<int*> blocks(count);
+        thread producer([&] {
+            for (int i = 0; i < count; ++i) blocks[i] = new int(i);
+        });
+        producer.join();
+        thread consumer([&] {
+            for (int i = 0; i < count; ++i) delete blocks[i];
+        });
+        consumer.join();
+    }
+    state.setItemsProcessed(count);
+}
+
+// 5. Every size class and alignment, checked before the benchmarks: the
+//    blocks must be aligned, writable and released without a crash, whether
+//    they come from slabs or from the malloc fallback.
+bool blocksAreUsable() {
+    vector<pair<void*, size_t>> blocks;  // (block, alignment)
+    for (size_t size = 1; size <= 40000; size = size * 5 / 4 + 1) {
+        for (size_t align : {size_t(8), size_t(64), size_t(4096)}) {
+            void* p = align <= 16 ? operator new(size) : operator new(size, align_val_t(align));
+            if (reinterpret_cast<uintptr_t>(p) % align != 0) return false;
+            memset(p, 0xAB, size);
+            blocks.push_back({p, align});
+        }
+    }
+    for (auto& [p, align] : blocks) {
+        if (align <= 16)
+            operator delete(p);
+        else
+            operator delete(p, align_val_t(align));
+    }
+    slab::Stats s = slab::stats();
+    // No reserved range: every small request must have taken the fallback.
+    return !slab::enabled() || s.reservedBytes > 0 || s.fallbackAllocations > 0;
+}
+
+int main(int argc, char** argv) {
+    cout << "Allocator: " << (slab::enabled() ? "slab (size classes + thread caches)"
+                                              : "system malloc") << "\n\n";
+    // Over-aligned types come from the power-of-two classes.
+    struct alignas(256) Aligned {
+        char data[100];
+    };
+    auto a = make_unique<Aligned>();
+    cout << "alignas(256) object address % 256 = "
+         << reinterpret_cast<uintptr_t>(a.get()) % 256 << "\n";
+    if (!blocksAreUsable()) {
+        cout << "allocator check FAILED\n";
+        return 1;
+    }
+    cout << "allocator check passed: all classes and alignments usable\n\n";
+
+    bench::registerCase("performanceComparison/make_unique_1M", uniquePointers);
+    bench::registerCase("performanceComparison/make_shared_1M", sharedPointers);
+    bench::registerCase("new_delete/pair", newDeletePair);
+    bench::registerCase("cross_thread/alloc_then_free_100k", crossThreadFree);
+    int rc = bench::runAll(argc, argv);
+
+    cout << '\n';
+    slab::print(cout, slab::stats());
+    return rc;
+}
+
+/*
+What to expect:
+- make_unique_1M / make_shared_1M: clearly faster than the
+  -DSLAB_ALLOCATOR_DISABLED build, since each allocation is a list pop
+  instead of a trip through malloc's bins.
+- new_delete/pair: a handful of nanoseconds (the freed block is the next
+  one handed out, so it stays in L1).
+- cross_thread: the producer's cache drains into the central list in
+  batches and the consumer's frees flow back the same way; the central
+  refills/releases printed at the end are a small fraction of the tens of
+  millions of allocations made by the benchmarks.
+*/
@@ -0,0 +1,195 @@
+/* ==========================================================================
+Lesson 9: Custom std::pmr Memory Resources and How to Compare Them
+
+Theory:
+---------
+good_performance_practices.cpp (item 17) creates a
+`std::pmr::monotonic_buffer_resource` and reserves a `pmr::vector` in it, but
+never measures whether it helped. Whether a memory resource pays off depends
+entirely on the allocation pattern of the container:
+
+- pmr::vector: few, growing allocations (reallocation on push_back).
+- pmr::map: one node per element, freed one by one.
+- pmr::unordered_map: one node per element plus a bucket array that is
+  reallocated on rehash.
+
+The standard library ships three resources (new_delete_resource,
+monotonic_buffer_resource, (un)synchronized_pool_resource). pmr_resources.h
+adds three custom ones: ArenaResource (bump pointer + rewind markers),
+ThreadLocalPoolResource (lock-free per-thread free lists) and StatsResource
+(counts calls, bytes and peak usage of any upstream resource).
+
+Key Points:
+- Bump allocators (monotonic, Arena) win when everything dies together: a
+  whole frame/request/query is released with one rewind.
+- Pools win for node-based containers with churn, because a freed node is
+  reused by the next insertion of the same size.
+- Wrapping a resource in StatsResource shows what a container really asks
+  for (e.g. how many bytes an unordered_map needs for its buckets).
+- Edge Cases: a container must not outlive its resource, and memory from a
+  rewound arena must not be touched again.
+
+Example:
+---------
+1. StatsResource report for each workload.
+2. Arena markers: rewind to a marker to drop temporary data.
+3. Benchmark suite: 3 workloads x 6 resources, using benchmark.h.
+
+Compile & run:
+    g++ -std=c++17 -O2 -pthread "9_Custom pmr Memory Resources.cpp" -o pmr
+    ./pmr
+    ./pmr --bench-filter=map/ --bench-format=csv
+========================================================================== */
+
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+
+#include "../28.Compiler and Low-Level Optimizations/benchmark.h"
+#include "pmr_resources.h"
+using namespace std;
+
+const int VECTOR_ELEMENTS = 100000;
+const int MAP_ELEMENTS = 10000;
+
+// --------------------------------------------------------------------------
+// Workloads: each builds a container in `mr` and destroys it.
+// --------------------------------------------------------------------------
+long long vectorWorkload(pmr::memory_resource* mr) {
+    pmr::vector<int> v(mr);
+    for (int i = 0; i < VECTOR_ELEMENTS; ++i) v.push_back(i);
+    return v.back();
+}
+
+long long mapWorkload(pmr::memory_resource* mr) {
+    pmr::map<int, int> m(mr);
+    for (int i = 0; i < MAP_ELEMENTS; ++i) m.emplace((i * 7919) % MAP_ELEMENTS, i);
+    // Churn: erase half and insert again (pools reuse the freed nodes).
+    for (int i = 0; i < MAP_ELEMENTS; i += 2) m.erase(i);
+    for (int i = 0; i < MAP_ELEMENTS; i += 2) m.emplace(i, i);
+    return static_cast<long long>(m.size());
+}
+
+long long unorderedMapWorkload(pmr::memory_resource* mr) {
+    pmr::unordered_map<int, int> m(mr);
+    for (int i = 0; i < MAP_ELEMENTS; ++i) m.emplace(i, i);
+    for (int i = 0; i < MAP_ELEMENTS; i += 2) m.erase(i);
+    for (int i = 0; i < MAP_ELEMENTS; i += 2) m.emplace(i, i);
+    return static_cast<long long>(m.size());
+}
+
+// --------------------------------------------------------------------------
+// Resources: how to create one, and how to reclaim everything between runs.
+// --------------------------------------------------------------------------
+struct ResourceKind {
+    string name;
+    function<shared_ptr<pmr::memory_resource>()> make;
+    function<void(pmr::memory_resource*)> reset;  // may be empty
+};
+
+vector<ResourceKind> resourceKinds() {
+    auto noReset = function<void(pmr::memory_resource*)>();
+    return {
+        {"new_delete",
+         [] {
+             // The global resource is not owned: use a no-op deleter.
+             return shared_ptr<pmr::memory_resource>(pmr::new_delete_resource(),
+                                                     [](pmr::memory_resource*) {});
+         },
+         noReset},
+        {"std_monotonic",
+         [] { return make_shared<pmr::monotonic_buffer_resource>(1 << 20); },
+         [](pmr::memory_resource* mr) {
+             static_cast<pmr::monotonic_buffer_resource*>(mr)->release();
+         }},
+        {"std_unsync_pool",
+         [] { return make_shared<pmr::unsynchronized_pool_resource>(); },
+         noReset},
+        {"std_sync_pool",
+         [] { return make_shared<pmr::synchronized_pool_resource>(); },
+         noReset},
+        {"arena",
+         [] { return make_shared<pmrx::ArenaResource>(8 << 20); },
+         [](pmr::memory_resource* mr) { static_cast<pmrx::ArenaResource*>(mr)->reset(); }},
+        {"thread_local_pool",
+         [] { return make_shared<pmrx::ThreadLocalPoolResource>(); },
+         noReset},
+    };
+}
+
+void registerSuite(const string& workloadName, long long (*workload)(pmr::memory_resource*)) {
+    for (const ResourceKind& kind : resourceKinds()) {
+        bench::registerCase(workloadName + "/" + kind.name, [kind, workload](bench::State& state) {
+            auto mr = kind.make();
+            for (auto _ : state) {
+                long long r = workload(mr.get());
+                bench::DoNotOptimize(r);
+                if (kind.reset) kind.reset(mr.get());
+            }
+        });
+    }
+}
+
+// --------------------------------------------------------------------------
+// 1. What does each container ask for?
+// --------------------------------------------------------------------------
+void printStats(const string& name, long long (*workload)(pmr::memory_resource*)) {
+    pmrx::StatsResource stats(pmr::new_delete_resource());
+    workload(&stats);
+    cout << "  " << name << ": " << stats.allocations() << " allocations, "
+         << stats.bytesAllocated() << " bytes requested, peak in use "
+         << stats.peakBytesInUse() << " bytes, in use after destruction "
+         << stats.bytesInUse() << '\n';
+}
+
+// --------------------------------------------------------------------------
+// 2. Arena markers
+// --------------------------------------------------------------------------
+void arenaMarkers() {
+    char buffer[4096];
+    pmrx::ArenaResource arena(buffer, sizeof(buffer), pmr::null_memory_resource());
+
+    pmr::vector<int> persistent(&arena);
+    persistent.reserve(100);
+    cout << "  after persistent data: " << arena.used() << " bytes used\n";
+
+    pmrx::ArenaResource::Marker m = arena.mark();
+    {
+        pmr::vector<int> scratch(&arena);
+        scratch.reserve(500);
+        cout << "  with scratch data:     " << arena.used() << " bytes used\n";
+    }
+    arena.rewind(m);  // drop the scratch data in O(1)
+    cout << "  after rewind:          " << arena.used() << " bytes used\n";
+}
+
+int main(int argc, char** argv) {
+    cout << "1. Allocation profile of each workload (StatsResource over new_delete):\n";
+    printStats("vector push_back x100k", vectorWorkload);
+    printStats("map insert/erase x10k", mapWorkload);
+    printStats("unordered_map insert/erase x10k", unorderedMapWorkload);
+
+    cout << "\n2. Arena rewind markers:\n";
+    arenaMarkers();
+
+    cout << "\n3. Benchmarks:\n";
+    registerSuite("vector", vectorWorkload);
+    registerSuite("map", mapWorkload);
+    registerSuite("unordered_map", unorderedMapWorkload);
+    return bench::runAll(argc, argv);
+}
+
+/*
+What to expect:
+- vector: only ~18 allocations (geometric growth), so every resource is
+  within noise of the others; the time goes into copying on reallocation.
+- map / unordered_map: tens of thousands of node allocations. Arena and
+  monotonic are the fastest (bump pointer, no frees), the pools come next
+  (free-list reuse), new_delete is the slowest. std_sync_pool pays for its
+  mutex compared with std_unsync_pool; thread_local_pool avoids the lock
+  while staying usable from several threads.
+*/
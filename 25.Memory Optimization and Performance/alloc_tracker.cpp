@@ -0,0 +1,406 @@
+/*
+File: alloc_tracker.cpp
+Description:
+  Implementation of alloc_tracker.h: replacement global operator new/delete
+  (all standard forms) with a size header and per-thread counters.
+
+  Hot path of `new`:  malloc + write 16-byte header + 3 relaxed stores to the
+                      calling thread's own slot (no lock, no atomic RMW).
+  Cold paths:         first allocation of a thread (claims a slot), thread exit
+                      (folds the slot into the "retired" totals), snapshot().
+                      These take a tiny spin lock.
+
+  Sampling: a per-thread byte countdown triggers the optional sampling hook
+  (see setSamplingHooks); the block's tag is kept in its header so the free
+  hook can be called when it is released.
+
+  Compile with -DALLOC_TRACKER_DISABLED to leave the system operators alone.
+*/
+
+#include "alloc_tracker.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <ostream>
+
+namespace alloctrack {
+
+namespace {
+
+#ifndef ALLOC_TRACKER_DISABLED
+
+const int kMaxThreads = 256;
+
+// One cache line (or more) per thread so counters never false-share.
+struct alignas(64) Slot {
+    std::atomic<bool> inUse{false};
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> deallocations{0};
+    std::atomic<std::uint64_t> bytesAllocated{0};
+    std::atomic<std::uint64_t> bytesFreed{0};
+    std::atomic<std::uint64_t> histogram[kSizeBuckets];
+};
+
+// All of these are constant-initialized, so they are usable from the very
+// first allocation (before main) to the very last (after static destructors).
+Slot gSlots[kMaxThreads];
+Slot gShared;   // used by threads that found no free slot, or have exited
+Slot gRetired;  // totals of threads that have exited
+std::atomic_flag gLock = ATOMIC_FLAG_INIT;
+std::atomic<std::uint64_t> gPeakLive{0};
+
+thread_local Slot* tSlot = nullptr;
+thread_local bool tRetired = false;
+thread_local bool tAcquiring = false;
+
+void lock() {
+    while (gLock.test_and_set(std::memory_order_acquire)) {
+    }
+}
+void unlock() { gLock.clear(std::memory_order_release); }
+
+// Single-writer increment: only the owning thread writes its slot, so a
+// load + store is enough and avoids the `lock` prefix of fetch_add.
+inline void bump(std::atomic<std::uint64_t>& c, std::uint64_t n, bool shared) {
+    if (shared) c.fetch_add(n, std::memory_order_relaxed);
+    else c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+void moveInto(Slot& from, Slot& to) {
+    auto move = [](std::atomic<std::uint64_t>& a, std::atomic<std::uint64_t>& b) {
+        b.fetch_add(a.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+    };
+    move(from.allocations, to.allocations);
+    move(from.deallocations, to.deallocations);
+    move(from.bytesAllocated, to.bytesAllocated);
+    move(from.bytesFreed, to.bytesFreed);
+    for (int i = 0; i < kSizeBuckets; ++i) move(from.histogram[i], to.histogram[i]);
+}
+
+void retireSlot();
+
+// Folds the thread's slot into gRetired when the thread exits.
+struct SlotReleaser {
+    void arm() {}
+    ~SlotReleaser() { retireSlot(); }
+};
+thread_local SlotReleaser tReleaser;
+
+Slot* acquireSlot() {
+    if (tRetired || tAcquiring) return &gShared;
+    tAcquiring = true;  // registering the thread_local destructor may allocate
+    Slot* found = &gShared;
+    lock();
+    for (Slot& s : gSlots) {
+        if (!s.inUse.load(std::memory_order_relaxed)) {
+            s.inUse.store(true, std::memory_order_relaxed);
+            found = &s;
+            break;
+        }
+    }
+    unlock();
+    if (found != &gShared) {
+        tSlot = found;
+        tReleaser.arm();
+    }
+    tAcquiring = false;
+    return found;
+}
+
+void retireSlot() {
+    Slot* s = tSlot;
+    tSlot = nullptr;
+    tRetired = true;
+    if (!s) return;
+    lock();
+    moveInto(*s, gRetired);
+    s->inUse.store(false, std::memory_order_relaxed);
+    unlock();
+}
+
+inline Slot* currentSlot() {
+    Slot* s = tSlot;
+    return s ? s : acquireSlot();
+}
+
+inline int bucketOf(std::size_t size) {
+    if (size == 0) return 0;
+    int bits = 64 - __builtin_clzll(static_cast<unsigned long long>(size));
+    return bits < kSizeBuckets ? bits : kSizeBuckets - 1;
+}
+
+// --------------------------------------------------------------------------
+// Sampling
+// --------------------------------------------------------------------------
+std::atomic<SampleHook> gSampleHook{nullptr};
+std::atomic<FreeHook> gFreeHook{nullptr};
+std::atomic<std::size_t> gMeanBytes{512 * 1024};
+
+const std::int64_t kRecheckBytes = 1 << 20;  // how often idle threads look for a hook
+
+thread_local std::int64_t tUntilSample = 0;
+thread_local std::uint64_t tRng = 0;
+thread_local bool tInHook = false;
+
+// Exponentially distributed gap with the configured mean (inverse CDF of a
+// uniform draw from a per-thread xorshift generator).
+std::int64_t nextSampleGap() {
+    if (tRng == 0) tRng = reinterpret_cast<std::uintptr_t>(&tRng) | 1;
+    tRng ^= tRng << 13;
+    tRng ^= tRng >> 7;
+    tRng ^= tRng << 17;
+    double u = (static_cast<double>(tRng >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+    double mean = static_cast<double>(gMeanBytes.load(std::memory_order_relaxed));
+    return static_cast<std::int64_t>(-std::log(u) * mean) + 1;
+}
+
+// Slow path, taken when the countdown crosses zero. Returns the tag to store.
+std::uint32_t maybeSample(void* user, std::size_t size) {
+    SampleHook hook = gSampleHook.load(std::memory_order_acquire);
+    if (!hook) {
+        tUntilSample = kRecheckBytes;
+        return 0;
+    }
+    tUntilSample = nextSampleGap();
+    if (tInHook) return 0;  // the hook itself allocated
+    tInHook = true;
+    std::uint32_t tag = hook(user, size) & 0x7fffffffu;
+    tInHook = false;
+    return tag;
+}
+
+inline void recordAlloc(std::size_t size) {
+    Slot* s = currentSlot();
+    bool shared = (s == &gShared);
+    bump(s->allocations, 1, shared);
+    bump(s->bytesAllocated, size, shared);
+    bump(s->histogram[bucketOf(size)], 1, shared);
+}
+
+inline void recordFree(std::size_t size) {
+    Slot* s = currentSlot();
+    bool shared = (s == &gShared);
+    bump(s->deallocations, 1, shared);
+    bump(s->bytesFreed, size, shared);
+}
+
+// --------------------------------------------------------------------------
+// Size header
+// --------------------------------------------------------------------------
+//
+//   raw                 header            user pointer
+//   |<--- padding --->|<--- 16 bytes --->|<--- size bytes --->|
+//
+// `offset` is user - raw, so free() gets back the malloc'ed pointer for both
+// normal and over-aligned blocks. `tag` is the sampling tag (0 = not sampled).
+struct Header {
+    std::size_t size;
+    std::uint32_t offset;
+    std::uint32_t tag;
+};
+const std::size_t kHeaderSize = 16;
+static_assert(sizeof(Header) <= kHeaderSize, "header must fit in 16 bytes");
+static_assert(alignof(std::max_align_t) <= kHeaderSize, "header breaks alignment");
+
+inline Header* headerOf(void* user) {
+    return reinterpret_cast<Header*>(static_cast<char*>(user) - kHeaderSize);
+}
+
+void* allocate(std::size_t size, std::size_t align) noexcept {
+    if (align > (1u << 30)) return nullptr;  // offset must fit in 32 bits
+    std::size_t extra = kHeaderSize + (align > kHeaderSize ? align : 0);
+    if (size > static_cast<std::size_t>(-1) - extra) return nullptr;
+    char* raw = static_cast<char*>(std::malloc(size + extra));
+    if (!raw) return nullptr;
+
+    char* user = raw + kHeaderSize;
+    if (align > kHeaderSize) {
+        std::uintptr_t p = reinterpret_cast<std::uintptr_t>(user);
+        p = (p + align - 1) & ~(static_cast<std::uintptr_t>(align) - 1);
+        user = reinterpret_cast<char*>(p);
+    }
+    Header* h = headerOf(user);
+    h->size = size;
+    h->offset = static_cast<std::uint32_t>(user - raw);
+    h->tag = 0;
+    recordAlloc(size);
+    tUntilSample -= static_cast<std::int64_t>(size);
+    if (tUntilSample < 0) h->tag = maybeSample(user, size);
+    return user;
+}
+
+void* allocateOrThrow(std::size_t size, std::size_t align) {
+    for (;;) {
+        if (void* p = allocate(size, align)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* allocateNoThrow(std::size_t size, std::size_t align) noexcept {
+    try {
+        return allocateOrThrow(size, align);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void deallocate(void* user) noexcept {
+    if (!user) return;
+    Header* h = headerOf(user);
+    recordFree(h->size);
+    if (h->tag != 0) {
+        FreeHook hook = gFreeHook.load(std::memory_order_acquire);
+        if (hook && !tInHook) {
+            tInHook = true;
+            hook(h->tag, h->size);
+            tInHook = false;
+        }
+    }
+    std::free(static_cast<char*>(user) - h->offset);
+}
+
+#endif  // ALLOC_TRACKER_DISABLED
+
+}  // namespace
+
+bool enabled() {
+#ifdef ALLOC_TRACKER_DISABLED
+    return false;
+#else
+    return true;
+#endif
+}
+
+void setSamplingHooks(SampleHook onSample, FreeHook onFree, std::size_t meanBytes) {
+#ifndef ALLOC_TRACKER_DISABLED
+    gMeanBytes.store(meanBytes ? meanBytes : 1, std::memory_order_relaxed);
+    gFreeHook.store(onFree, std::memory_order_release);
+    gSampleHook.store(onSample, std::memory_order_release);
+    tUntilSample = 0;  // the calling thread starts sampling right away
+#else
+    (void)onSample;
+    (void)onFree;
+    (void)meanBytes;
+#endif
+}
+
+void clearSamplingHooks() {
+#ifndef ALLOC_TRACKER_DISABLED
+    gSampleHook.store(nullptr, std::memory_order_release);
+    gFreeHook.store(nullptr, std::memory_order_release);
+#endif
+}
+
+Snapshot snapshot() {
+    Snapshot out;
+#ifndef ALLOC_TRACKER_DISABLED
+    auto add = [&out](const Slot& s) {
+        out.allocations += s.allocations.load(std::memory_order_relaxed);
+        out.deallocations += s.deallocations.load(std::memory_order_relaxed);
+        out.bytesAllocated += s.bytesAllocated.load(std::memory_order_relaxed);
+        out.bytesFreed += s.bytesFreed.load(std::memory_order_relaxed);
+        for (int i = 0; i < kSizeBuckets; ++i)
+            out.sizeHistogram[i] += s.histogram[i].load(std::memory_order_relaxed);
+    };
+    lock();
+    for (const Slot& s : gSlots) {
+        if (s.inUse.load(std::memory_order_relaxed)) {
+            add(s);
+            ++out.activeThreads;
+        }
+    }
+    add(gShared);
+    add(gRetired);
+    unlock();
+
+    out.liveBytes = out.bytesAllocated - out.bytesFreed;
+    std::uint64_t peak = gPeakLive.load(std::memory_order_relaxed);
+    while (out.liveBytes > peak &&
+           !gPeakLive.compare_exchange_weak(peak, out.liveBytes, std::memory_order_relaxed)) {
+    }
+    out.peakLiveBytes = out.liveBytes > peak ? out.liveBytes : peak;
+#endif
+    return out;
+}
+
+void print(std::ostream& os, const Snapshot& s) {
+    if (!enabled()) {
+        os << "[alloctrack] disabled (built with ALLOC_TRACKER_DISABLED)\n";
+        return;
+    }
+    os << "[alloctrack] allocations:   " << s.allocations << '\n'
+       << "[alloctrack] deallocations: " << s.deallocations << '\n'
+       << "[alloctrack] bytes alloc'd: " << s.bytesAllocated << '\n'
+       << "[alloctrack] bytes freed:   " << s.bytesFreed << '\n'
+       << "[alloctrack] live bytes:    " << s.liveBytes << '\n'
+       << "[alloctrack] peak (seen):   " << s.peakLiveBytes << '\n'
+       << "[alloctrack] threads:       " << s.activeThreads << '\n'
+       << "[alloctrack] size histogram:\n";
+    for (int i = 0; i < kSizeBuckets; ++i) {
+        if (s.sizeHistogram[i] == 0) continue;
+        std::uint64_t lo = i == 0 ? 0 : (1ull << (i - 1));
+        std::uint64_t hi = i == 0 ? 0 : (1ull << i) - 1;
+        os << "    " << std::setw(10) << lo << " - " << std::setw(10) << hi << " B : "
+           << s.sizeHistogram[i] << '\n';
+    }
+}
+
+}  // namespace alloctrack
+
+// ==========================================================================
+// Replacement operators (every form the standard allows to replace)
+// ==========================================================================
+#ifndef ALLOC_TRACKER_DISABLED
+
+using alloctrack::allocateNoThrow;
+using alloctrack::allocateOrThrow;
+using alloctrack::deallocate;
+
+static const std::size_t kDefaultAlign = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+void* operator new(std::size_t size) { return allocateOrThrow(size, kDefaultAlign); }
+void* operator new[](std::size_t size) { return allocateOrThrow(size, kDefaultAlign); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return allocateNoThrow(size, kDefaultAlign);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return allocateNoThrow(size, kDefaultAlign);
+}
+void* operator new(std::size_t size, std::align_val_t al) {
+    return allocateOrThrow(size, static_cast<std::size_t>(al));
+}
+void* operator new[](std::size_t size, std::align_val_t al) {
+    return allocateOrThrow(size, static_cast<std::size_t>(al));
+}
+void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return allocateNoThrow(size, static_cast<std::size_t>(al));
+}
+void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return allocateNoThrow(size, static_cast<std::size_t>(al));
+}
+
+// The header already knows the size and alignment, so every delete form
+// shares one implementation.
+void operator delete(void* p) noexcept { deallocate(p); }
+void operator delete[](void* p) noexcept { deallocate(p); }
+void operator delete(void* p, std::size_t) noexcept { deallocate(p); }
+void operator delete[](void* p, std::size_t) noexcept { deallocate(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { deallocate(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { deallocate(p); }
+void operator delete(void* p, std::align_val_t) noexcept { deallocate(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { deallocate(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { deallocate(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { deallocate(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    deallocate(p);
+}
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    deallocate(p);
+}
+
+#endif  // ALLOC_TRACKER_DISABLED
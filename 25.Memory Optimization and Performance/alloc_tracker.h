@@ -0,0 +1,98 @@
+/* ==========================================================================
+alloc_tracker.h - Thread-Safe, Low-Overhead Allocation Tracking
+
+Theory:
+---------
+Lesson 5 tracks allocations with a global std::map<void*, size_t> and prints
+on every call. That is fine to learn the idea, but:
+- it is not thread-safe (two threads inserting into the map = data race),
+- the map allocates its own nodes, re-entering operator new,
+- a map lookup plus a `cout` per allocation makes the program orders of
+  magnitude slower, so it can never stay enabled in a load test.
+
+This tracker (implemented in alloc_tracker.cpp) instead:
+1. Stores the size in a 16-byte header in front of every block, so delete
+   knows the size without any lookup table.
+2. Counts in per-thread slots. The owning thread is the only writer, so the
+   hot path is a few plain (relaxed) stores: no lock, no shared cache line.
+3. Aggregates the slots only when you ask for a snapshot().
+4. Never does I/O on the hot path.
+5. Covers every replaceable form: scalar/array, nothrow, sized and aligned.
+
+Key Points:
+- Link alloc_tracker.cpp into the program; the header only declares the API.
+- Compile alloc_tracker.cpp with -DALLOC_TRACKER_DISABLED to get the plain
+  system allocator and measure the tracker's overhead.
+- peakLiveBytes is the high-water mark *seen by snapshots*, not an exact
+  global peak: tracking an exact peak needs a shared counter on every call.
+- Edge Cases: memory freed on another thread is credited to the freeing
+  thread, so per-thread "live" values can be negative; only the total is
+  meaningful.
+
+Usage:
+---------
+    #include "alloc_tracker.h"
+    ...
+    alloctrack::Snapshot s = alloctrack::snapshot();
+    alloctrack::print(std::cout, s);
+
+    g++ -std=c++17 -O2 main.cpp alloc_tracker.cpp -o main -pthread
+========================================================================== */
+
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+namespace alloctrack {
+
+// Power-of-two size histogram: bucket i counts allocations of size in
+// [2^(i-1), 2^i), bucket 0 counts zero-byte requests.
+const int kSizeBuckets = 40;
+
+struct Snapshot {
+    std::uint64_t allocations = 0;
+    std::uint64_t deallocations = 0;
+    std::uint64_t bytesAllocated = 0;
+    std::uint64_t bytesFreed = 0;
+    std::uint64_t liveBytes = 0;      // bytesAllocated - bytesFreed
+    std::uint64_t peakLiveBytes = 0;  // highest liveBytes seen by snapshot()
+    int activeThreads = 0;            // threads currently owning a slot
+    std::uint64_t sizeHistogram[kSizeBuckets] = {};
+};
+
+// Sums the per-thread counters (plus those of threads that have exited).
+// Safe to call from any thread at any time; takes a short lock that the
+// allocation hot path never touches.
+Snapshot snapshot();
+
+// Prints a snapshot as a small report (does not allocate through the tracker
+// more than the stream itself does).
+void print(std::ostream& os, const Snapshot& s);
+
+// Whether the operators in alloc_tracker.cpp were compiled in.
+bool enabled();
+
+// --------------------------------------------------------------------------
+// Sampling hook (used by heap_profiler.cpp)
+// --------------------------------------------------------------------------
+// Every thread keeps a byte countdown. When an allocation brings it below
+// zero, onSample(ptr, size) is called and the countdown is re-drawn from an
+// exponential distribution with mean `meanBytes` (Poisson sampling, as in
+// tcmalloc): large blocks are almost always sampled, tiny ones rarely, and
+// the hot path only pays one subtraction and one branch.
+//
+// onSample returns a non-zero tag to remember the block; when that block is
+// freed, onFree(tag, size) is called. Tags must fit in 31 bits.
+// Threads pick up newly installed hooks within about 1 MB of allocation.
+using SampleHook = std::uint32_t (*)(void* ptr, std::size_t size);
+using FreeHook = void (*)(std::uint32_t tag, std::size_t size);
+
+void setSamplingHooks(SampleHook onSample, FreeHook onFree, std::size_t meanBytes);
+void clearSamplingHooks();
+
+}  // namespace alloctrack
+
+#endif  // ALLOC_TRACKER_H
@@ -54,6 +54,8 @@
 #include <cmath>  // For log2() and pow()
 #include <iostream>
 #include <vector>
+
+#include "merge_sort.h"
 using namespace std;
 
 // O(1): Constant time complexity
@@ -88,36 +90,18 @@ int linearSearch(const int arr[], int n, int target) {
 }
 
 // O(n log n): Linearithmic time complexity (Merge Sort)
-void merge(vector<int> &arr, int left, int mid, int right) {
-    int n1 = mid - left + 1;
-    int n2 = right - mid;
-    vector<int> L(n1), R(n2);
-
-    for (int i = 0; i < n1; i++)
-        L[i] = arr[left + i];
-    for (int i = 0; i < n2; i++)
-        R[i] = arr[mid + 1 + i];
-
-    int i = 0, j = 0, k = left;
-    while (i < n1 && j < n2) {
-        if (L[i] <= R[j])
-            arr[k++] = L[i++];
-        else
-            arr[k++] = R[j++];
-    }
-    while (i < n1)
-        arr[k++] = L[i++];
-    while (j < n2)
-        arr[k++] = R[j++];
-}
-
+// Bottom-up merge sort from merge_sort.h: insertion sort on runs of 32
+// elements, then merge passes that ping-pong between arr and one scratch
+// buffer. The scratch buffer is kept per thread and reused, so repeated calls
+// do not allocate (the recursive version allocated two vectors per merge).
 void mergeSort(vector<int> &arr, int left, int right) {
-    if (left < right) {
-        int mid = left + (right - left) / 2;
-        mergeSort(arr, left, mid);
-        mergeSort(arr, mid + 1, right);
-        merge(arr, left, mid, right);
-    }
+    if (left >= right)
+        return;
+    static thread_local vector<int> scratch;
+    size_t n = right - left + 1;
+    if (scratch.size() < n)
+        scratch.resize(n);
+    msort::mergeSort(arr.data() + left, arr.data() + right + 1, scratch.data());
 }
 
 // O(n^2): Quadratic time complexity (Bubble Sort)
@@ -151,6 +135,9 @@ void generatePermutations(string str, int l, int r) {
     }
 }
 
+// Define COMPLEXITY_NO_MAIN to reuse the functions above without this demo
+// (11_Empirical Complexity Fitting.cpp measures them).
+#ifndef COMPLEXITY_NO_MAIN
 int main() {
     int n = 5;  // You can change this to test larger sizes
     int arr[] = {10, 20, 30, 40, 50};
@@ -195,6 +182,7 @@ int main() {
 
     return 0;
 }
+#endif  // COMPLEXITY_NO_MAIN
 
 /*
     Output Example (for n = 5):
@@ -0,0 +1,212 @@
+/* ==========================================================================
+fast_writer.h - Buffered Output Without iostream
+
+Theory:
+---------
+Lesson 3 shows that '\n' is faster than std::endl because it does not
+flush. Even without flushes, every `cout << x` still pays for:
+- a sentry object (checks the stream state, flushes a tied stream),
+- a locale lookup and a virtual call into the num_put facet to format x,
+- a virtual call into the streambuf for the characters,
+- with sync_with_stdio(true) (the default), a trip through C stdio too.
+
+fastout::Writer keeps only what is needed to put bytes in a file:
+1. One large user-space buffer (64 KiB by default). Values are formatted
+   directly into it; nothing is virtual and nothing allocates.
+2. Numbers are converted by numfmt::toChars (5.strings/number_format.h):
+   integers two digits at a time from a table of digit pairs, doubles as
+   the shortest text that reads back to the same value ("0.1", not
+   "0.10000000000000001"), without a locale.
+3. When the buffer is full it is handed to write(2) in one call. Nothing
+   else flushes: flush() is the only explicit flush point, and the
+   destructor flushes what is left.
+
+Key Points:
+- `out << a << ' ' << b << '\n';` works as with cout, for integers,
+  floating point, bool, char, C strings, std::string and string_view.
+- `out.print("{} + {} = {}\n", a, b, a + b);` is a small fmt-style API:
+  each "{}" takes the next argument, "{{" and "}}" print braces. A
+  mismatch between placeholders and arguments throws std::invalid_argument.
+- `fastout::fixed(x, 2)` prints x with 2 decimals ("3.14").
+- Write errors throw std::system_error from flush() (and from the insertion
+  that fills the buffer); the destructor swallows them.
+- Edge Cases: the Writer owns its buffer but not the file descriptor. Mixing
+  it with cout/printf on the same descriptor interleaves output in flush
+  order, so flush one before using the other.
+========================================================================== */
+
+#ifndef FAST_WRITER_H
+#define FAST_WRITER_H
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+#include "../5.strings/number_format.h"
+
+namespace fastout {
+
+// `out << fixed(x, n)` prints x with n (0..60) digits after the point.
+struct Fixed {
+    double value;
+    int precision;
+};
+
+inline Fixed fixed(double value, int precision) { return {value, precision}; }
+
+class Writer {
+public:
+    static constexpr std::size_t kDefaultBufferSize = 64 * 1024;
+
+    explicit Writer(int fd = STDOUT_FILENO, std::size_t bufferSize = kDefaultBufferSize)
+        : fd_(fd),
+          size_(bufferSize < 64 ? 64 : bufferSize),
+          buffer_(new char[size_]) {}
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    ~Writer() {
+        try {
+            flush();
+        } catch (...) {
+        }
+    }
+
+    // Hands the buffered bytes to the kernel with write(2).
+    void flush() {
+        const char* p = buffer_.get();
+        std::size_t n = used_;
+        used_ = 0;
+        writeAll(p, n);
+    }
+
+    std::size_t buffered() const { return used_; }
+
+    Writer& write(const char* data, std::size_t n) {
+        if (n <= size_ - used_) {
+            std::memcpy(buffer_.get() + used_, data, n);
+            used_ += n;
+            return *this;
+        }
+        flush();
+        if (n >= size_) {
+            writeAll(data, n);  // too large to buffer: one write(2) of its own
+        } else {
+            std::memcpy(buffer_.get(), data, n);
+            used_ = n;
+        }
+        return *this;
+    }
+
+    Writer& operator<<(char c) {
+        if (used_ == size_) flush();
+        buffer_[used_++] = c;
+        return *this;
+    }
+
+    Writer& operator<<(std::string_view s) { return write(s.data(), s.size()); }
+    Writer& operator<<(const char* s) { return write(s, std::strlen(s)); }
+    Writer& operator<<(const std::string& s) { return write(s.data(), s.size()); }
+    Writer& operator<<(bool b) { return b ? write("true", 4) : write("false", 5); }
+
+    template <class T, std::enable_if_t<std::is_arithmetic<T>::value &&
+                                            !std::is_same<T, long double>::value,
+                                        int> = 0>
+    Writer& operator<<(T value) {
+        char* p = reserve(numfmt::kMaxChars);
+        used_ = static_cast<std::size_t>(numfmt::toChars(p, value) - buffer_.get());
+        return *this;
+    }
+
+    Writer& operator<<(long double value) {
+        char* p = reserve(64);
+        used_ = static_cast<std::size_t>(std::to_chars(p, p + 64, value).ptr - buffer_.get());
+        return *this;
+    }
+
+    Writer& operator<<(Fixed f) {
+        char text[400];  // 1e308 has 309 digits before the point
+        int precision = f.precision < 0 ? 0 : (f.precision > 60 ? 60 : f.precision);
+        auto r = std::to_chars(text, text + sizeof(text), f.value, std::chars_format::fixed,
+                               precision);
+        return write(text, static_cast<std::size_t>(r.ptr - text));
+    }
+
+    // fmt-style output: each "{}" in format is replaced by the next argument.
+    template <class... Args>
+    Writer& print(std::string_view format, const Args&... args) {
+        std::size_t pos = printFrom(format, 0, args...);
+        if (nextPlaceholder(format, pos) != std::string_view::npos)
+            throw std::invalid_argument("fastout::print: more {} than arguments");
+        return *this;
+    }
+
+private:
+    // A pointer to at least n free bytes of the buffer.
+    char* reserve(std::size_t n) {
+        if (size_ - used_ < n) flush();
+        return buffer_.get() + used_;
+    }
+
+    void writeAll(const char* p, std::size_t n) {
+        while (n > 0) {
+            ssize_t w = ::write(fd_, p, n);
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                throw std::system_error(errno, std::generic_category(), "fastout::Writer write");
+            }
+            p += w;
+            n -= static_cast<std::size_t>(w);
+        }
+    }
+
+    // Writes the literal text of format from pos up to the next "{}",
+    // unescaping "{{" and "}}". Returns the position of the "{}", or npos
+    // (after writing the rest) if there is none.
+    std::size_t nextPlaceholder(std::string_view format, std::size_t pos) {
+        const char* f = format.data();
+        const std::size_t n = format.size();
+        for (;;) {
+            std::size_t brace = pos;
+            while (brace < n && f[brace] != '{' && f[brace] != '}') ++brace;
+            if (brace > pos) write(f + pos, brace - pos);
+            if (brace == n) return std::string_view::npos;
+            if (brace + 1 < n && f[brace + 1] == '}' && f[brace] == '{') return brace;
+            if (brace + 1 == n || f[brace + 1] != f[brace])
+                throw std::invalid_argument("fastout::print: lone brace in format");
+            *this << f[brace];  // "{{" or "}}"
+            pos = brace + 2;
+        }
+    }
+
+    std::size_t printFrom(std::string_view, std::size_t pos) { return pos; }
+
+    template <class First, class... Rest>
+    std::size_t printFrom(std::string_view format, std::size_t pos, const First& first,
+                          const Rest&... rest) {
+        std::size_t at = nextPlaceholder(format, pos);
+        if (at == std::string_view::npos)
+            throw std::invalid_argument("fastout::print: more arguments than {}");
+        *this << first;
+        return printFrom(format, at + 2, rest...);
+    }
+
+    int fd_;
+    std::size_t size_;
+    std::unique_ptr<char[]> buffer_;
+    std::size_t used_ = 0;
+};
+
+}  // namespace fastout
+
+#endif  // FAST_WRITER_H
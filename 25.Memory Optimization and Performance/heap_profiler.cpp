@@ -0,0 +1,381 @@
+/*
+File: heap_profiler.cpp
+Description:
+  Implementation of heap_profiler.h on top of alloc_tracker's sampling hook.
+
+  Sampling path (about once per Options::sampleBytes allocated bytes):
+    backtrace() -> hash the stack -> find/insert it in a fixed open-addressed
+    table under a spin lock -> add the sample. The table lives in malloc'ed
+    memory and nothing on this path calls operator new, so the profiler can
+    neither recurse into itself nor deadlock on its own lock.
+
+  Dumping copies the table under the lock (with malloc), releases the lock,
+  and only then symbolizes and formats, which does allocate.
+*/
+
+#include "heap_profiler.h"
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "alloc_tracker.h"
+
+namespace heapprof {
+
+namespace {
+
+const int kMaxDepth = 48;
+const std::size_t kTableSize = 1 << 13;  // distinct call sites (power of two)
+
+struct Site {
+    std::uint64_t hash;
+    int depth;  // 0 = empty slot
+    void* frames[kMaxDepth];
+    // Raw sample counts (what pprof's heap_v2 format expects).
+    std::int64_t sampledAllocs, sampledAllocBytes, sampledInUse, sampledInUseBytes;
+    // Unbiased estimates of the real totals.
+    double allocCount, allocBytes, inUseCount, inUseBytes;
+};
+
+Site* gSites = nullptr;  // calloc'ed, never freed (used until exit)
+std::size_t gSiteCount = 0;
+std::atomic_flag gLock = ATOMIC_FLAG_INIT;
+std::atomic<bool> gRunning{false};
+Options gOptions;
+double gMean = 512 * 1024;
+int gPipe[2] = {-1, -1};
+
+// Number of frames between onSample and the code that called operator new
+// (maybeSample, allocate, operator new, ...). Measured once in start().
+int gSkipFrames = 0;
+std::atomic<bool> gCalibrating{false};
+
+// Set on threads that belong to the profiler (dumping, signal thread): their
+// allocations are not sampled.
+thread_local bool tInternal = false;
+
+void lock() {
+    while (gLock.test_and_set(std::memory_order_acquire)) {
+    }
+}
+void unlock() { gLock.clear(std::memory_order_release); }
+
+// Inverse of the sampling probability of a block of `size` bytes.
+double weightOf(std::size_t size) {
+    double p = 1.0 - std::exp(-static_cast<double>(size) / gMean);
+    return p > 1e-12 ? 1.0 / p : 1.0;
+}
+
+std::uint64_t hashFrames(void* const* frames, int depth) {
+    std::uint64_t h = 1469598103934665603ull;  // FNV-1a
+    for (int i = 0; i < depth; ++i) {
+        h ^= reinterpret_cast<std::uintptr_t>(frames[i]);
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// A known caller of operator new: the first frame inside it marks where the
+// allocator's own frames end.
+__attribute__((noinline)) void calibrationCaller() {
+    char* volatile p = new char[1];
+    delete[] p;
+}
+
+void calibrate(void** frames, int depth) {
+    char* begin = reinterpret_cast<char*>(&calibrationCaller);
+    for (int i = 0; i < depth; ++i) {
+        char* pc = static_cast<char*>(frames[i]);
+        if (pc > begin && pc < begin + 256) {
+            gSkipFrames = i;
+            return;
+        }
+    }
+}
+
+std::uint32_t onSample(void*, std::size_t size) {
+    if (!gSites) return 0;
+    void* frames[kMaxDepth + 1];
+    if (gCalibrating.load(std::memory_order_relaxed)) {
+        calibrate(frames + 1, backtrace(frames, kMaxDepth + 1) - 1);
+        return 0;
+    }
+    if (tInternal) return 0;
+    int depth = backtrace(frames, kMaxDepth + 1) - 1;  // drop onSample itself
+    depth -= gSkipFrames;
+    if (depth <= 0) return 0;
+    void** stack = frames + 1 + gSkipFrames;
+    std::uint64_t h = hashFrames(stack, depth);
+    double w = weightOf(size);
+
+    lock();
+    std::size_t i = h & (kTableSize - 1);
+    for (std::size_t probes = 0; probes < kTableSize; ++probes, i = (i + 1) & (kTableSize - 1)) {
+        Site& s = gSites[i];
+        if (s.depth == 0) {
+            if (gSiteCount + 1 >= kTableSize) break;  // full: drop the sample
+            s.hash = h;
+            s.depth = depth;
+            std::memcpy(s.frames, stack, depth * sizeof(void*));
+            ++gSiteCount;
+        } else if (s.hash != h || s.depth != depth ||
+                   std::memcmp(s.frames, stack, depth * sizeof(void*)) != 0) {
+            continue;
+        }
+        s.sampledAllocs += 1;
+        s.sampledAllocBytes += size;
+        s.sampledInUse += 1;
+        s.sampledInUseBytes += size;
+        s.allocCount += w;
+        s.allocBytes += w * size;
+        s.inUseCount += w;
+        s.inUseBytes += w * size;
+        unlock();
+        return static_cast<std::uint32_t>(i + 1);
+    }
+    unlock();
+    return 0;
+}
+
+void onFree(std::uint32_t tag, std::size_t size) {
+    if (!gSites || tag == 0 || tag > kTableSize) return;
+    double w = weightOf(size);
+    lock();
+    Site& s = gSites[tag - 1];
+    s.sampledInUse -= 1;
+    s.sampledInUseBytes -= size;
+    s.inUseCount -= w;
+    s.inUseBytes -= w * size;
+    unlock();
+}
+
+// --------------------------------------------------------------------------
+// Symbolization and output
+// --------------------------------------------------------------------------
+
+std::string symbolize(void* addr) {
+    // Return addresses point after the call; -1 lands inside the call site.
+    void* pc = static_cast<char*>(addr) - 1;
+    Dl_info info;
+    if (dladdr(pc, &info) && info.dli_sname) {
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        std::string name = (status == 0 && demangled) ? demangled : info.dli_sname;
+        std::free(demangled);
+        return name;
+    }
+    char buf[256];
+    if (dladdr(pc, &info) && info.dli_fname) {
+        const char* base = std::strrchr(info.dli_fname, '/');
+        std::snprintf(buf, sizeof(buf), "%s+0x%lx", base ? base + 1 : info.dli_fname,
+                      static_cast<unsigned long>(static_cast<char*>(pc) -
+                                                 static_cast<char*>(info.dli_fbase)));
+    } else {
+        std::snprintf(buf, sizeof(buf), "0x%lx", reinterpret_cast<unsigned long>(pc));
+    }
+    return buf;
+}
+
+// Frames of the allocator machinery that calibration did not remove (e.g. a
+// different inlining of the nothrow or aligned forms).
+bool isInternalFrame(const std::string& name) {
+    return name.find("operator new") != std::string::npos ||
+           name.find("alloctrack::") != std::string::npos ||
+           name.find("heapprof::") != std::string::npos;
+}
+
+// Index of the first frame that belongs to the program, not to the allocator.
+int firstUserFrame(const Site& s, std::vector<std::string>& names) {
+    names.clear();
+    for (int i = 0; i < s.depth; ++i) names.push_back(symbolize(s.frames[i]));
+    int first = 0;
+    for (int i = 0; i < s.depth; ++i)
+        if (isInternalFrame(names[i])) first = i + 1;
+    return first < s.depth ? first : 0;
+}
+
+std::vector<Site> copySites() {
+    // Copy with malloc while holding the lock: operator new here could sample
+    // and try to take the lock again.
+    Site* copy = static_cast<Site*>(std::malloc(sizeof(Site) * kTableSize));
+    std::size_t n = 0;
+    if (copy && gSites) {
+        lock();
+        for (std::size_t i = 0; i < kTableSize; ++i)
+            if (gSites[i].depth != 0) copy[n++] = gSites[i];
+        unlock();
+    }
+    std::vector<Site> sites(copy, copy + n);
+    std::free(copy);
+    return sites;
+}
+
+void writeFolded(std::ostream& out, const std::vector<Site>& sites) {
+    std::vector<std::string> names;
+    for (const Site& s : sites) {
+        double value = gOptions.metric == Metric::InUseBytes ? s.inUseBytes : s.allocBytes;
+        long long bytes = std::llround(value);
+        if (bytes <= 0) continue;
+        int first = firstUserFrame(s, names);
+        // Folded stacks are root first: main;f;g <value>
+        for (int i = s.depth - 1; i >= first; --i) {
+            out << names[i];
+            if (i != first) out << ';';
+        }
+        out << ' ' << bytes << '\n';
+    }
+}
+
+void writePprof(std::ostream& out, const std::vector<Site>& sites) {
+    std::int64_t inUse = 0, inUseBytes = 0, allocs = 0, allocBytes = 0;
+    for (const Site& s : sites) {
+        inUse += s.sampledInUse;
+        inUseBytes += s.sampledInUseBytes;
+        allocs += s.sampledAllocs;
+        allocBytes += s.sampledAllocBytes;
+    }
+    out << "heap profile: " << inUse << ": " << inUseBytes << " [" << allocs << ": "
+        << allocBytes << "] @ heap_v2/" << static_cast<std::size_t>(gMean) << '\n';
+    std::vector<std::string> names;
+    for (const Site& s : sites) {
+        int first = firstUserFrame(s, names);
+        out << s.sampledInUse << ": " << s.sampledInUseBytes << " [" << s.sampledAllocs
+            << ": " << s.sampledAllocBytes << "] @";
+        for (int i = first; i < s.depth; ++i) out << ' ' << s.frames[i];
+        out << '\n';
+    }
+    // pprof needs the memory map to symbolize the addresses.
+    out << "\nMAPPED_LIBRARIES:\n";
+    std::ifstream maps("/proc/self/maps");
+    out << maps.rdbuf();
+}
+
+// --------------------------------------------------------------------------
+// Signal and exit handling
+// --------------------------------------------------------------------------
+
+// Async-signal-safe: only writes one byte to a pipe. The dump itself runs on
+// the profiler thread below.
+void onSignal(int) {
+    char c = 'd';
+    ssize_t ignored = write(gPipe[1], &c, 1);
+    (void)ignored;
+}
+
+void signalThread() {
+    tInternal = true;
+    char c;
+    while (read(gPipe[0], &c, 1) == 1) dump();
+}
+
+void dumpAtExit() {
+    if (gOptions.dumpAtExit) dump();
+}
+
+}  // namespace
+
+bool start(const Options& options) {
+    if (!alloctrack::enabled() || gRunning.exchange(true)) return false;
+    tInternal = true;
+    gOptions = options;
+    gMean = static_cast<double>(options.sampleBytes ? options.sampleBytes : 1);
+    if (!gSites) gSites = static_cast<Site*>(std::calloc(kTableSize, sizeof(Site)));
+    if (!gSites) {
+        gRunning = false;
+        tInternal = false;
+        return false;
+    }
+
+    // The first backtrace() may dlopen the unwinder; do it outside the hook.
+    void* warm[4];
+    backtrace(warm, 4);
+
+    static bool exitRegistered = false;
+    if (!exitRegistered) {
+        std::atexit(dumpAtExit);
+        exitRegistered = true;
+    }
+    if (options.dumpSignal != 0 && gPipe[0] < 0 && pipe(gPipe) == 0) {
+        std::thread(signalThread).detach();
+        struct sigaction sa;
+        std::memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = onSignal;
+        sa.sa_flags = SA_RESTART;
+        sigaction(options.dumpSignal, &sa, nullptr);
+    }
+
+    // setSamplingHooks() makes this thread's next allocation a sample.
+    gCalibrating = true;
+    tInternal = false;
+    alloctrack::setSamplingHooks(onSample, onFree, options.sampleBytes);
+    calibrationCaller();
+    gCalibrating = false;
+    return true;
+}
+
+void stop() {
+    alloctrack::clearSamplingHooks();
+    gRunning = false;
+}
+
+bool dump(const std::string& path) {
+    bool wasInternal = tInternal;
+    tInternal = true;
+    std::vector<Site> sites = copySites();
+    std::ostringstream out;
+    if (gOptions.format == Format::Pprof) writePprof(out, sites);
+    else writeFolded(out, sites);
+
+    const std::string& target = path.empty() ? gOptions.outputPath : path;
+    std::ofstream file(target);
+    bool ok = static_cast<bool>(file << out.str());
+    tInternal = wasInternal;
+    return ok;
+}
+
+void report(std::ostream& os, std::size_t topN) {
+    bool wasInternal = tInternal;
+    tInternal = true;
+    std::vector<Site> sites = copySites();
+    std::sort(sites.begin(), sites.end(),
+              [](const Site& a, const Site& b) { return a.inUseBytes > b.inUseBytes; });
+    std::vector<std::string> names;
+    os << std::fixed << std::setprecision(1);
+    for (std::size_t k = 0; k < sites.size() && k < topN; ++k) {
+        const Site& s = sites[k];
+        int first = firstUserFrame(s, names);
+        os << "#" << k + 1 << "  in use ~" << s.inUseBytes / 1024.0 << " KiB in ~"
+           << std::llround(s.inUseCount) << " blocks (allocated ~"
+           << s.allocBytes / 1024.0 << " KiB)\n";
+        for (int i = first; i < s.depth && i < first + 4; ++i)
+            os << "      " << names[i] << '\n';
+    }
+    os.unsetf(std::ios::fixed);
+    tInternal = wasInternal;
+}
+
+std::size_t siteCount() {
+    lock();
+    std::size_t n = gSiteCount;
+    unlock();
+    return n;
+}
+
+}  // namespace heapprof
@@ -0,0 +1,209 @@
+/* ==========================================================================
+merge_sort.h - Allocation-Free, Bottom-Up (and Parallel) Merge Sort
+
+Theory:
+---------
+The textbook merge sort in complexity.cpp is correct but slow in practice:
+- merge() creates two new vectors L and R for every merge: about 2n heap
+  allocations and O(n log n) bytes of heap traffic per sort.
+- It recurses down to single elements, so most of the calls do almost no
+  work and the call overhead dominates.
+
+This header sorts the same way (stable, O(n log n)) with:
+1. Insertion sort on small runs (insertionCutoff elements, default 32):
+   cheap on tiny, cache-resident ranges.
+2. Bottom-up merging: merge runs of width 32, 64, 128, ... in passes, with
+   no recursion at all.
+3. One scratch buffer of n elements used in "ping-pong" fashion: each pass
+   merges from data into scratch or back, so nothing is ever allocated
+   during the sort. The caller can pass the scratch buffer to make the sort
+   completely allocation-free.
+4. Optional parallelism: P threads sort P chunks, then the chunks are merged
+   pairwise; every merge is split into P independent pieces with a binary
+   search ("co-ranking"), so all threads stay busy up to the last merge.
+
+Key Points:
+- Stable: equal elements keep their order (like std::stable_sort).
+- A pass skips the merge of two runs that are already in order, so sorted
+  or nearly sorted input costs close to one copy per pass.
+- Edge Cases: threads are only used above parallelThreshold elements;
+  Compare must be a strict weak ordering, as for std::sort.
+========================================================================== */
+
+#ifndef MERGE_SORT_H
+#define MERGE_SORT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace msort {
+
+struct Options {
+    std::size_t insertionCutoff = 32;         // runs of this size are insertion sorted
+    unsigned threads = 1;                     // 0 = std::thread::hardware_concurrency()
+    std::size_t parallelThreshold = 1 << 16;  // smaller inputs are sorted on one thread
+};
+
+namespace detail {
+
+template <class T, class Compare>
+void insertionSort(T* first, T* last, Compare& comp) {
+    for (T* i = first + 1; i < last; ++i) {
+        T value = std::move(*i);
+        T* j = i;
+        for (; j > first && comp(value, *(j - 1)); --j) *j = std::move(*(j - 1));
+        *j = std::move(value);
+    }
+}
+
+// Stable merge of [a, aEnd) and [b, bEnd) into out. On ties the element of
+// the first run is taken first. The select is written without a branch so
+// the compiler can use a conditional move for scalar types.
+template <class T, class Compare>
+void mergeRuns(T* a, T* aEnd, T* b, T* bEnd, T* out, Compare& comp) {
+    while (a != aEnd && b != bEnd) {
+        bool takeB = comp(*b, *a);
+        *out++ = std::move(takeB ? *b : *a);
+        b += takeB;
+        a += !takeB;
+    }
+    out = std::move(a, aEnd, out);
+    std::move(b, bEnd, out);
+}
+
+// Merges the runs [lo, mid) and [mid, hi) of src into dst.
+template <class T, class Compare>
+void mergePair(T* src, T* dst, std::size_t lo, std::size_t mid, std::size_t hi, Compare& comp) {
+    if (mid >= hi || !comp(src[mid], src[mid - 1])) {
+        std::move(src + lo, src + hi, dst + lo);  // single run, or already in order
+        return;
+    }
+    mergeRuns(src + lo, src + mid, src + mid, src + hi, dst + lo, comp);
+}
+
+// Sorts data[0, n) using scratch[0, n); the result ends up in data.
+template <class T, class Compare>
+void sortSequential(T* data, T* scratch, std::size_t n, std::size_t cutoff, Compare& comp) {
+    if (n < 2) return;
+    cutoff = std::max<std::size_t>(cutoff, 1);
+    for (std::size_t i = 0; i < n; i += cutoff)
+        insertionSort(data + i, data + std::min(i + cutoff, n), comp);
+
+    T* src = data;
+    T* dst = scratch;
+    for (std::size_t width = cutoff; width < n; width *= 2) {
+        for (std::size_t lo = 0; lo < n; lo += 2 * width)
+            mergePair(src, dst, lo, std::min(lo + width, n), std::min(lo + 2 * width, n), comp);
+        std::swap(src, dst);
+    }
+    if (src != data) std::move(src, src + n, data);
+}
+
+// Number of elements of a that come before position k of merge(a, b).
+template <class T, class Compare>
+std::size_t coRank(std::size_t k, const T* a, std::size_t m, const T* b, std::size_t n,
+                   Compare& comp) {
+    std::size_t lo = k > n ? k - n : 0;
+    std::size_t hi = std::min(k, m);
+    while (lo < hi) {
+        std::size_t i = lo + (hi - lo) / 2;
+        std::size_t j = k - i;
+        if (j > 0 && i < m && !comp(b[j - 1], a[i]))  // a[i] precedes b[j-1]
+            lo = i + 1;
+        else
+            hi = i;
+    }
+    return lo;
+}
+
+// Runs fn(0) .. fn(count - 1), one per thread (fn(0) on the calling thread).
+template <class Fn>
+void forEachThread(unsigned count, const Fn& fn) {
+    std::vector<std::thread> workers;
+    workers.reserve(count - 1);
+    for (unsigned t = 1; t < count; ++t) workers.emplace_back([&fn, t] { fn(t); });
+    fn(0);
+    for (std::thread& w : workers) w.join();
+}
+
+template <class T, class Compare>
+void sortParallel(T* data, T* scratch, std::size_t n, std::size_t cutoff, unsigned threads,
+                  Compare& comp) {
+    unsigned p = 1;
+    while (p * 2 <= threads) p *= 2;
+    std::vector<std::size_t> bounds(p + 1);
+    for (unsigned i = 0; i <= p; ++i) bounds[i] = n * i / p;
+
+    // 1. Each thread sorts one chunk, in place.
+    forEachThread(p, [&](unsigned t) {
+        sortSequential(data + bounds[t], scratch + bounds[t], bounds[t + 1] - bounds[t], cutoff,
+                       comp);
+    });
+
+    // 2. log2(p) levels of pairwise merges. At each level every merge is cut
+    //    into p / pairs pieces of equal output size, one per thread.
+    T* src = data;
+    T* dst = scratch;
+    for (unsigned runs = p; runs > 1; runs /= 2) {
+        unsigned step = p / runs;  // chunks per run
+        unsigned pairs = runs / 2;
+        unsigned pieces = p / pairs;
+        forEachThread(p, [&](unsigned t) {
+            unsigned pair = t / pieces, piece = t % pieces;
+            std::size_t lo = bounds[2 * pair * step];
+            std::size_t mid = bounds[(2 * pair + 1) * step];
+            std::size_t hi = bounds[(2 * pair + 2) * step];
+            const T* a = src + lo;
+            const T* b = src + mid;
+            std::size_t m = mid - lo, k = hi - mid, total = hi - lo;
+            std::size_t k0 = total * piece / pieces, k1 = total * (piece + 1) / pieces;
+            std::size_t i0 = coRank(k0, a, m, b, k, comp), i1 = coRank(k1, a, m, b, k, comp);
+            mergeRuns(src + lo + i0, src + lo + i1, src + mid + (k0 - i0), src + mid + (k1 - i1),
+                      dst + lo + k0, comp);
+        });
+        std::swap(src, dst);
+    }
+    if (src != data) {
+        forEachThread(p, [&](unsigned t) {
+            std::move(src + bounds[t], src + bounds[t + 1], data + bounds[t]);
+        });
+    }
+}
+
+}  // namespace detail
+
+// Sorts [first, last) using the caller's scratch buffer, which must hold at
+// least (last - first) elements. Performs no allocation on one thread.
+template <class T, class Compare = std::less<>>
+void mergeSort(T* first, T* last, T* scratch, const Options& options = Options(),
+               Compare comp = Compare()) {
+    std::size_t n = static_cast<std::size_t>(last - first);
+    unsigned threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+    if (threads > 1 && n >= options.parallelThreshold)
+        detail::sortParallel(first, scratch, n, options.insertionCutoff, threads, comp);
+    else
+        detail::sortSequential(first, scratch, n, options.insertionCutoff, comp);
+}
+
+// Same, with a scratch buffer allocated once for the whole sort.
+template <class T, class Compare = std::less<>>
+void mergeSort(T* first, T* last, const Options& options = Options(), Compare comp = Compare()) {
+    std::size_t n = static_cast<std::size_t>(last - first);
+    if (n < 2) return;
+    std::unique_ptr<T[]> scratch(new T[n]);
+    mergeSort(first, last, scratch.get(), options, comp);
+}
+
+template <class T, class Compare = std::less<>>
+void mergeSort(std::vector<T>& v, const Options& options = Options(), Compare comp = Compare()) {
+    mergeSort(v.data(), v.data() + v.size(), options, comp);
+}
+
+}  // namespace msort
+
+#endif  // MERGE_SORT_H
@@ -79,4 +79,14 @@ int main() {
     std::cout << "Current memory in use: " << (totalMemoryAllocated - totalMemoryDeallocated) << " bytes\n";
 
     return 0;
-}
\ No newline at end of file
+}
+
+/*
+    Going further:
+    --------------
+    The std::map above is not thread-safe, allocates its own nodes through the
+    operator it overrides, and printing on every call slows the program down by
+    orders of magnitude. `alloc_tracker.h` / `alloc_tracker.cpp` (Lesson 6) store
+    the size in a header in front of each block and count per thread instead,
+    so tracking costs only a few nanoseconds per allocation.
+*/
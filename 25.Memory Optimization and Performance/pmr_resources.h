@@ -0,0 +1,430 @@
+/* ==========================================================================
+pmr_resources.h - Custom std::pmr Memory Resources
+
+Theory:
+---------
+C++17's polymorphic memory resources separate *what* a container stores from
+*where* its memory comes from. A `std::pmr::vector<int>` calls
+`resource->allocate(bytes, align)` instead of `operator new`, and the resource
+is chosen at run time. Writing your own resource means deriving from
+`std::pmr::memory_resource` and overriding three virtual functions:
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment);
+    void  do_deallocate(void* p, std::size_t bytes, std::size_t alignment);
+    bool  do_is_equal(const memory_resource& other) const noexcept;
+
+Note that do_deallocate receives the size: a resource needs no block header.
+
+This header provides three resources:
+1. ArenaResource         - bump-pointer allocation in a fixed buffer, with
+                           mark()/rewind() to free everything allocated after
+                           a marker at once. deallocate() is a no-op.
+2. ThreadLocalPoolResource - power-of-two size classes with one free-list set
+                           per thread: allocate/deallocate never lock and never
+                           use atomic read-modify-write instructions (beyond
+                           64 live threads, the extra ones share a locked set).
+3. StatsResource         - wraps any resource and counts calls, bytes and the
+                           peak number of bytes in use (thread-safe).
+
+Key Points:
+- ArenaResource is the fastest possible allocator for "build, use, throw
+  away" phases (parsing a request, one frame of a game, one query).
+- ThreadLocalPoolResource is for long-lived containers with churn (maps,
+  lists) used from several threads.
+- StatsResource answers "how much memory does this container really use?".
+- Edge Cases: when the arena buffer is full it falls back to its upstream
+  resource (or throws std::bad_alloc if the upstream is null_memory_resource).
+
+Requires C++17 (<memory_resource>).
+========================================================================== */
+
+#ifndef PMR_RESOURCES_H
+#define PMR_RESOURCES_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <unordered_set>
+#include <vector>
+
+namespace pmrx {
+
+inline std::size_t alignUp(std::size_t n, std::size_t align) {
+    return (n + align - 1) & ~(align - 1);
+}
+
+// --------------------------------------------------------------------------
+// 1. ArenaResource
+// --------------------------------------------------------------------------
+class ArenaResource : public std::pmr::memory_resource {
+public:
+    // Position in the arena, returned by mark() and accepted by rewind():
+    // bytes used in the buffer and the number of overflow blocks.
+    struct Marker {
+        std::size_t used = 0;
+        std::size_t overflow = 0;
+    };
+
+    ArenaResource(void* buffer, std::size_t size,
+                  std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : buffer_(static_cast<char*>(buffer)), size_(size), upstream_(upstream) {}
+
+    // Owns its buffer (allocated from the upstream resource).
+    explicit ArenaResource(std::size_t size,
+                           std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : buffer_(static_cast<char*>(upstream->allocate(size, alignof(std::max_align_t)))),
+          size_(size), upstream_(upstream), owned_(true) {}
+
+    ~ArenaResource() override {
+        releaseOverflow(0);
+        if (owned_) upstream_->deallocate(buffer_, size_, alignof(std::max_align_t));
+    }
+
+    ArenaResource(const ArenaResource&) = delete;
+    ArenaResource& operator=(const ArenaResource&) = delete;
+
+    Marker mark() const { return {used_, overflow_.size()}; }
+
+    // Frees everything allocated after `m`, overflow blocks included.
+    // Containers using that memory must already be destroyed (or never
+    // touched again).
+    void rewind(Marker m) {
+        if (m.used <= used_) used_ = m.used;
+        releaseOverflow(m.overflow);
+    }
+
+    void reset() { rewind({}); }
+
+    std::size_t used() const { return used_; }
+    std::size_t capacity() const { return size_; }
+    std::size_t overflowAllocations() const { return overflow_.size(); }
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t align) override {
+        std::uintptr_t base = reinterpret_cast<std::uintptr_t>(buffer_);
+        std::size_t start = alignUp(base + used_, align) - base;
+        if (start + bytes <= size_) {
+            used_ = start + bytes;
+            return buffer_ + start;
+        }
+        // Full: fall back to the upstream resource, remembering the block so
+        // rewind() and reset() can return it.
+        void* p = upstream_->allocate(bytes, align);
+        overflow_.push_back({p, bytes, align});
+        return p;
+    }
+
+    void do_deallocate(void*, std::size_t, std::size_t) override {
+        // Individual frees are ignored: memory comes back with rewind().
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    struct Block {
+        void* p;
+        std::size_t bytes;
+        std::size_t align;
+    };
+
+    // Returns the overflow blocks after the first `keep`, newest first.
+    void releaseOverflow(std::size_t keep) {
+        while (overflow_.size() > keep) {
+            const Block& b = overflow_.back();
+            upstream_->deallocate(b.p, b.bytes, b.align);
+            overflow_.pop_back();
+        }
+    }
+
+    char* buffer_;
+    std::size_t size_;
+    std::size_t used_ = 0;
+    std::pmr::memory_resource* upstream_;
+    bool owned_ = false;
+    std::vector<Block> overflow_;
+};
+
+// --------------------------------------------------------------------------
+// 2. ThreadLocalPoolResource
+// --------------------------------------------------------------------------
+// Each thread that uses the pool gets its own slot. A slot holds one free
+// list per size class and the chunks it carved them from; only its owner ever
+// touches it, so the fast path is a plain linked-list pop/push. Blocks freed
+// by another thread go to that thread's list (same size class, so they are
+// interchangeable). Chunks are 64-byte aligned, so requests aligned to more
+// than 64 bytes go to the upstream resource.
+//
+// When a thread exits, its slots are released, free lists included, and the
+// next new thread adopts one. Only kMaxThreads threads can own a slot at the
+// same time; further threads share one extra slot behind a mutex. So does an
+// exiting thread after its slots are released: a thread_local container
+// destroyed after that point frees into the shared slot, not a released one.
+class ThreadLocalPoolResource : public std::pmr::memory_resource {
+public:
+    static const int kMaxThreads = 64;
+    static const int kNumClasses = 10;              // 8, 16, ..., 4096 bytes
+    static const std::size_t kMaxPooled = 4096;
+    static const std::size_t kChunkSize = 64 * 1024;
+
+    explicit ThreadLocalPoolResource(
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : upstream_(upstream), id_(nextId().fetch_add(1)) {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        registry().livePools.insert(id_);
+    }
+
+    ~ThreadLocalPoolResource() override {
+        {
+            // After this, exiting threads no longer touch our slots.
+            std::lock_guard<std::mutex> lock(registry().mutex);
+            registry().livePools.erase(id_);
+        }
+        for (Slot& s : slots_)
+            for (void* chunk : s.chunks) upstream_->deallocate(chunk, kChunkSize, 64);
+        for (void* chunk : shared_.chunks) upstream_->deallocate(chunk, kChunkSize, 64);
+    }
+
+    ThreadLocalPoolResource(const ThreadLocalPoolResource&) = delete;
+    ThreadLocalPoolResource& operator=(const ThreadLocalPoolResource&) = delete;
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t align) override {
+        if (bytes > kMaxPooled || align > 64) return upstream_->allocate(bytes, align);
+        int cls = classOf(bytes > align ? bytes : align);
+        Slot& s = mySlot();
+        if (&s == &shared_) {
+            std::lock_guard<std::mutex> lock(sharedMutex_);
+            return pop(s, cls);
+        }
+        return pop(s, cls);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t align) override {
+        if (bytes > kMaxPooled || align > 64) {
+            upstream_->deallocate(p, bytes, align);
+            return;
+        }
+        int cls = classOf(bytes > align ? bytes : align);
+        Slot& s = mySlot();
+        if (&s == &shared_) {
+            std::lock_guard<std::mutex> lock(sharedMutex_);
+            push(s, cls, p);
+            return;
+        }
+        push(s, cls, p);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct alignas(64) Slot {
+        std::atomic<std::uint64_t> owner{0};  // threadToken() of the owner, 0 if free
+        FreeBlock* free[kNumClasses] = {};
+        std::vector<void*> chunks;
+    };
+
+    // Ids of the pools not yet destroyed. Never freed: threads may exit
+    // after static destructors have run.
+    struct Registry {
+        std::mutex mutex;
+        std::unordered_set<std::uint64_t> livePools;
+    };
+
+    static Registry& registry() {
+        static Registry* r = new Registry;
+        return *r;
+    }
+
+    // The slots a thread owns; its destructor gives them back on thread exit.
+    struct ThreadSlots {
+        struct Owned {
+            std::uint64_t poolId;
+            Slot* slot;
+        };
+        std::vector<Owned> owned;
+
+        ~ThreadSlots() {
+            // Later calls on this thread must not find the slots in the cache.
+            ThreadCache& cache = threadCache();
+            cache = ThreadCache();
+            cache.released = true;
+            std::lock_guard<std::mutex> lock(registry().mutex);
+            for (const Owned& o : owned)
+                if (registry().livePools.count(o.poolId))
+                    o.slot->owner.store(0, std::memory_order_release);
+        }
+    };
+
+    // The last few pools the thread used. Trivially destructible, so it
+    // stays usable while the thread's other thread_locals are destroyed.
+    struct ThreadCache {
+        struct Entry {
+            std::uint64_t poolId;
+            Slot* slot;
+        };
+        Entry entries[4] = {};
+        unsigned next = 0;
+        bool released = false;  // ThreadSlots is gone: use shared_ from now on
+    };
+
+    static ThreadCache& threadCache() {
+        thread_local ThreadCache cache;
+        return cache;
+    }
+
+    static std::atomic<std::uint64_t>& nextId() {
+        static std::atomic<std::uint64_t> id{1};
+        return id;
+    }
+
+    static int classOf(std::size_t n) {
+        if (n <= 8) return 0;
+        return 64 - __builtin_clzll(static_cast<unsigned long long>(n - 1)) - 3;
+    }
+
+    // A unique, never reused token per thread (thread ids can be recycled).
+    static std::uint64_t threadToken() {
+        static std::atomic<std::uint64_t> next{1};
+        thread_local std::uint64_t token = next.fetch_add(1, std::memory_order_relaxed);
+        return token;
+    }
+
+    // Finds the calling thread's slot. A tiny per-thread cache remembers the
+    // last few pools used; pools are identified by a unique id so a new pool
+    // at a recycled address is not confused with a destroyed one.
+    Slot& mySlot() {
+        ThreadCache& cache = threadCache();
+        for (const ThreadCache::Entry& e : cache.entries)
+            if (e.poolId == id_) return *e.slot;
+        if (cache.released) return shared_;  // the thread is exiting
+
+        Slot* slot = claimSlot(threadToken());
+        if (!slot) return shared_;  // not cached: a slot may free up later
+        cache.entries[cache.next++ % 4] = {id_, slot};
+        return *slot;
+    }
+
+    // The slot the thread already owns, or a free one it now owns; null if
+    // all kMaxThreads slots belong to live threads.
+    Slot* claimSlot(std::uint64_t token) {
+        for (Slot& s : slots_)
+            if (s.owner.load(std::memory_order_acquire) == token) return &s;
+        for (Slot& s : slots_) {
+            std::uint64_t expected = 0;
+            if (s.owner.load(std::memory_order_relaxed) == 0 &&
+                s.owner.compare_exchange_strong(expected, token, std::memory_order_acq_rel)) {
+                thread_local ThreadSlots mine;
+                std::lock_guard<std::mutex> lock(registry().mutex);
+                // Forget slots of pools destroyed since.
+                auto dead = [](const ThreadSlots::Owned& o) {
+                    return !registry().livePools.count(o.poolId);
+                };
+                mine.owned.erase(std::remove_if(mine.owned.begin(), mine.owned.end(), dead),
+                                 mine.owned.end());
+                mine.owned.push_back({id_, &s});
+                return &s;
+            }
+        }
+        return nullptr;
+    }
+
+    void* pop(Slot& s, int cls) {
+        FreeBlock* b = s.free[cls];
+        if (!b) b = refill(s, cls);
+        s.free[cls] = b->next;
+        return b;
+    }
+
+    static void push(Slot& s, int cls, void* p) {
+        FreeBlock* b = static_cast<FreeBlock*>(p);
+        b->next = s.free[cls];
+        s.free[cls] = b;
+    }
+
+    FreeBlock* refill(Slot& s, int cls) {
+        std::size_t size = std::size_t(8) << cls;
+        char* chunk = static_cast<char*>(upstream_->allocate(kChunkSize, 64));
+        s.chunks.push_back(chunk);
+        std::size_t n = kChunkSize / size;
+        for (std::size_t i = 0; i + 1 < n; ++i)
+            reinterpret_cast<FreeBlock*>(chunk + i * size)->next =
+                reinterpret_cast<FreeBlock*>(chunk + (i + 1) * size);
+        reinterpret_cast<FreeBlock*>(chunk + (n - 1) * size)->next = nullptr;
+        s.free[cls] = reinterpret_cast<FreeBlock*>(chunk);
+        return s.free[cls];
+    }
+
+    std::pmr::memory_resource* upstream_;
+    std::uint64_t id_;
+    Slot slots_[kMaxThreads];
+    Slot shared_;  // for threads beyond kMaxThreads, under sharedMutex_
+    std::mutex sharedMutex_;
+};
+
+// --------------------------------------------------------------------------
+// 3. StatsResource
+// --------------------------------------------------------------------------
+class StatsResource : public std::pmr::memory_resource {
+public:
+    explicit StatsResource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : upstream_(upstream) {}
+
+    std::uint64_t allocations() const { return allocations_.load(); }
+    std::uint64_t deallocations() const { return deallocations_.load(); }
+    std::uint64_t bytesAllocated() const { return bytesAllocated_.load(); }
+    std::uint64_t bytesInUse() const { return inUse_.load(); }
+    std::uint64_t peakBytesInUse() const { return peak_.load(); }
+
+    void resetCounters() {
+        allocations_ = 0;
+        deallocations_ = 0;
+        bytesAllocated_ = 0;
+        peak_ = inUse_.load();
+    }
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t align) override {
+        void* p = upstream_->allocate(bytes, align);
+        allocations_.fetch_add(1, std::memory_order_relaxed);
+        bytesAllocated_.fetch_add(bytes, std::memory_order_relaxed);
+        std::uint64_t now = inUse_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        std::uint64_t peak = peak_.load(std::memory_order_relaxed);
+        while (now > peak && !peak_.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {
+        }
+        return p;
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t align) override {
+        upstream_->deallocate(p, bytes, align);
+        deallocations_.fetch_add(1, std::memory_order_relaxed);
+        inUse_.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    std::pmr::memory_resource* upstream_;
+    std::atomic<std::uint64_t> allocations_{0};
+    std::atomic<std::uint64_t> deallocations_{0};
+    std::atomic<std::uint64_t> bytesAllocated_{0};
+    std::atomic<std::uint64_t> inUse_{0};
+    std::atomic<std::uint64_t> peak_{0};
+};
+
+}  // namespace pmrx
+
+#endif  // PMR_RESOURCES_H
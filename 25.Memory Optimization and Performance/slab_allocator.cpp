@@ -0,0 +1,487 @@
+/*
+File: slab_allocator.cpp
+Description:
+  Implementation of slab_allocator.h: replacement global operator new/delete.
+
+  Memory layout:
+    [ reserved range: slab 0 | slab 1 | slab 2 | ... ]   (64 KiB each, aligned)
+    gSlabClass[n] = size class of slab n (one byte per slab, in BSS)
+
+  new(size <= 32 KiB): class = sizeClassOf(size)
+                       pop thread-local free list, refill a batch if empty
+  new(size >  32 KiB): mmap, with a 64-byte header holding the mapping size
+  delete(p):           p inside the range -> push on the thread-local list of
+                       gSlabClass[slab of p]; otherwise munmap its mapping
+  no slab left:        small requests go to malloc, with the same header
+                       (length 0), and delete hands them back to free
+
+  Compile with -DSLAB_ALLOCATOR_DISABLED to leave the system operators alone,
+  or with -DSLAB_ALLOCATOR_MAX_SLABS=0 to skip the reservation (the malloc
+  fallback then serves every small request).
+*/
+
+#include "slab_allocator.h"
+
+#include <sys/mman.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <ostream>
+
+namespace slab {
+
+namespace {
+
+// --------------------------------------------------------------------------
+// Size classes
+// --------------------------------------------------------------------------
+// 0..15  : 16, 32, ..., 256 (16-byte steps)
+// 16..43 : four classes per doubling, 320, 384, 448, 512, 640, ... 32768
+
+constexpr std::size_t computeClassSize(int cls) {
+    if (cls < 16) return 16 * static_cast<std::size_t>(cls + 1);
+    int j = cls - 16;
+    std::size_t base = std::size_t(256) << (j / 4);
+    return base + static_cast<std::size_t>(j % 4 + 1) * (base / 4);
+}
+
+struct ClassTable {
+    std::size_t size[kNumClasses];
+    constexpr ClassTable() : size() {
+        for (int i = 0; i < kNumClasses; ++i) size[i] = computeClassSize(i);
+    }
+};
+constexpr ClassTable kClasses;
+static_assert(computeClassSize(kNumClasses - 1) == kMaxSmallSize, "class table mismatch");
+
+inline int classOf(std::size_t size) {
+    if (size <= 256) return size == 0 ? 0 : static_cast<int>((size + 15) >> 4) - 1;
+    int bits = 64 - __builtin_clzll(static_cast<unsigned long long>(size - 1));
+    return 16 + (bits - 9) * 4 + static_cast<int>((size - 1 - (std::size_t(1) << (bits - 1))) >> (bits - 3));
+}
+
+// Blocks handed to a thread (or back) in one central-list operation.
+inline int batchSize(int cls) {
+    std::size_t n = (32 * 1024) / kClasses.size[cls];
+    return n < 4 ? 4 : (n > 128 ? 128 : static_cast<int>(n));
+}
+
+#ifndef SLAB_ALLOCATOR_DISABLED
+
+// --------------------------------------------------------------------------
+// Reserved range and slabs
+// --------------------------------------------------------------------------
+#ifndef SLAB_ALLOCATOR_MAX_SLABS
+#define SLAB_ALLOCATOR_MAX_SLABS (std::size_t(1) << 20)  // up to 64 GiB of slabs
+#endif
+const std::size_t kMaxSlabs = SLAB_ALLOCATOR_MAX_SLABS;
+
+char* gBase = nullptr;  // [gBase, gEnd) stays empty if no reservation succeeds
+char* gEnd = nullptr;
+std::atomic<std::size_t> gNextSlab{0};
+std::size_t gSlabLimit = 0;
+unsigned char gSlabClass[kMaxSlabs > 0 ? kMaxSlabs : 1];  // BSS: committed when touched
+std::atomic<int> gInitState{0};       // 0 = not started, 1 = running, 2 = done
+
+std::atomic<std::uint64_t> gHugeAllocs{0};
+std::atomic<std::uint64_t> gHugeLive{0};
+std::atomic<std::uint64_t> gRefills{0};
+std::atomic<std::uint64_t> gReleases{0};
+std::atomic<std::uint64_t> gFallbacks{0};
+
+void initRange() {
+    int expected = 0;
+    if (gInitState.compare_exchange_strong(expected, 1, std::memory_order_acq_rel)) {
+        // Try a large reservation first; fall back to smaller ones on systems
+        // with strict overcommit or a small address-space limit. If all of
+        // them fail, small requests fall back to malloc (allocateFallback).
+        for (std::size_t slabs = kMaxSlabs; slabs >= 1024; slabs /= 4) {
+            std::size_t bytes = slabs * kSlabSize + kSlabSize;
+            void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (p == MAP_FAILED) continue;
+            std::uintptr_t a = reinterpret_cast<std::uintptr_t>(p);
+            a = (a + kSlabSize - 1) & ~(kSlabSize - 1);
+            gBase = reinterpret_cast<char*>(a);
+            gEnd = gBase + slabs * kSlabSize;
+            gSlabLimit = slabs;
+            break;
+        }
+        gInitState.store(2, std::memory_order_release);
+    } else {
+        while (gInitState.load(std::memory_order_acquire) != 2) {
+        }
+    }
+}
+
+// One unsigned comparison; the empty range (no reservation) contains nothing.
+inline bool inRange(void* p) {
+    std::uintptr_t base = reinterpret_cast<std::uintptr_t>(gBase);
+    return reinterpret_cast<std::uintptr_t>(p) - base <
+           reinterpret_cast<std::uintptr_t>(gEnd) - base;
+}
+
+// --------------------------------------------------------------------------
+// Free lists
+// --------------------------------------------------------------------------
+// A free block stores the pointer to the next free block in its first bytes.
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+struct FreeList {
+    FreeBlock* head;
+    int count;
+};
+
+// Central list of one class, shared by all threads.
+struct alignas(64) Central {
+    std::atomic_flag lock = ATOMIC_FLAG_INIT;
+    FreeBlock* head = nullptr;
+    std::size_t count = 0;
+};
+Central gCentral[kNumClasses];
+
+void lockCentral(Central& c) {
+    while (c.lock.test_and_set(std::memory_order_acquire)) {
+    }
+}
+void unlockCentral(Central& c) { c.lock.clear(std::memory_order_release); }
+
+// Carves a fresh slab into a chain of blocks of class `cls`.
+// Returns the chain and its length through `count`.
+FreeBlock* carveSlab(int cls, int& count) {
+    if (gInitState.load(std::memory_order_acquire) != 2) initRange();
+    std::size_t n = gNextSlab.fetch_add(1, std::memory_order_relaxed);
+    if (!gBase || n >= gSlabLimit) {
+        count = 0;
+        return nullptr;
+    }
+    gSlabClass[n] = static_cast<unsigned char>(cls);
+    char* slabStart = gBase + n * kSlabSize;
+    std::size_t size = kClasses.size[cls];
+    std::size_t blocks = kSlabSize / size;
+    for (std::size_t i = 0; i + 1 < blocks; ++i)
+        reinterpret_cast<FreeBlock*>(slabStart + i * size)->next =
+            reinterpret_cast<FreeBlock*>(slabStart + (i + 1) * size);
+    reinterpret_cast<FreeBlock*>(slabStart + (blocks - 1) * size)->next = nullptr;
+    count = static_cast<int>(blocks);
+    return reinterpret_cast<FreeBlock*>(slabStart);
+}
+
+// --------------------------------------------------------------------------
+// Thread caches
+// --------------------------------------------------------------------------
+// Trivially constructible thread_local: accessing it costs no init check.
+thread_local FreeList tLists[kNumClasses];
+thread_local bool tArmed = false;
+thread_local bool tDead = false;
+
+void flushThreadCache();
+
+struct CacheReleaser {
+    void arm() {}
+    ~CacheReleaser() { flushThreadCache(); }
+};
+thread_local CacheReleaser tReleaser;
+
+// Moves up to `n` blocks from the central list (or a new slab) into `list`.
+void refill(int cls, FreeList& list) {
+    if (!tArmed && !tDead) {
+        tArmed = true;
+        tReleaser.arm();  // registers the thread-exit flush
+    }
+    // No range: nothing to refill from, the caller falls back to malloc.
+    if (gInitState.load(std::memory_order_acquire) == 2 && !gBase) return;
+    int n = batchSize(cls);
+    Central& c = gCentral[cls];
+    lockCentral(c);
+    FreeBlock* first = c.head;
+    FreeBlock* last = nullptr;
+    int taken = 0;
+    for (FreeBlock* b = c.head; b && taken < n; b = b->next) {
+        last = b;
+        ++taken;
+    }
+    if (taken > 0) {
+        c.head = last->next;
+        c.count -= taken;
+    }
+    unlockCentral(c);
+    gRefills.fetch_add(1, std::memory_order_relaxed);
+
+    if (taken > 0) {
+        last->next = list.head;
+        list.head = first;
+        list.count += taken;
+        return;
+    }
+    // Central list empty: carve a new slab. Blocks beyond the batch go to the
+    // thread list as well; they would only travel back and forth otherwise.
+    int carved = 0;
+    FreeBlock* chain = carveSlab(cls, carved);
+    if (!chain) return;
+    FreeBlock* tail = chain;
+    while (tail->next) tail = tail->next;
+    tail->next = list.head;
+    list.head = chain;
+    list.count += carved;
+}
+
+// Returns one batch from a list that grew too long to the central list.
+void releaseBatch(int cls, FreeList& list, int n) {
+    FreeBlock* first = list.head;
+    FreeBlock* last = first;
+    for (int i = 1; i < n && last->next; ++i) last = last->next;
+    int moved = n;
+    list.head = last->next;
+    list.count -= moved;
+
+    Central& c = gCentral[cls];
+    lockCentral(c);
+    last->next = c.head;
+    c.head = first;
+    c.count += moved;
+    unlockCentral(c);
+    gReleases.fetch_add(1, std::memory_order_relaxed);
+}
+
+void flushThreadCache() {
+    tDead = true;  // from now on this thread talks to the central lists directly
+    for (int cls = 0; cls < kNumClasses; ++cls) {
+        FreeList& list = tLists[cls];
+        if (list.count > 0) releaseBatch(cls, list, list.count);
+    }
+}
+
+// --------------------------------------------------------------------------
+// Huge blocks and the malloc fallback
+// --------------------------------------------------------------------------
+// Stored just below every block outside the slab range.
+struct HugeHeader {
+    void* mapping;       // start of the mmap mapping, or of the malloc block
+    std::size_t length;  // length of the mapping; 0 = from malloc
+};
+
+void* allocateHuge(std::size_t size, std::size_t align) noexcept {
+    std::size_t headerRoom = align > 64 ? align : 64;
+    if (size > static_cast<std::size_t>(-1) / 2) return nullptr;
+    std::size_t length = size + headerRoom + (align > 4096 ? align : 0);
+    void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return nullptr;
+    std::uintptr_t user = reinterpret_cast<std::uintptr_t>(p) + headerRoom;
+    user = (user + align - 1) & ~(static_cast<std::uintptr_t>(align) - 1);
+    HugeHeader* h = reinterpret_cast<HugeHeader*>(user - sizeof(HugeHeader));
+    h->mapping = p;
+    h->length = length;
+    gHugeAllocs.fetch_add(1, std::memory_order_relaxed);
+    gHugeLive.fetch_add(length, std::memory_order_relaxed);
+    return reinterpret_cast<void*>(user);
+}
+
+// Small request that no slab can serve: the range could not be reserved or
+// is used up. malloc returns 16-byte aligned memory; the header goes in front.
+void* allocateFallback(std::size_t size, std::size_t align) noexcept {
+    std::size_t headerRoom = align > 16 ? align : 16;
+    void* p = std::malloc(size + headerRoom + (align > 16 ? align : 0));
+    if (!p) return nullptr;
+    std::uintptr_t user = reinterpret_cast<std::uintptr_t>(p) + headerRoom;
+    user = (user + align - 1) & ~(static_cast<std::uintptr_t>(align) - 1);
+    HugeHeader* h = reinterpret_cast<HugeHeader*>(user - sizeof(HugeHeader));
+    h->mapping = p;
+    h->length = 0;
+    gFallbacks.fetch_add(1, std::memory_order_relaxed);
+    return reinterpret_cast<void*>(user);
+}
+
+void freeHuge(void* p) noexcept {
+    HugeHeader* h = reinterpret_cast<HugeHeader*>(static_cast<char*>(p) - sizeof(HugeHeader));
+    if (h->length == 0) {
+        std::free(h->mapping);
+        return;
+    }
+    gHugeLive.fetch_sub(h->length, std::memory_order_relaxed);
+    munmap(h->mapping, h->length);
+}
+
+// --------------------------------------------------------------------------
+// Entry points
+// --------------------------------------------------------------------------
+inline void* allocateSmall(int cls) noexcept {
+    if (tDead) {
+        // Thread is exiting: serve from the central list, one block at a time.
+        FreeList tmp{nullptr, 0};
+        refill(cls, tmp);
+        if (!tmp.head) return nullptr;
+        FreeBlock* b = tmp.head;
+        tmp.head = b->next;
+        tmp.count -= 1;
+        if (tmp.count > 0) releaseBatch(cls, tmp, tmp.count);
+        return b;
+    }
+    FreeList& list = tLists[cls];
+    if (__builtin_expect(list.head == nullptr, 0)) {
+        refill(cls, list);
+        if (!list.head) return nullptr;
+    }
+    FreeBlock* b = list.head;
+    list.head = b->next;
+    list.count -= 1;
+    return b;
+}
+
+inline void* allocate(std::size_t size, std::size_t align) noexcept {
+    if (align <= 16) {
+        if (size > kMaxSmallSize) return allocateHuge(size, 16);
+        if (void* p = allocateSmall(classOf(size))) return p;
+        return allocateFallback(size, 16);
+    }
+    // Power-of-two classes hold blocks aligned to their size.
+    std::size_t need = size > align ? size : align;
+    std::size_t pow2 = std::size_t(1) << (64 - __builtin_clzll(need - 1));
+    if (pow2 > kMaxSmallSize) return allocateHuge(size, align);
+    if (void* p = allocateSmall(classOf(pow2))) return p;
+    return allocateFallback(size, align);
+}
+
+void* allocateOrThrow(std::size_t size, std::size_t align) {
+    for (;;) {
+        if (void* p = allocate(size, align)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* allocateNoThrow(std::size_t size, std::size_t align) noexcept {
+    try {
+        return allocateOrThrow(size, align);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+inline void deallocate(void* p) noexcept {
+    if (!p) return;
+    if (__builtin_expect(!inRange(p), 0)) {
+        freeHuge(p);
+        return;
+    }
+    std::size_t slabIndex = static_cast<std::size_t>(static_cast<char*>(p) - gBase) / kSlabSize;
+    int cls = gSlabClass[slabIndex];
+    FreeBlock* b = static_cast<FreeBlock*>(p);
+    if (tDead) {
+        FreeList tmp{b, 1};
+        b->next = nullptr;
+        releaseBatch(cls, tmp, 1);
+        return;
+    }
+    FreeList& list = tLists[cls];
+    b->next = list.head;
+    list.head = b;
+    list.count += 1;
+    // Keep at most two batches per class in a thread cache.
+    if (__builtin_expect(list.count > 2 * batchSize(cls), 0))
+        releaseBatch(cls, list, batchSize(cls));
+}
+
+#endif  // SLAB_ALLOCATOR_DISABLED
+
+}  // namespace
+
+std::size_t classSize(int cls) { return kClasses.size[cls]; }
+
+int sizeClassOf(std::size_t size) { return classOf(size); }
+
+bool enabled() {
+#ifdef SLAB_ALLOCATOR_DISABLED
+    return false;
+#else
+    return true;
+#endif
+}
+
+Stats stats() {
+    Stats s;
+#ifndef SLAB_ALLOCATOR_DISABLED
+    std::size_t used = gNextSlab.load(std::memory_order_relaxed);
+    s.slabsInUse = used < gSlabLimit ? used : gSlabLimit;
+    s.reservedBytes = gSlabLimit * kSlabSize;
+    s.hugeAllocations = gHugeAllocs.load(std::memory_order_relaxed);
+    s.hugeLiveBytes = gHugeLive.load(std::memory_order_relaxed);
+    s.centralRefills = gRefills.load(std::memory_order_relaxed);
+    s.centralReleases = gReleases.load(std::memory_order_relaxed);
+    s.fallbackAllocations = gFallbacks.load(std::memory_order_relaxed);
+#endif
+    return s;
+}
+
+void print(std::ostream& os, const Stats& s) {
+    if (!enabled()) {
+        os << "[slab] disabled (built with SLAB_ALLOCATOR_DISABLED)\n";
+        return;
+    }
+    os << "[slab] slabs in use:     " << s.slabsInUse << " (" << s.slabsInUse * kSlabSize / 1024
+       << " KiB)\n"
+       << "[slab] reserved range:   " << s.reservedBytes / (1024 * 1024) << " MiB\n"
+       << "[slab] huge allocations: " << s.hugeAllocations << " (" << s.hugeLiveBytes
+       << " bytes live)\n"
+       << "[slab] central refills:  " << s.centralRefills << '\n'
+       << "[slab] central releases: " << s.centralReleases << '\n'
+       << "[slab] malloc fallbacks: " << s.fallbackAllocations << '\n';
+}
+
+}  // namespace slab
+
+// ==========================================================================
+// Replacement operators
+// ==========================================================================
+#ifndef SLAB_ALLOCATOR_DISABLED
+
+using slab::allocateNoThrow;
+using slab::allocateOrThrow;
+using slab::deallocate;
+
+void* operator new(std::size_t size) { return allocateOrThrow(size, 16); }
+void* operator new[](std::size_t size) { return allocateOrThrow(size, 16); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return allocateNoThrow(size, 16);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return allocateNoThrow(size, 16);
+}
+void* operator new(std::size_t size, std::align_val_t al) {
+    return allocateOrThrow(size, static_cast<std::size_t>(al));
+}
+void* operator new[](std::size_t size, std::align_val_t al) {
+    return allocateOrThrow(size, static_cast<std::size_t>(al));
+}
+void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return allocateNoThrow(size, static_cast<std::size_t>(al));
+}
+void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return allocateNoThrow(size, static_cast<std::size_t>(al));
+}
+
+// The slab number (or the header of a block outside the range) identifies
+// every block, so all delete forms share one implementation and ignore the
+// size/alignment hints.
+void operator delete(void* p) noexcept { deallocate(p); }
+void operator delete[](void* p) noexcept { deallocate(p); }
+void operator delete(void* p, std::size_t) noexcept { deallocate(p); }
+void operator delete[](void* p, std::size_t) noexcept { deallocate(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { deallocate(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { deallocate(p); }
+void operator delete(void* p, std::align_val_t) noexcept { deallocate(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { deallocate(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { deallocate(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { deallocate(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    deallocate(p);
+}
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    deallocate(p);
+}
+
+#endif  // SLAB_ALLOCATOR_DISABLED
@@ -0,0 +1,77 @@
+/* ==========================================================================
+slab_allocator.h - Size-Class Slab Allocator with Per-Thread Caches
+
+Theory:
+---------
+good_performance_practices.cpp (item 8) recommends "object pooling for small
+object allocations". A general-purpose malloc has to handle any size, any
+thread and fragmentation, so each call does real work. Allocators such as
+tcmalloc, jemalloc and mimalloc are fast because of three ideas:
+
+1. Size classes: every request is rounded up to one of a few dozen sizes
+   (16, 32, 48, ... 256, 320, 384, ... 32 KiB). Blocks of one class are
+   interchangeable, so a free block can be reused by the next request of the
+   same class without any searching.
+2. Slabs: memory is carved into 64 KiB slabs, each holding blocks of a single
+   class. The class of any pointer is found from its slab number, so delete
+   needs no header and no size argument.
+3. Thread caches: each thread keeps a free list per class. Allocation is
+   "pop the head of a list", free is "push on a list": no lock, no atomic.
+   Only when a list runs empty (or grows too long) does the thread move a
+   whole batch of blocks from/to a central list protected by a lock.
+
+Requests larger than 32 KiB go straight to mmap/munmap (huge blocks).
+
+Key Points:
+- slab_allocator.cpp replaces global operator new/delete (all forms). Link
+  it instead of alloc_tracker.cpp, not together: both replace the operators.
+- Slabs come from one large reserved address range (MAP_NORESERVE), so the
+  OS only commits pages that are actually touched.
+- Freed small blocks are reused but never returned to the OS.
+- If the range cannot be reserved, or is used up, small requests fall back
+  to malloc; those blocks carry a header, like huge blocks, and go back to
+  free. -DSLAB_ALLOCATOR_MAX_SLABS=0 forces this path.
+- Build with -DSLAB_ALLOCATOR_DISABLED to fall back to the system allocator
+  and compare.
+- Edge Cases: over-aligned requests (alignas > 16) are served from the
+  power-of-two classes, whose blocks are naturally aligned to their size.
+========================================================================== */
+
+#ifndef SLAB_ALLOCATOR_H
+#define SLAB_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+namespace slab {
+
+const std::size_t kSlabSize = 64 * 1024;
+const std::size_t kMaxSmallSize = 32 * 1024;
+const int kNumClasses = 44;
+
+struct Stats {
+    std::uint64_t slabsInUse = 0;       // slabs carved from the reserved range
+    std::uint64_t reservedBytes = 0;    // size of the reserved range
+    std::uint64_t hugeAllocations = 0;  // requests served by mmap
+    std::uint64_t hugeLiveBytes = 0;
+    std::uint64_t centralRefills = 0;   // batches moved central -> thread
+    std::uint64_t centralReleases = 0;  // batches moved thread -> central
+    std::uint64_t fallbackAllocations = 0;  // small requests served by malloc
+};
+
+// Size of size class `cls` in bytes.
+std::size_t classSize(int cls);
+
+// Size class used for a request of `size` bytes (size <= kMaxSmallSize).
+int sizeClassOf(std::size_t size);
+
+Stats stats();
+void print(std::ostream& os, const Stats& s);
+
+// Whether the operators in slab_allocator.cpp were compiled in.
+bool enabled();
+
+}  // namespace slab
+
+#endif  // SLAB_ALLOCATOR_H
@@ -11,6 +11,8 @@ Key Points:
 - Use join() to wait for thread completion.
 - Use mutexes (std::mutex) to protect shared data.
 - Edge Cases: Data races, deadlocks, and proper synchronization.
+- Starting a thread costs tens of microseconds. For many small tasks, reuse
+  the threads of a pool (Lesson 3, thread_pool.h) instead of one thread each.
 
 Example:
 ---------
@@ -20,6 +22,8 @@ Creating a simple multithreaded program that prints messages from different thre
 #include <iostream>
 #include <thread>
 #include <mutex>
+
+#include "thread_pool.h"
 using namespace std;
 
 std::mutex coutMutex;
@@ -38,5 +42,12 @@ int main() {
     t1.join();
     t2.join();
 
+    // The same work as tasks: the pool's threads are started once and reused.
+    tasks::ThreadPool pool(2);
+    tasks::TaskGroup group(pool);
+    group.run([] { printMessage("Hello from pool task 3", 3); });
+    group.run([] { printMessage("Hello from pool task 4", 4); });
+    group.wait();
+
     return 0;
 }
\ No newline at end of file
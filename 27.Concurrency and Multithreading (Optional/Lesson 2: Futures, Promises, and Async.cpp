@@ -10,6 +10,9 @@ Key Points:
 - std::async launches a task asynchronously and returns a std::future.
 - std::promise can be used to set a value that a std::future will later retrieve.
 - Edge Cases: Proper error propagation and exception handling in asynchronous code.
+- std::future has no continuations: each further step blocks a thread in get().
+  future.h's tasks::Future chains steps with then() on a thread pool and
+  combines futures with whenAll/whenAny (see Lesson 4).
 
 Example:
 ---------
@@ -19,6 +22,8 @@ Using std::async to compute a value asynchronously.
 #include <iostream>
 #include <future>
 #include <chrono>
+#include <string>
+#include "future.h"
 using namespace std;
 
 int slowComputation() {
@@ -35,5 +40,14 @@ int main() {
     // Retrieve result (waits if not ready).
     cout << "Result from async computation: " << result.get() << endl;
 
+    // The same computation with a continuation: the formatting step runs
+    // when the value is ready, without a thread waiting for it.
+    tasks::ThreadPool pool(2);
+    tasks::Future<string> message = tasks::async(pool, slowComputation).then([](int value) {
+        return "Result: " + to_string(value);
+    });
+    cout << "Doing other work..." << endl;
+    cout << message.get() << " (via then)" << endl;
+
     return 0;
 }
\ No newline at end of file
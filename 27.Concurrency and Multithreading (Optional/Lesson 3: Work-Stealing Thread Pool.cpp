@@ -0,0 +1,191 @@
+/* ==========================================================================
+Lesson 3: Work-Stealing Thread Pool
+
+Theory:
+---------
+Lesson 1 creates one std::thread per task. That is fine for two long
+tasks, but a thread costs tens of microseconds to create and join, and
+std::async(launch::async) creates one too. thread_pool.h keeps a fixed set
+of workers; a task is a 64-byte object pushed on a worker's own deque, and
+idle workers steal from each other.
+
+Key Points:
+- The spawn cases run --tasks small tasks (about a microsecond of work
+  each) and wait for all of them. The time per task above that
+  microsecond is the overhead of the method.
+- spawn/pool_outside submits from the main thread (shared queue);
+  spawn/pool_inside submits from a task running on a worker (its own
+  deque), the cheapest path.
+- The for cases fill an array of --n elements. for/pool_grain1 makes one
+  task per element to show the per-task overhead of the pool.
+- "steals" is the number of tasks taken from another worker's deque.
+
+Example:
+---------
+    spawn/thread_per_task    std::thread t(work); ... t.join();
+    spawn/std_async          std::async(std::launch::async, work)
+    spawn/pool_outside       group.run(work) from main()
+    spawn/pool_inside        group.run(work) from a worker
+    for/serial               for (i = 0; i < n; ++i) out[i] = f(i)
+    for/threads              one std::thread per core, a block each
+    for/pool                 pool.parallelFor(0, n, f)
+    for/pool_grain1          pool.parallelFor(0, n, f, 1)
+
+Compile & run:
+    g++ -std=c++17 -O2 -pthread "Lesson 3: Work-Stealing Thread Pool.cpp" -o pool
+    ./pool --bench-samples=5
+    ./pool --tasks=100000 --n=10000000 --bench-samples=5
+========================================================================== */
+
+#include <cmath>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../28.Compiler and Low-Level Optimizations/benchmark.h"
+#include "thread_pool.h"
+using namespace std;
+
+// About a microsecond of arithmetic.
+double work(size_t seed) {
+    double x = static_cast<double>(seed % 1000) + 1.0;
+    for (int i = 0; i < 250; ++i) x = x * 0.999 + 0.5 / x;
+    return x;
+}
+
+int main(int argc, char** argv) {
+    size_t taskCount = 10000, n = 4000000;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.rfind("--tasks=", 0) == 0) taskCount = strtoull(arg.c_str() + 8, nullptr, 10);
+        if (arg.rfind("--n=", 0) == 0) n = strtoull(arg.c_str() + 4, nullptr, 10);
+    }
+    tasks::ThreadPool pool;
+    const size_t cores = pool.size();
+    cout << cores << " workers, " << taskCount << " tasks, for loops over " << n
+         << " elements\n\n";
+
+    vector<double> results(taskCount);
+    auto steals = [&](bench::State& state, const tasks::ThreadPool::Stats& before) {
+        state.setCounter("steals", static_cast<double>(pool.stats().stolen - before.stolen));
+    };
+
+    bench::registerCase("spawn/thread_per_task", [&](bench::State& state) {
+        for (auto _ : state) {
+            vector<thread> threads;
+            threads.reserve(taskCount);
+            for (size_t i = 0; i < taskCount; ++i)
+                threads.emplace_back([&results, i] { results[i] = work(i); });
+            for (thread& t : threads) t.join();
+        }
+        state.setItemsProcessed(taskCount);
+    });
+
+    bench::registerCase("spawn/std_async", [&](bench::State& state) {
+        for (auto _ : state) {
+            vector<future<void>> futures;
+            futures.reserve(taskCount);
+            for (size_t i = 0; i < taskCount; ++i)
+                futures.push_back(async(launch::async, [&results, i] { results[i] = work(i); }));
+            for (future<void>& f : futures) f.get();
+        }
+        state.setItemsProcessed(taskCount);
+    });
+
+    bench::registerCase("spawn/pool_outside", [&](bench::State& state) {
+        tasks::ThreadPool::Stats before = pool.stats();
+        for (auto _ : state) {
+            tasks::TaskGroup group(pool);
+            for (size_t i = 0; i < taskCount; ++i)
+                group.run([&results, i] { results[i] = work(i); });
+            group.wait();
+        }
+        state.setItemsProcessed(taskCount);
+        steals(state, before);
+    });
+
+    bench::registerCase("spawn/pool_inside", [&](bench::State& state) {
+        tasks::ThreadPool::Stats before = pool.stats();
+        for (auto _ : state) {
+            tasks::TaskGroup group(pool);
+            group.run([&] {
+                for (size_t i = 0; i < taskCount; ++i)
+                    group.run([&results, i] { results[i] = work(i); });
+            });
+            group.wait();
+        }
+        state.setItemsProcessed(taskCount);
+        steals(state, before);
+    });
+
+    vector<double> out(n);
+    auto f = [&out](size_t i) { out[i] = sqrt(static_cast<double>(i)) * 1.5 + 1.0; };
+
+    bench::registerCase("for/serial", [&](bench::State& state) {
+        for (auto _ : state) {
+            for (size_t i = 0; i < n; ++i) f(i);
+            bench::DoNotOptimize(out.data());
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("for/threads", [&](bench::State& state) {
+        for (auto _ : state) {
+            vector<thread> threads;
+            for (size_t c = 0; c < cores; ++c)
+                threads.emplace_back([&, c] {
+                    for (size_t i = n * c / cores; i < n * (c + 1) / cores; ++i) f(i);
+                });
+            for (thread& t : threads) t.join();
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("for/pool", [&](bench::State& state) {
+        tasks::ThreadPool::Stats before = pool.stats();
+        for (auto _ : state) pool.parallelFor(0, n, f);
+        state.setItemsProcessed(n);
+        steals(state, before);
+    });
+
+    bench::registerCase("for/pool_grain1", [&](bench::State& state) {
+        const size_t small = min<size_t>(n, 1000000);
+        tasks::ThreadPool::Stats before = pool.stats();
+        for (auto _ : state) pool.parallelFor(0, small, f, 1);
+        state.setItemsProcessed(small);
+        steals(state, before);
+    });
+
+    int rc = bench::runAll(argc, argv);
+
+    // Lesson 1's two messages, as tasks of the pool.
+    mutex coutMutex;
+    tasks::TaskGroup group(pool);
+    for (int id = 1; id <= 2; ++id)
+        group.run([&coutMutex, id] {
+            lock_guard<mutex> lock(coutMutex);
+            cout << "Task " << id << ": Hello from the pool\n";
+        });
+    group.wait();
+    return rc;
+}
+
+/*
+What to expect:
+- spawn/thread_per_task and spawn/std_async cost tens of microseconds per
+  task (libstdc++'s std::async(launch::async) is a new thread too): the
+  microsecond of work is lost in the overhead.
+- spawn/pool_outside is 10-50x faster: each task costs a lock on the
+  shared queue. spawn/pool_inside is faster still, with tens of
+  nanoseconds per task on top of the work.
+- for/pool matches for/threads on large arrays without creating threads,
+  and for/pool_grain1 shows the bare cost of a task: items/s is tasks/s.
+- With one core, every method runs the work serially; only the overheads
+  differ. With several cores, "steals" shows the workers balancing the
+  load.
+- The last lines print "Task 1: ..." and "Task 2: ..." in either order.
+*/
@@ -0,0 +1,186 @@
+/* ==========================================================================
+Lesson 4: Continuations and Future Combinators
+
+Theory:
+---------
+Lesson 2 gets a value from another thread with std::async and get(). To
+run several steps one after the other, each step waits for the previous
+one in get(): a thread sits blocked per step, and std::async(launch::async)
+starts a new thread for each. future.h attaches the next step to a
+tasks::Future with then() instead; nothing blocks until the final get(),
+and the steps run on the work-stealing pool of Lesson 3.
+
+Key Points:
+- The chain cases run --steps steps, each adding one to the value of the
+  previous step. The fanout cases start --fanout tasks and sum their
+  results.
+- "allocs/step" counts calls of operator new per step (or per task):
+  std::async allocates a shared state and starts a thread; future.h
+  recycles its states in per-thread free lists.
+- chain/then_inline runs each step on the thread that completes the
+  previous one; chain/then_pool hands each step to the pool.
+
+Example:
+---------
+    chain/std_async      x = std::async(launch::async, step, x).get()
+    chain/then_inline    f = std::move(f).then(step)
+    chain/then_pool      f = std::move(f).then(pool, step)
+    fanout/std_async     futures[i] = std::async(...); sum += futures[i].get()
+    fanout/when_all      whenAll(tasks::async(pool, ...)...).then(sum).get()
+
+Compile & run:
+    g++ -std=c++17 -O2 -pthread "Lesson 4: Continuations and Future Combinators.cpp" -o futures
+    ./futures --bench-samples=5
+    ./futures --steps=10000 --fanout=10000 --bench-samples=5
+========================================================================== */
+
+#include <atomic>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <new>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../28.Compiler and Low-Level Optimizations/benchmark.h"
+#include "future.h"
+using namespace std;
+
+// Counts calls of the global operator new. noinline: GCC warns about
+// malloc/free pairs it sees through inlined replacements.
+atomic<size_t> allocations{0};
+
+__attribute__((noinline)) void* operator new(size_t size) {
+    allocations.fetch_add(1, memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void* p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { free(p); }
+
+long step(long x) { return x + 1; }
+
+int main(int argc, char** argv) {
+    size_t steps = 1000, fanout = 1000;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.rfind("--steps=", 0) == 0) steps = strtoull(arg.c_str() + 8, nullptr, 10);
+        if (arg.rfind("--fanout=", 0) == 0) fanout = strtoull(arg.c_str() + 9, nullptr, 10);
+    }
+    tasks::ThreadPool pool;
+    cout << pool.size() << " workers, chains of " << steps << " steps, fan-out of " << fanout
+         << " tasks\n\n";
+
+    // Runs `body` in the timed loop and reports operator new calls per item.
+    auto timed = [](bench::State& state, size_t items, auto body) {
+        size_t before = allocations.load(), runs = 0;
+        for (auto _ : state) {
+            body();
+            ++runs;
+        }
+        state.setItemsProcessed(items);
+        state.setCounter("allocs/step",
+                         static_cast<double>(allocations.load() - before) / (runs * items));
+    };
+    auto check = [](long got, size_t expected) {
+        if (got != static_cast<long>(expected)) throw logic_error("wrong result");
+    };
+
+    bench::registerCase("chain/std_async", [&](bench::State& state) {
+        timed(state, steps, [&] {
+            long x = 0;
+            for (size_t i = 0; i < steps; ++i) x = async(launch::async, step, x).get();
+            check(x, steps);
+        });
+    });
+
+    auto chain = [&](auto then) {
+        tasks::Promise<long> start;
+        tasks::Future<long> f = start.getFuture();
+        for (size_t i = 0; i < steps; ++i) f = then(std::move(f));
+        start.setValue(0);
+        check(f.get(), steps);
+    };
+
+    bench::registerCase("chain/then_inline", [&](bench::State& state) {
+        timed(state, steps, [&] {
+            chain([](tasks::Future<long> f) { return std::move(f).then(step); });
+        });
+    });
+
+    bench::registerCase("chain/then_pool", [&](bench::State& state) {
+        timed(state, steps, [&] {
+            chain([&](tasks::Future<long> f) { return std::move(f).then(pool, step); });
+        });
+    });
+
+    bench::registerCase("fanout/std_async", [&](bench::State& state) {
+        timed(state, fanout, [&] {
+            vector<future<long>> futures;
+            futures.reserve(fanout);
+            for (size_t i = 0; i < fanout; ++i) futures.push_back(async(launch::async, step, 0L));
+            long sum = 0;
+            for (future<long>& f : futures) sum += f.get();
+            check(sum, fanout);
+        });
+    });
+
+    bench::registerCase("fanout/when_all", [&](bench::State& state) {
+        timed(state, fanout, [&] {
+            vector<tasks::Future<long>> futures;
+            futures.reserve(fanout);
+            for (size_t i = 0; i < fanout; ++i)
+                futures.push_back(tasks::async(pool, [] { return step(0); }));
+            long sum = tasks::whenAll(std::move(futures))
+                           .then([](vector<long> values) {
+                               return accumulate(values.begin(), values.end(), 0L);
+                           })
+                           .get();
+            check(sum, fanout);
+        });
+    });
+
+    int rc = bench::runAll(argc, argv);
+
+    // An exception skips the following steps and comes out of get()...
+    tasks::Future<string> failed =
+        tasks::async(pool, []() -> long { throw runtime_error("disk full"); })
+            .then([](long x) { return to_string(x); });
+    try {
+        failed.get();
+    } catch (const runtime_error& e) {
+        cout << "\nget() rethrows: " << e.what() << '\n';
+    }
+
+    // ...unless recover() turns it into a value.
+    long recovered = tasks::async(pool, []() -> long { throw runtime_error("timeout"); })
+                         .recover([](exception_ptr) { return -1L; })
+                         .get();
+    cout << "recover(): " << recovered << '\n';
+
+    // whenAny: the first of several to complete.
+    vector<tasks::Future<long>> racers;
+    for (long i = 0; i < 3; ++i) racers.push_back(tasks::async(pool, [i] { return i * 10; }));
+    pair<size_t, long> first = tasks::whenAny(std::move(racers)).get();
+    cout << "whenAny(): future " << first.first << " won with " << first.second << '\n';
+    return rc;
+}
+
+/*
+What to expect:
+- chain/std_async starts a thread per step: over ten microseconds per
+  step, with three allocations each (shared state, thread state).
+- chain/then_inline costs about a hundred nanoseconds per step, building
+  the chain included, and allocs/step is 0: each step is one block from
+  the recycled free lists, and the whole chain runs on the thread that
+  calls setValue().
+- chain/then_pool adds one pool task per step and stays close to
+  then_inline, still without allocations.
+- fanout/when_all is about 50x faster than fanout/std_async; its
+  allocations (a few per hundred tasks) are the vector of futures and
+  whenAll's bookkeeping, not a state per task.
+- The last lines show "get() rethrows: disk full", "recover(): -1" and
+  "whenAny(): future N won with N*10" (usually future 0).
+*/
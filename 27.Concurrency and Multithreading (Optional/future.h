@@ -0,0 +1,878 @@
+/* ==========================================================================
+future.h - Futures with Continuations
+
+Theory:
+---------
+Lesson 2 waits for std::async with future::get(). A thread that calls
+get() sleeps until the value is there, so a chain "compute, then parse,
+then store" either blocks a thread per step or is written as one big
+function. std::future has no way to say "when this is ready, do that".
+
+tasks::Future<T> can:
+1. `then(f)`: attach the next step. f(value) runs as soon as the value is
+   set, on the thread that set it, and its result is a new Future. If f
+   returns a Future itself, the result waits for that one too. Steps that
+   become ready inside another step run after it returns, from a loop, so
+   a long chain does not grow the stack.
+2. `then(executor, f)`: the same, but f is handed to an executor, for
+   example a tasks::ThreadPool (thread_pool.h) or tasks::InlineExecutor.
+3. `recover(f)`: turn an exception into a value.
+4. `whenAll(futures)` / `whenAny(futures)`: one future for several.
+
+An exception thrown by a step skips the following then() steps and comes
+out of get() (or reaches recover()).
+
+Every shared state and every continuation is one allocation, taken from
+a per-thread free list of fixed-size blocks and recycled, so a chain
+needs no malloc per step once the lists are warm. then() stores its step
+inside the state of the future it returns: a step is one block.
+
+Key Points:
+- `tasks::async(pool, f)` starts f on the pool and returns Future<R>.
+- `tasks::Promise<T> p; Future<T> f = p.getFuture(); p.setValue(x);`
+- A Future is move-only and single-use: get(), then() and recover()
+  consume it. Combining futures also consumes them.
+- `whenAll(vector<Future<T>>)` -> Future<vector<T>> (Future<void> for
+  void); `whenAll(fa, fb, ...)` -> Future<tuple<A, B, ...>> (no void
+  futures). They complete when every input has; the first exception, if
+  any, wins.
+- `whenAny(vector<Future<T>>)` -> Future<pair<size_t, T>> (index and
+  value of the first to complete; Future<size_t> for void).
+- get() blocks the calling thread (on a futex). Do not call it on a
+  worker of the pool that has to produce the value, nor inside a step
+  for a future that an inline step on the same thread completes (that
+  step waits in the queue behind the blocked one): use then().
+- Edge Cases: a Promise destroyed without a value sets a
+  std::future_error(broken_promise).
+========================================================================== */
+
+#ifndef FUTURE_H
+#define FUTURE_H
+
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.h"
+
+namespace tasks {
+
+template <class T>
+class Future;
+template <class T>
+class Promise;
+
+// Runs every function where it is handed over: on the thread that
+// completes the previous step.
+struct InlineExecutor {
+    template <class F>
+    void submit(F&& f) {
+        std::forward<F>(f)();
+    }
+};
+
+namespace detail {
+
+// ---------------------------------------------------------------------------
+// Block pool: recycled blocks of 64, 128, 256 and 512 bytes. Each thread
+// keeps its own free lists; a list that grows too long gives half of its
+// blocks to a shared list, which also refills empty lists. Blocks are never
+// returned to the system.
+// ---------------------------------------------------------------------------
+
+class BlockPool {
+public:
+    static constexpr int kClasses = 4;
+    static constexpr std::size_t kMaxBlock = 512;
+
+    static void* allocate(std::size_t size) {
+        if (size > kMaxBlock) return ::operator new(size);
+        return local().pop(classOf(size));
+    }
+
+    static void free(void* p, std::size_t size) {
+        if (size > kMaxBlock) return ::operator delete(p);
+        local().push(classOf(size), static_cast<Node*>(p));
+    }
+
+private:
+    struct Node {
+        Node* next;
+    };
+
+    static constexpr std::size_t kBatch = 64;       // moved to/from the shared lists at once
+    static constexpr std::size_t kMaxLocal = 256;   // per class and thread
+
+    static int classOf(std::size_t size) {
+        return size <= 64 ? 0 : size <= 128 ? 1 : size <= 256 ? 2 : 3;
+    }
+    static std::size_t blockSize(int c) { return std::size_t(64) << c; }
+
+    // Chains of kBatch blocks, shared by all threads. Never destroyed:
+    // threads may exit after static destructors have run.
+    struct Shared {
+        std::mutex mutex;
+        std::vector<std::pair<Node*, std::size_t>> batches[kClasses];
+    };
+    static Shared& shared() {
+        static Shared* s = new Shared;
+        return *s;
+    }
+
+    struct Local {
+        Node* head[kClasses] = {};
+        std::size_t count[kClasses] = {};
+
+        ~Local() {
+            for (int c = 0; c < kClasses; ++c)
+                while (count[c] > 0) giveBatch(c);
+        }
+
+        Node* pop(int c) {
+            if (!head[c]) refill(c);
+            Node* n = head[c];
+            head[c] = n->next;
+            --count[c];
+            return n;
+        }
+
+        void push(int c, Node* n) {
+            n->next = head[c];
+            head[c] = n;
+            if (++count[c] > kMaxLocal) giveBatch(c);
+        }
+
+        void refill(int c) {
+            {
+                Shared& s = shared();
+                std::lock_guard<std::mutex> lock(s.mutex);
+                if (!s.batches[c].empty()) {
+                    std::tie(head[c], count[c]) = s.batches[c].back();
+                    s.batches[c].pop_back();
+                    return;
+                }
+            }
+            char* chunk = static_cast<char*>(::operator new(kBatch * blockSize(c)));
+            for (std::size_t i = 0; i < kBatch; ++i) {
+                Node* n = reinterpret_cast<Node*>(chunk + i * blockSize(c));
+                n->next = head[c];
+                head[c] = n;
+            }
+            count[c] = kBatch;
+        }
+
+        // Moves up to kBatch blocks to the shared lists.
+        void giveBatch(int c) {
+            Node* first = head[c];
+            Node* last = first;
+            std::size_t n = 1;
+            while (n < kBatch && last->next) {
+                last = last->next;
+                ++n;
+            }
+            head[c] = last->next;
+            count[c] -= n;
+            last->next = nullptr;
+            Shared& s = shared();
+            std::lock_guard<std::mutex> lock(s.mutex);
+            s.batches[c].emplace_back(first, n);
+        }
+    };
+
+    static Local& local() {
+        thread_local Local l;
+        return l;
+    }
+};
+
+// Objects allocated from the block pool.
+template <class T, class... Args>
+T* makePooled(Args&&... args) {
+    void* p = BlockPool::allocate(sizeof(T));
+    try {
+        return ::new (p) T(std::forward<Args>(args)...);
+    } catch (...) {
+        BlockPool::free(p, sizeof(T));
+        throw;
+    }
+}
+
+template <class T>
+void destroyPooled(T* p) {
+    p->~T();
+    BlockPool::free(p, sizeof(T));
+}
+
+// ---------------------------------------------------------------------------
+// Shared state
+// ---------------------------------------------------------------------------
+
+struct Unit {};
+
+template <class T>
+using Stored = std::conditional_t<std::is_void<T>::value, Unit, T>;
+
+// Something to run once a state is ready.
+struct Continuation {
+    void (*run)(Continuation*);
+    Continuation* next = nullptr;  // in the trampoline queue
+};
+
+// Runs c on this thread. If the thread is already running a continuation
+// (c became ready inside another step), c is queued and run when that one
+// returns: a chain of n inline steps then uses constant stack instead of n
+// nested setValue() frames.
+inline void runContinuation(Continuation* c) {
+    struct Trampoline {
+        Continuation* head = nullptr;
+        Continuation* tail = nullptr;
+        bool running = false;
+    };
+    thread_local Trampoline t;
+    if (t.running) {
+        c->next = nullptr;
+        (t.tail ? t.tail->next : t.head) = c;
+        t.tail = c;
+        return;
+    }
+    t.running = true;
+    struct Reset {
+        bool& flag;
+        ~Reset() { flag = false; }
+    } reset{t.running};
+    c->run(c);
+    while (Continuation* q = t.head) {
+        t.head = q->next;
+        if (!t.head) t.tail = nullptr;
+        q->run(q);
+    }
+}
+
+// Marks the continuation slot of a ready state.
+inline Continuation* readyMarker() {
+    static Continuation marker{nullptr};
+    return &marker;
+}
+
+// The value (or exception) of a future, the continuation to run when it is
+// set, and a reference count: the producer (promise or step) and the
+// consumer (future) hold one each. Derived classes (the steps) destroy
+// themselves through destroy_.
+template <class T>
+class SharedState {
+public:
+    using Value = Stored<T>;
+
+    void addRef() { refs_.fetch_add(1, std::memory_order_relaxed); }
+
+    void release() {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) destroy_(this);
+    }
+
+    template <class... Args>
+    void setValue(Args&&... args) {
+        value_.emplace(std::forward<Args>(args)...);
+        publish();
+    }
+
+    void setException(std::exception_ptr error) {
+        error_ = std::move(error);
+        publish();
+    }
+
+    bool ready() const { return (status_.load(std::memory_order_acquire) & kReady) != 0; }
+
+    // Runs c when the state is ready: at once if it already is.
+    void setContinuation(Continuation* c) {
+        Continuation* expected = nullptr;
+        if (!continuation_.compare_exchange_strong(expected, c, std::memory_order_acq_rel))
+            runContinuation(c);  // already ready
+    }
+
+    void wait() {
+        for (;;) {
+            std::uint32_t s = status_.load(std::memory_order_acquire);
+            if (s & kReady) return;
+            if (!(s & kWaiting) && !status_.compare_exchange_weak(s, s | kWaiting,
+                                                                  std::memory_order_acquire))
+                continue;
+            futexWait(status_, s | kWaiting);
+        }
+    }
+
+    bool failed() const { return error_ != nullptr; }
+    const std::exception_ptr& error() const { return error_; }
+    Value& value() { return *value_; }
+
+    Value take() {
+        if (error_) std::rethrow_exception(error_);
+        return std::move(*value_);
+    }
+
+protected:
+    using Destroy = void (*)(SharedState*);
+
+    explicit SharedState(Destroy destroy, int refs) : refs_(refs), destroy_(destroy) {}
+    ~SharedState() = default;
+
+private:
+    static constexpr std::uint32_t kReady = 1, kWaiting = 2;
+
+    void publish() {
+        if (status_.exchange(kReady, std::memory_order_acq_rel) & kWaiting)
+            futexWake(status_, INT_MAX);
+        Continuation* c = continuation_.exchange(readyMarker(), std::memory_order_acq_rel);
+        if (c) runContinuation(c);
+    }
+
+    std::atomic<int> refs_;
+    std::atomic<std::uint32_t> status_{0};
+    std::atomic<Continuation*> continuation_{nullptr};
+    Destroy destroy_;
+    std::optional<Value> value_;
+    std::exception_ptr error_;
+};
+
+// A state with nothing attached: promises, async().
+template <class T>
+class PlainState final : public SharedState<T> {
+public:
+    explicit PlainState(int refs) : SharedState<T>(&destroy, refs) {}
+
+private:
+    static void destroy(SharedState<T>* s) { destroyPooled(static_cast<PlainState*>(s)); }
+};
+
+template <class T>
+struct IsFuture : std::false_type {
+    using Inner = T;
+};
+template <class T>
+struct IsFuture<Future<T>> : std::true_type {
+    using Inner = T;
+};
+
+// What f returns when called with the value of a Future<Arg>.
+template <class F, class Arg, bool = std::is_void<Arg>::value>
+struct StepResult {
+    using type = std::invoke_result_t<F&, Arg&&>;
+};
+template <class F, class Arg>
+struct StepResult<F, Arg, true> {
+    using type = std::invoke_result_t<F&>;
+};
+
+// Sets `state` from a call of f(args...), or from the exception it throws.
+// A returned Future is forwarded by the caller.
+template <class T, class F, class... Args>
+void setFromCall(SharedState<T>& state, F& f, Args&&... args) {
+    try {
+        if constexpr (std::is_void<T>::value) {
+            f(std::forward<Args>(args)...);
+            state.setValue();
+        } else {
+            state.setValue(f(std::forward<Args>(args)...));
+        }
+    } catch (...) {
+        state.setException(std::current_exception());
+    }
+}
+
+// Forwards an inner future's outcome into `state`.
+template <class T>
+void setFrom(SharedState<T>& state, SharedState<T>& from) {
+    if (from.failed())
+        state.setException(from.error());
+    else
+        state.setValue(std::move(from.value()));
+}
+
+template <class T>
+Future<T> futureOf(SharedState<T>* state);
+
+template <class T>
+SharedState<T>* stateOf(Future<T>& future);
+
+// then(): one block that is the step (continuation of the parent), the
+// state of the returned future and, if the step returns a Future, the
+// continuation of that future too.
+//   Arg: the parent's T; R: what the returned future holds.
+template <class Arg, class R, class F, class Ex, bool Recover>
+class ThenState final : public SharedState<R>, private Continuation {
+public:
+    ThenState(SharedState<Arg>* parent, F&& f, Ex* executor)
+        : SharedState<R>(&destroy, 2), parent_(parent), f_(std::move(f)), executor_(executor) {
+        Continuation::run = &onReady;
+    }
+
+    void start() { parent_->setContinuation(this); }
+
+private:
+    using Result = typename std::conditional_t<Recover, std::enable_if<true, R>,
+                                               StepResult<F, Arg>>::type;
+    static constexpr bool kUnwrap = IsFuture<Result>::value;
+
+    static void destroy(SharedState<R>* s) { destroyPooled(static_cast<ThenState*>(s)); }
+
+    static void onReady(Continuation* c) {
+        ThenState* self = static_cast<ThenState*>(c);
+        if (self->forwarding_) {
+            self->finishForward();
+        } else if (self->executor_) {
+            self->executor_->submit([self] { self->step(); });
+        } else {
+            self->step();
+        }
+    }
+
+    void step() {
+        SharedState<Arg>* parent = parent_;
+        parent_ = nullptr;
+        if constexpr (Recover) {
+            if (parent->failed())
+                setFromCall(*this, f_, parent->error());
+            else
+                setFrom(*this, *parent);
+            parent->release();
+            done();
+        } else if (parent->failed()) {
+            this->setException(parent->error());
+            parent->release();
+            done();
+        } else if constexpr (kUnwrap) {
+            std::optional<Result> inner;
+            try {
+                if constexpr (std::is_void<Arg>::value)
+                    inner.emplace(f_());
+                else
+                    inner.emplace(f_(std::move(parent->value())));
+            } catch (...) {
+                this->setException(std::current_exception());
+            }
+            parent->release();
+            if (!inner) return done();
+            inner_ = stateOf(*inner);  // the Future's reference is now ours
+            forwarding_ = true;
+            inner_->setContinuation(this);
+        } else {
+            if constexpr (std::is_void<Arg>::value)
+                setFromCall(*this, f_);
+            else
+                setFromCall(*this, f_, std::move(parent->value()));
+            parent->release();
+            done();
+        }
+    }
+
+    void finishForward() {
+        if constexpr (kUnwrap) {
+            setFrom(*this, *inner_);
+            inner_->release();
+        }
+        done();
+    }
+
+    void done() { this->release(); }  // the producer's reference
+
+    using InnerState = std::conditional_t<kUnwrap, SharedState<R>, Unit>;
+
+    SharedState<Arg>* parent_;
+    F f_;
+    Ex* executor_;  // nullptr: run where the parent completes
+    InnerState* inner_ = nullptr;
+    bool forwarding_ = false;
+};
+
+}  // namespace detail
+
+template <class T>
+class Future {
+public:
+    Future() = default;
+    Future(Future&& other) noexcept : state_(std::exchange(other.state_, nullptr)) {}
+    Future& operator=(Future&& other) noexcept {
+        if (this != &other) {
+            reset();
+            state_ = std::exchange(other.state_, nullptr);
+        }
+        return *this;
+    }
+    ~Future() { reset(); }
+
+    bool valid() const { return state_ != nullptr; }
+    bool isReady() const { return state_ && state_->ready(); }
+
+    void wait() const { state_->wait(); }
+
+    // Blocks until ready; returns the value or throws the exception.
+    T get() {
+        Future self = std::move(*this);
+        self.state_->wait();
+        if constexpr (std::is_void<T>::value)
+            self.state_->take();
+        else
+            return self.state_->take();
+    }
+
+    // f(value) (f() for Future<void>) runs when the value is set, on the
+    // thread that sets it.
+    template <class F>
+    auto then(F&& f) {
+        return thenOn<InlineExecutor>(nullptr, std::forward<F>(f));
+    }
+
+    // f runs on `executor` (anything with submit(callable)), which must
+    // outlive the step.
+    template <class Ex, class F>
+    auto then(Ex& executor, F&& f) {
+        return thenOn(&executor, std::forward<F>(f));
+    }
+
+    // f(std::exception_ptr) -> T replaces an exception; a value passes.
+    template <class F>
+    Future<T> recover(F&& f) {
+        using Step =
+            detail::ThenState<T, T, std::decay_t<F>, InlineExecutor, true>;
+        std::decay_t<F> fn(std::forward<F>(f));
+        Step* step = detail::makePooled<Step>(std::exchange(state_, nullptr), std::move(fn),
+                                              nullptr);
+        Future<T> result(step);
+        step->start();
+        return result;
+    }
+
+private:
+    template <class U>
+    friend class Future;
+    template <class U>
+    friend class Promise;
+    template <class U>
+    friend Future<U> detail::futureOf(detail::SharedState<U>*);
+    template <class U>
+    friend detail::SharedState<U>* detail::stateOf(Future<U>&);
+
+    explicit Future(detail::SharedState<T>* state) : state_(state) {}
+
+    void reset() {
+        if (state_) std::exchange(state_, nullptr)->release();
+    }
+
+    template <class Ex, class F>
+    auto thenOn(Ex* executor, F&& f) {
+        using Fn = std::decay_t<F>;
+        using R = typename detail::IsFuture<typename detail::StepResult<Fn, T>::type>::Inner;
+        return makeStep<R, Fn, Ex>(executor, Fn(std::forward<F>(f)));
+    }
+
+    template <class R, class Fn, class Ex>
+    Future<R> makeStep(Ex* executor, Fn&& fn) {
+        using Step = detail::ThenState<T, R, Fn, Ex, false>;
+        Step* step = detail::makePooled<Step>(std::exchange(state_, nullptr), std::move(fn),
+                                              executor);
+        Future<R> result(step);
+        step->start();
+        return result;
+    }
+
+    detail::SharedState<T>* state_ = nullptr;
+};
+
+template <class T>
+class Promise {
+public:
+    Promise() : state_(detail::makePooled<detail::PlainState<T>>(1)) {}
+    Promise(Promise&& other) noexcept
+        : state_(std::exchange(other.state_, nullptr)),
+          retrieved_(other.retrieved_),
+          satisfied_(other.satisfied_) {}
+    Promise& operator=(Promise&& other) noexcept {
+        if (this != &other) {
+            abandon();
+            state_ = std::exchange(other.state_, nullptr);
+            retrieved_ = other.retrieved_;
+            satisfied_ = other.satisfied_;
+        }
+        return *this;
+    }
+    ~Promise() { abandon(); }
+
+    Future<T> getFuture() {
+        if (retrieved_) throw std::future_error(std::future_errc::future_already_retrieved);
+        retrieved_ = true;
+        state_->addRef();
+        return Future<T>(state_);
+    }
+
+    template <class... Args>
+    void setValue(Args&&... args) {
+        satisfy();
+        state_->setValue(std::forward<Args>(args)...);
+    }
+
+    void setException(std::exception_ptr error) {
+        satisfy();
+        state_->setException(std::move(error));
+    }
+
+private:
+    void satisfy() {
+        if (satisfied_) throw std::future_error(std::future_errc::promise_already_satisfied);
+        satisfied_ = true;
+    }
+
+    void abandon() {
+        if (!state_) return;
+        if (!satisfied_)
+            state_->setException(
+                std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        std::exchange(state_, nullptr)->release();
+    }
+
+    detail::SharedState<T>* state_;
+    bool retrieved_ = false;
+    bool satisfied_ = false;
+};
+
+namespace detail {
+
+template <class T>
+Future<T> futureOf(SharedState<T>* state) {
+    return Future<T>(state);
+}
+
+template <class T>
+SharedState<T>* stateOf(Future<T>& future) {
+    return std::exchange(future.state_, nullptr);
+}
+
+}  // namespace detail
+
+template <class T, class... Args>
+Future<T> makeReadyFuture(Args&&... args) {
+    auto* state = detail::makePooled<detail::PlainState<T>>(1);
+    state->setValue(std::forward<Args>(args)...);
+    return detail::futureOf<T>(state);
+}
+
+template <class T>
+Future<T> makeExceptionalFuture(std::exception_ptr error) {
+    auto* state = detail::makePooled<detail::PlainState<T>>(1);
+    state->setException(std::move(error));
+    return detail::futureOf<T>(state);
+}
+
+// Runs f() on `executor`; the future holds its result.
+template <class Ex, class F>
+auto async(Ex& executor, F&& f) {
+    return makeReadyFuture<void>().then(executor, std::forward<F>(f));
+}
+
+namespace detail {
+
+// whenAll / whenAny: a state with one continuation per input. The inputs'
+// states are released as they complete.
+template <class T, class R, bool Any>
+class GatherState final : public SharedState<R> {
+public:
+    explicit GatherState(std::vector<Future<T>>&& inputs)
+        : SharedState<R>(&destroy, 2), nodes_(inputs.size()), remaining_(inputs.size() + 1) {
+        if constexpr (!Any && !std::is_void<T>::value) values_.resize(inputs.size());
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+            nodes_[i].run = &onReady;
+            nodes_[i].owner = this;
+            nodes_[i].index = i;
+            nodes_[i].input = stateOf(inputs[i]);
+        }
+    }
+
+    void start() {
+        for (Node& node : nodes_) node.input->setContinuation(&node);
+        arrive();  // the reference held during start()
+    }
+
+private:
+    struct Node : Continuation {
+        GatherState* owner;
+        std::size_t index;
+        SharedState<T>* input;
+    };
+
+    static void destroy(SharedState<R>* s) { destroyPooled(static_cast<GatherState*>(s)); }
+
+    static void onReady(Continuation* c) {
+        Node* node = static_cast<Node*>(c);
+        GatherState* self = node->owner;
+        SharedState<T>* input = std::exchange(node->input, nullptr);
+        if constexpr (Any) {
+            if (!self->decided_.exchange(true, std::memory_order_acq_rel)) {
+                if (input->failed())
+                    self->setException(input->error());
+                else if constexpr (std::is_void<T>::value)
+                    self->setValue(node->index);
+                else
+                    self->setValue(node->index, std::move(input->value()));
+            }
+        } else {
+            if (input->failed()) {
+                if (!self->failed_.exchange(true, std::memory_order_acq_rel))
+                    self->firstError_ = input->error();
+            } else if constexpr (!std::is_void<T>::value) {
+                self->values_[node->index].emplace(std::move(input->value()));
+            }
+        }
+        input->release();
+        self->arrive();
+    }
+
+    void arrive() {
+        if (remaining_.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        if constexpr (!Any) {
+            if (firstError_)
+                this->setException(firstError_);
+            else if constexpr (std::is_void<T>::value)
+                this->setValue();
+            else
+                this->setValue(collect());
+        } else if (nodes_.empty()) {
+            this->setException(std::make_exception_ptr(
+                std::invalid_argument("tasks::whenAny: no futures")));
+        }
+        this->release();  // the producer's reference
+    }
+
+    std::vector<Stored<T>> collect() {
+        std::vector<Stored<T>> values;
+        values.reserve(values_.size());
+        for (std::optional<Stored<T>>& v : values_) values.push_back(std::move(*v));
+        return values;
+    }
+
+    std::vector<Node> nodes_;
+    std::atomic<std::size_t> remaining_;
+    std::vector<std::optional<Stored<T>>> values_;  // empty for void and whenAny
+    std::exception_ptr firstError_;
+    std::atomic<bool> failed_{false};
+    std::atomic<bool> decided_{false};
+};
+
+template <class... Ts>
+class TupleState final : public SharedState<std::tuple<Ts...>> {
+public:
+    explicit TupleState(Future<Ts>&&... inputs)
+        : SharedState<std::tuple<Ts...>>(&destroy, 2),
+          inputs_(stateOf(inputs)...) {}
+
+    void start() {
+        startAll(std::index_sequence_for<Ts...>{});
+        arrive();
+    }
+
+private:
+    template <std::size_t I>
+    struct Node : Continuation {
+        TupleState* owner;
+    };
+
+    static void destroy(SharedState<std::tuple<Ts...>>* s) {
+        destroyPooled(static_cast<TupleState*>(s));
+    }
+
+    template <std::size_t... Is>
+    void startAll(std::index_sequence<Is...>) {
+        ((std::get<Is>(nodes_).run = &onReady<Is>, std::get<Is>(nodes_).owner = this), ...);
+        (std::get<Is>(inputs_)->setContinuation(&std::get<Is>(nodes_)), ...);
+    }
+
+    template <std::size_t I>
+    static void onReady(Continuation* c) {
+        TupleState* self = static_cast<Node<I>*>(c)->owner;
+        auto* input = std::get<I>(self->inputs_);
+        if (input->failed()) {
+            if (!self->failed_.exchange(true, std::memory_order_acq_rel))
+                self->firstError_ = input->error();
+        }
+        self->arrive();
+    }
+
+    template <std::size_t... Is>
+    void finish(std::index_sequence<Is...>) {
+        this->setValue(std::move(std::get<Is>(inputs_)->value())...);
+    }
+
+    void arrive() {
+        if (remaining_.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        if (firstError_)
+            this->setException(firstError_);
+        else
+            finish(std::index_sequence_for<Ts...>{});
+        std::apply([](auto*... input) { (input->release(), ...); }, inputs_);
+        this->release();
+    }
+
+    template <class Seq>
+    struct NodesOf;
+    template <std::size_t... Is>
+    struct NodesOf<std::index_sequence<Is...>> {
+        using type = std::tuple<Node<Is>...>;
+    };
+
+    std::tuple<SharedState<Ts>*...> inputs_;
+    typename NodesOf<std::index_sequence_for<Ts...>>::type nodes_;
+    std::atomic<std::size_t> remaining_{sizeof...(Ts) + 1};
+    std::exception_ptr firstError_;
+    std::atomic<bool> failed_{false};
+};
+
+template <class T>
+using AllResult = std::conditional_t<std::is_void<T>::value, void, std::vector<Stored<T>>>;
+template <class T>
+using AnyResult = std::conditional_t<std::is_void<T>::value, std::size_t,
+                                     std::pair<std::size_t, Stored<T>>>;
+
+}  // namespace detail
+
+// Completes when every future has; holds all values in order, or the first
+// exception.
+template <class T>
+Future<detail::AllResult<T>> whenAll(std::vector<Future<T>> futures) {
+    using State = detail::GatherState<T, detail::AllResult<T>, false>;
+    State* state = detail::makePooled<State>(std::move(futures));
+    Future<detail::AllResult<T>> result = detail::futureOf<detail::AllResult<T>>(state);
+    state->start();
+    return result;
+}
+
+template <class... Ts>
+Future<std::tuple<Ts...>> whenAll(Future<Ts>... futures) {
+    using State = detail::TupleState<Ts...>;
+    State* state = detail::makePooled<State>(std::move(futures)...);
+    Future<std::tuple<Ts...>> result = detail::futureOf<std::tuple<Ts...>>(state);
+    state->start();
+    return result;
+}
+
+// Completes with the first future to complete: its index and value, or its
+// exception.
+template <class T>
+Future<detail::AnyResult<T>> whenAny(std::vector<Future<T>> futures) {
+    using State = detail::GatherState<T, detail::AnyResult<T>, true>;
+    State* state = detail::makePooled<State>(std::move(futures));
+    Future<detail::AnyResult<T>> result = detail::futureOf<detail::AnyResult<T>>(state);
+    state->start();
+    return result;
+}
+
+}  // namespace tasks
+
+#endif  // FUTURE_H
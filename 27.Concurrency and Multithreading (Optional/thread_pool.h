@@ -0,0 +1,670 @@
+/* ==========================================================================
+thread_pool.h - Work-Stealing Thread Pool
+
+Theory:
+---------
+Lesson 1 starts one std::thread per piece of work. Creating, starting and
+joining a thread costs tens of microseconds, so for small tasks the program
+spends its time creating threads instead of working. A thread pool starts
+its threads once and hands them tasks.
+
+tasks::ThreadPool is a work-stealing pool:
+1. Every worker owns a deque of tasks (the Chase-Lev deque). It pushes and
+   pops at the bottom without locks: a task spawned by a task runs on the
+   same thread, while its data is still in the cache.
+2. A worker whose deque is empty takes a task from the top of the deque of
+   another worker chosen at random ("stealing"). Thieves only touch the
+   top, so they rarely disturb the owner.
+3. Tasks submitted from outside the pool go to a shared queue that idle
+   workers check first.
+4. A worker that finds nothing anywhere sleeps in the kernel (a futex)
+   instead of spinning. Submitting wakes a sleeping worker only when no
+   other worker is already looking for work, so a burst of submissions
+   does not turn into a burst of system calls.
+5. Task objects come from a free list of the worker that creates them;
+   the lambda is stored inside the task when it is at most 32 bytes. A
+   task spawned inside the pool does not allocate.
+
+Key Points:
+- `pool.submit(f)` runs f() some time later. An exception escaping f
+  calls std::terminate, as with std::thread.
+- `tasks::TaskGroup group(pool); group.run(f); ... group.wait();` waits
+  for a set of tasks and rethrows the first exception. A worker that
+  waits runs other tasks meanwhile, so groups can nest (divide and
+  conquer) without blocking threads; when there is nothing left to run,
+  it sleeps until the group's last task finishes.
+- `pool.parallelFor(0, n, [&](size_t i) { ... });` splits [0, n) in
+  halves until a piece has `grain` indices (default n / (8 * threads)).
+- The destructor runs every task already submitted (and the tasks they
+  spawn), then joins the workers. Nothing may be submitted from outside
+  once it has started.
+- Linux only (futex); x86-64 and AArch64 spin hints.
+========================================================================== */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace tasks {
+
+class ThreadPool;
+class TaskGroup;
+
+namespace detail {
+
+inline void futexWait(std::atomic<std::uint32_t>& word, std::uint32_t expected) {
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected,
+            nullptr, nullptr, 0);
+}
+
+inline void futexWake(std::atomic<std::uint32_t>& word, int count) {
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, count,
+            nullptr, nullptr, 0);
+}
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+class TaskAllocator;
+
+// One unit of work: a callable stored inline (or behind a pointer when it
+// is larger than kInline bytes) and the function that runs it.
+struct alignas(64) Task {
+    static constexpr std::size_t kInline = 32;
+
+    void (*run)(Task*);             // runs the callable, destroys it, frees the task
+    Task* next;                     // free lists
+    TaskAllocator* home;            // nullptr: allocated with new
+    TaskGroup* group;               // counts down when done; may be nullptr
+    alignas(16) unsigned char storage[kInline];
+};
+static_assert(sizeof(Task) == 64, "a task is one cache line");
+
+// Free list of tasks, owned by one worker. Other threads give tasks back
+// through a lock-free stack that the owner empties when its list runs out.
+class TaskAllocator {
+public:
+    TaskAllocator() = default;
+    TaskAllocator(const TaskAllocator&) = delete;
+    TaskAllocator& operator=(const TaskAllocator&) = delete;
+
+    ~TaskAllocator() {
+        for (Task* slab : slabs_) delete[] slab;
+    }
+
+    Task* allocate() {
+        if (!free_) free_ = remote_.exchange(nullptr, std::memory_order_acquire);
+        if (!free_) grow();
+        Task* task = free_;
+        free_ = task->next;
+        return task;
+    }
+
+    // Owner only.
+    void freeLocal(Task* task) {
+        task->next = free_;
+        free_ = task;
+    }
+
+    // Any thread.
+    void freeRemote(Task* task) {
+        Task* head = remote_.load(std::memory_order_relaxed);
+        do {
+            task->next = head;
+        } while (!remote_.compare_exchange_weak(head, task, std::memory_order_release,
+                                                std::memory_order_relaxed));
+    }
+
+private:
+    static constexpr std::size_t kSlab = 256;
+
+    void grow() {
+        Task* slab = new Task[kSlab];
+        slabs_.push_back(slab);
+        for (std::size_t i = 0; i < kSlab; ++i) freeLocal(&slab[i]);
+    }
+
+    Task* free_ = nullptr;
+    std::vector<Task*> slabs_;
+    alignas(64) std::atomic<Task*> remote_{nullptr};
+};
+
+// The allocator of the worker running on this thread, if any.
+inline TaskAllocator*& currentAllocator() {
+    thread_local TaskAllocator* allocator = nullptr;
+    return allocator;
+}
+
+inline void freeTask(Task* task) {
+    if (!task->home)
+        delete task;
+    else if (task->home == currentAllocator())
+        task->home->freeLocal(task);
+    else
+        task->home->freeRemote(task);
+}
+
+// Chase-Lev work-stealing deque ("Dynamic Circular Work-Stealing Deque",
+// 2005), with the memory orders of Le, Pop, Cohen and Zappa Nardelli
+// (PPoPP 2013). The owner pushes and pops at the bottom; any thread may
+// steal from the top. The array doubles when full; old arrays are kept
+// until the deque is destroyed, because a thief may still be reading one.
+class WorkStealingDeque {
+public:
+    explicit WorkStealingDeque(std::size_t capacity = 256) {
+        arrays_.push_back(std::make_unique<Array>(capacity));
+        array_.store(arrays_.back().get(), std::memory_order_relaxed);
+    }
+
+    // Owner only.
+    void push(Task* task) {
+        const std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        const std::int64_t t = top_.load(std::memory_order_acquire);
+        Array* a = array_.load(std::memory_order_relaxed);
+        if (b - t > static_cast<std::int64_t>(a->mask)) a = grow(a, t, b);
+        a->put(b, task);
+        bottom_.store(b + 1, std::memory_order_release);
+    }
+
+    // Owner only. Newest task first; nullptr if empty.
+    Task* pop() {
+        const std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        Array* a = array_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        Task* task = a->get(b);
+        if (t == b) {  // the last task: race the thieves for it
+            if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                              std::memory_order_relaxed))
+                task = nullptr;
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return task;
+    }
+
+    // Any thread. Oldest task first; nullptr if empty or if another thread
+    // took it first (then `lost` is set).
+    Task* steal(bool& lost) {
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) return nullptr;
+        Array* a = array_.load(std::memory_order_acquire);
+        Task* task = a->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            lost = true;
+            return nullptr;
+        }
+        return task;
+    }
+
+    bool looksEmpty() const {
+        return top_.load(std::memory_order_relaxed) >= bottom_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Array {
+        explicit Array(std::size_t capacity)
+            : mask(capacity - 1), slots(new std::atomic<Task*>[capacity]) {}
+
+        Task* get(std::int64_t i) const {
+            return slots[static_cast<std::size_t>(i) & mask].load(std::memory_order_relaxed);
+        }
+        void put(std::int64_t i, Task* task) {
+            slots[static_cast<std::size_t>(i) & mask].store(task, std::memory_order_relaxed);
+        }
+
+        std::size_t mask;
+        std::unique_ptr<std::atomic<Task*>[]> slots;
+    };
+
+    Array* grow(Array* old, std::int64_t t, std::int64_t b) {
+        arrays_.push_back(std::make_unique<Array>(2 * (old->mask + 1)));
+        Array* bigger = arrays_.back().get();
+        for (std::int64_t i = t; i < b; ++i) bigger->put(i, old->get(i));
+        array_.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    alignas(64) std::atomic<std::int64_t> top_{0};     // thieves
+    alignas(64) std::atomic<std::int64_t> bottom_{0};  // owner
+    std::atomic<Array*> array_{nullptr};
+    std::vector<std::unique_ptr<Array>> arrays_;       // owner; the last one is current
+};
+
+template <class Fn, bool Inline>
+void runTask(Task* task);
+
+}  // namespace detail
+
+// A set of tasks to wait for. The counter doubles as the futex word that a
+// waiting thread outside the pool sleeps on.
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool& pool) : pool_(pool) {}
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    ~TaskGroup() { waitForAll(); }
+
+    template <class F>
+    void run(F&& f);
+
+    // Returns when every task run() so far has finished, and rethrows the
+    // first exception one of them threw.
+    void wait() {
+        waitForAll();
+        if (error_) {
+            std::exception_ptr error = std::move(error_);
+            error_ = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    template <class Fn, bool Inline>
+    friend void detail::runTask(detail::Task* task);
+    friend class ThreadPool;
+
+    static constexpr std::uint32_t kSleeping = 0x80000000u;
+
+    void fail(std::exception_ptr error) {
+        std::lock_guard<std::mutex> lock(errorMutex_);
+        if (!error_) error_ = std::move(error);
+    }
+
+    // The last touch of the group by a finished task. After the decrement a
+    // waiter that does not sleep may return and destroy the group; one that
+    // sleeps is woken, and then waits for woken_ before it returns.
+    void finish() {
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == (kSleeping | 1)) {
+            detail::futexWake(pending_, INT_MAX);
+            woken_.store(true, std::memory_order_release);
+        }
+    }
+
+    void waitForAll();
+
+    ThreadPool& pool_;
+    std::atomic<std::uint32_t> pending_{0};  // tasks not finished; kSleeping: a thread waits
+    std::atomic<bool> woken_{false};         // the last task's futexWake() has returned
+    std::mutex errorMutex_;
+    std::exception_ptr error_;
+};
+
+namespace detail {
+
+// Runs the callable stored in a task, then frees the task and, last of all,
+// tells the group.
+template <class Fn, bool Inline>
+void runTask(Task* task) {
+    Fn* fn;
+    if constexpr (Inline)
+        fn = std::launder(reinterpret_cast<Fn*>(task->storage));
+    else
+        std::memcpy(&fn, task->storage, sizeof(fn));
+    TaskGroup* group = task->group;
+    if (group) {
+        try {
+            (*fn)();
+        } catch (...) {
+            group->fail(std::current_exception());
+        }
+    } else {
+        (*fn)();
+    }
+    if constexpr (Inline)
+        fn->~Fn();
+    else
+        delete fn;
+    freeTask(task);
+    if (group) group->finish();
+}
+
+}  // namespace detail
+
+class ThreadPool {
+public:
+    struct Stats {
+        std::uint64_t executed = 0;  // tasks run
+        std::uint64_t stolen = 0;    // of which taken from another worker
+        std::uint64_t parked = 0;    // times a worker went to sleep
+    };
+
+    explicit ThreadPool(std::size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+        threads = std::max<std::size_t>(threads, 1);
+        for (std::size_t i = 0; i < threads; ++i) workers_.push_back(std::make_unique<Worker>(i));
+        for (std::size_t i = 0; i < threads; ++i)
+            workers_[i]->thread = std::thread([this, i] { workerLoop(*workers_[i]); });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        stopping_.store(true, std::memory_order_seq_cst);
+        epoch_.fetch_add(1, std::memory_order_seq_cst);
+        detail::futexWake(epoch_, INT_MAX);
+        for (auto& worker : workers_) worker->thread.join();
+    }
+
+    std::size_t size() const { return workers_.size(); }
+
+    // Runs f() on a worker some time later.
+    template <class F>
+    void submit(F&& f) {
+        schedule(makeTask(std::forward<F>(f), nullptr));
+    }
+
+    // Calls body(i) for every i in [begin, end), in parallel, and returns
+    // when all calls have returned. Rethrows the first exception.
+    template <class F>
+    void parallelFor(std::size_t begin, std::size_t end, F&& body, std::size_t grain = 0) {
+        if (end <= begin) return;
+        if (grain == 0) grain = std::max<std::size_t>(1, (end - begin) / (8 * size()));
+        TaskGroup group(*this);
+        const Range<std::remove_reference_t<F>> range{&body, &group, grain};
+        group.run([&range, begin, end] { range(begin, end); });
+        group.wait();
+    }
+
+    // True on the threads of this pool.
+    bool inWorker() const {
+        Worker* worker = currentWorker();
+        return worker && worker->pool == this;
+    }
+
+    Stats stats() const {
+        Stats total;
+        for (const auto& worker : workers_) {
+            total.executed += worker->executed.load(std::memory_order_relaxed);
+            total.stolen += worker->stolen.load(std::memory_order_relaxed);
+            total.parked += worker->parked.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    friend class TaskGroup;
+
+    struct alignas(64) Worker {
+        explicit Worker(std::size_t i) : index(i), rng(0x9E3779B97F4A7C15ull * (i + 1)) {}
+
+        std::size_t index;
+        ThreadPool* pool = nullptr;
+        detail::WorkStealingDeque deque;
+        detail::TaskAllocator allocator;
+        std::uint64_t rng;
+        std::atomic<std::uint64_t> executed{0}, stolen{0}, parked{0};  // owner writes
+        std::thread thread;
+    };
+
+    // parallelFor: keeps the first half of its range and spawns the second.
+    template <class F>
+    struct Range {
+        F* body;
+        TaskGroup* group;
+        std::size_t grain;
+
+        void operator()(std::size_t begin, std::size_t end) const {
+            while (end - begin > grain) {
+                const std::size_t mid = begin + (end - begin) / 2;
+                const Range* self = this;
+                group->run([self, mid, end] { (*self)(mid, end); });
+                end = mid;
+            }
+            for (std::size_t i = begin; i < end; ++i) (*body)(i);
+        }
+    };
+
+    static constexpr int kSearchRounds = 32;
+
+    static Worker*& currentWorker() {
+        thread_local Worker* worker = nullptr;
+        return worker;
+    }
+
+    Worker* myWorker() const {
+        Worker* worker = currentWorker();
+        return worker && worker->pool == this ? worker : nullptr;
+    }
+
+    template <class F>
+    detail::Task* makeTask(F&& f, TaskGroup* group) {
+        using Fn = std::decay_t<F>;
+        Worker* worker = myWorker();
+        detail::Task* task = worker ? worker->allocator.allocate() : new detail::Task;
+        task->home = worker ? &worker->allocator : nullptr;
+        task->group = group;
+        constexpr bool kInline = sizeof(Fn) <= detail::Task::kInline && alignof(Fn) <= 16 &&
+                                 std::is_nothrow_move_constructible<Fn>::value;
+        if constexpr (kInline) {
+            ::new (static_cast<void*>(task->storage)) Fn(std::forward<F>(f));
+        } else {
+            Fn* fn = new Fn(std::forward<F>(f));
+            std::memcpy(task->storage, &fn, sizeof(fn));
+        }
+        task->run = &detail::runTask<Fn, kInline>;
+        return task;
+    }
+
+    void schedule(detail::Task* task) {
+        if (Worker* worker = myWorker()) {
+            worker->deque.push(task);
+        } else {
+            std::lock_guard<std::mutex> lock(injectMutex_);
+            injected_.push_back(task);
+            injectedCount_.fetch_add(1, std::memory_order_relaxed);
+        }
+        notify();
+    }
+
+    // Wakes one sleeping worker, unless one is already searching: it will
+    // find the new task (see park()).
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_relaxed) == 0 ||
+            searching_.load(std::memory_order_relaxed) != 0)
+            return;
+        epoch_.fetch_add(1, std::memory_order_seq_cst);
+        detail::futexWake(epoch_, 1);
+    }
+
+    detail::Task* takeInjected() {
+        if (injectedCount_.load(std::memory_order_relaxed) == 0) return nullptr;
+        std::lock_guard<std::mutex> lock(injectMutex_);
+        if (injected_.empty()) return nullptr;
+        detail::Task* task = injected_.front();
+        injected_.pop_front();
+        injectedCount_.fetch_sub(1, std::memory_order_relaxed);
+        return task;
+    }
+
+    detail::Task* stealFromOthers(Worker& self) {
+        const std::size_t n = workers_.size();
+        if (n == 1) return nullptr;
+        self.rng ^= self.rng << 13;
+        self.rng ^= self.rng >> 7;
+        self.rng ^= self.rng << 17;
+        const std::size_t start = static_cast<std::size_t>(self.rng % n);
+        for (std::size_t k = 0; k < n; ++k) {
+            Worker& victim = *workers_[(start + k) % n];
+            if (&victim == &self) continue;
+            bool lost = false;
+            if (detail::Task* task = victim.deque.steal(lost)) {
+                self.stolen.store(self.stolen.load(std::memory_order_relaxed) + 1,
+                                  std::memory_order_relaxed);
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    // Looks for work outside the worker's own deque for a while.
+    detail::Task* search(Worker& self) {
+        searching_.fetch_add(1, std::memory_order_seq_cst);
+        detail::Task* task = nullptr;
+        for (int round = 0; round < kSearchRounds && !task; ++round) {
+            task = takeInjected();
+            if (!task) task = stealFromOthers(self);
+            if (!task) {
+                if (round < kSearchRounds / 2)
+                    detail::cpuRelax();
+                else
+                    std::this_thread::yield();
+            }
+        }
+        // The last searcher to find work wakes a replacement: there may be more.
+        if (searching_.fetch_sub(1, std::memory_order_seq_cst) == 1 && task) notify();
+        return task;
+    }
+
+    bool anyWork() const {
+        if (injectedCount_.load(std::memory_order_relaxed) != 0) return true;
+        for (const auto& worker : workers_)
+            if (!worker->deque.looksEmpty()) return true;
+        return false;
+    }
+
+    // Sleeps until notify(). Registering as a sleeper, then checking the
+    // queues, pairs with notify()'s push-then-check: either this thread
+    // sees the task, or the submitter sees the sleeper.
+    void park(Worker& self) {
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::uint32_t epoch = epoch_.load(std::memory_order_seq_cst);
+        if (!anyWork() && !stopping_.load(std::memory_order_seq_cst)) {
+            self.parked.store(self.parked.load(std::memory_order_relaxed) + 1,
+                              std::memory_order_relaxed);
+            detail::futexWait(epoch_, epoch);
+        }
+        sleepers_.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    void execute(Worker& self, detail::Task* task) {
+        task->run(task);
+        self.executed.store(self.executed.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_relaxed);
+    }
+
+    // TaskGroup::wait() on a worker: runs one task if there is one.
+    bool runOne(Worker& self) {
+        detail::Task* task = self.deque.pop();
+        if (!task) task = takeInjected();
+        if (!task) task = stealFromOthers(self);
+        if (!task) return false;
+        execute(self, task);
+        return true;
+    }
+
+    void workerLoop(Worker& self) {
+        self.pool = this;
+        currentWorker() = &self;
+        detail::currentAllocator() = &self.allocator;
+        for (;;) {
+            detail::Task* task = self.deque.pop();
+            if (!task) task = search(self);
+            if (task) {
+                execute(self, task);
+                continue;
+            }
+            if (stopping_.load(std::memory_order_seq_cst)) {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!anyWork()) break;
+                continue;
+            }
+            park(self);
+        }
+        currentWorker() = nullptr;
+        detail::currentAllocator() = nullptr;
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    std::mutex injectMutex_;                          // submissions from outside the pool
+    std::deque<detail::Task*> injected_;
+    alignas(64) std::atomic<std::size_t> injectedCount_{0};
+
+    alignas(64) std::atomic<int> searching_{0};       // workers in search()
+    std::atomic<int> sleepers_{0};                    // workers in park()
+    std::atomic<std::uint32_t> epoch_{0};             // futex word of park()
+    std::atomic<bool> stopping_{false};
+};
+
+template <class F>
+void TaskGroup::run(F&& f) {
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    pool_.schedule(pool_.makeTask(std::forward<F>(f), this));
+}
+
+inline void TaskGroup::waitForAll() {
+    if (ThreadPool::Worker* worker = pool_.myWorker()) {
+        // Help: run tasks (ours or others') while there are any. When there
+        // are none for a while, the group's last tasks are running on other
+        // workers: sleep below instead of spinning.
+        int idle = 0;
+        while ((pending_.load(std::memory_order_acquire) & ~kSleeping) != 0) {
+            if (pool_.runOne(*worker)) {
+                idle = 0;
+            } else if (++idle < 64) {
+                detail::cpuRelax();
+            } else if (idle < 512) {
+                std::this_thread::yield();
+            } else {
+                break;
+            }
+        }
+    }
+    // Sleep on the counter until the last task finishes.
+    std::uint32_t value;
+    for (;;) {
+        value = pending_.load(std::memory_order_acquire);
+        if ((value & ~kSleeping) == 0) break;
+        if (!(value & kSleeping) &&
+            !pending_.compare_exchange_weak(value, value | kSleeping, std::memory_order_acquire))
+            continue;
+        detail::futexWait(pending_, value | kSleeping);
+    }
+    // kSleeping was set, so the last task calls futexWake() after its
+    // decrement; the group must outlive that call. The wake-up may have
+    // preempted that task on this core: yield, do not spin.
+    if (value & kSleeping)
+        while (!woken_.load(std::memory_order_acquire)) std::this_thread::yield();
+    woken_.store(false, std::memory_order_relaxed);
+    pending_.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace tasks
+
+#endif  // THREAD_POOL_H
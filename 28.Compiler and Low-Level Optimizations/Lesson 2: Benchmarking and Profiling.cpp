@@ -5,36 +5,99 @@ Theory:
 ---------
 Measuring performance is essential to optimization. Tools and techniques include:
 - High-resolution timers (std::chrono)
-- Profiling tools (e.g., Valgrind, gprof, Visual Studio Profiler)
+- Profiling tools (e.g., Valgrind, gprof, perf, Visual Studio Profiler)
 - Micro-benchmarking specific code segments
 
+A single timed run is not a measurement, it is an anecdote:
+- The first run pays for cold caches, page faults and CPU frequency ramp-up.
+- One number hides the noise of the machine.
+- `volatile` keeps the optimizer away, but it also forces a memory store on
+  every iteration, so you end up timing the store instead of your code.
+
 Key Points:
-- Use std::chrono to measure time in your code.
-- Benchmark critical sections to find bottlenecks.
-- Edge Cases: Ensure your benchmarks run multiple iterations to account for
-variability.
+- Use std::chrono::steady_clock (monotonic) for intervals.
+- Warm up, calibrate the iteration count, and take many samples
+  (see benchmark.h in this folder).
+- Report min / median / p99 / stddev, not a single value.
+- Use DoNotOptimize / ClobberMemory barriers instead of `volatile`.
+- Edge Cases: at -O2 the compiler can turn a summation loop into a closed
+  formula; the barrier on the *input* (n) prevents constant folding.
 
 Example:
 ---------
-Measuring the execution time of a simple loop.
+The original sum loop, shortened from 100M to N = 1M iterations so that
+each sample is a millisecond or less and the harness can take many of them,
+measured three ways:
+1. with `volatile` (what the first version of this lesson did),
+2. with DoNotOptimize on the result only,
+3. a memory-bound variant over a vector, reporting throughput.
+
+Compile & run:
+    g++ -std=c++17 -O2 "Lesson 2: Benchmarking and Profiling.cpp" -o bench
+    ./bench
+    ./bench --bench-format=json --bench-out=O2.json
+    ./bench --bench-format=csv --bench-filter=sum
 ========================================================================== */
 
-#include <chrono>
-#include <iostream>
+#include <numeric>
+#include <vector>
+
+#include "benchmark.h"
 using namespace std;
-using namespace std::chrono;
 
-int main() {
-    auto start = high_resolution_clock::now();
+const long long N = 1000000;
+
+// 1. The old trick: every `sum += i` becomes a load + store to memory.
+void sumVolatile(bench::State& state) {
+    for (auto _ : state) {
+        volatile long long sum = 0;
+        for (long long i = 0; i < N; ++i) {
+            sum += i;
+        }
+    }
+}
+
+// 2. Barriers: hide `n` from the optimizer so it cannot fold the loop into a
+//    constant, and mark the result as used so it is not deleted.
+void sumDoNotOptimize(bench::State& state) {
+    long long n = N;
+    for (auto _ : state) {
+        bench::DoNotOptimize(n);
+        long long sum = 0;
+        for (long long i = 0; i < n; ++i) {
+            sum += i;
+        }
+        bench::DoNotOptimize(sum);
+    }
+}
 
-    volatile long long sum = 0;
-    for (long long i = 0; i < 100000000LL; ++i) { // LL suffix for long long
-        sum += i;
+// 3. Memory-bound: summing a vector, with throughput reported in GB/s.
+void sumVector(bench::State& state) {
+    vector<long long> data(N);
+    iota(data.begin(), data.end(), 0);
+    for (auto _ : state) {
+        long long sum = accumulate(data.begin(), data.end(), 0LL);
+        bench::DoNotOptimize(sum);
+        bench::ClobberMemory();
     }
+    state.setBytesProcessed(N * sizeof(long long));
+}
+
+int main(int argc, char** argv) {
+    bench::registerCase("sum_loop/volatile", sumVolatile);
+    bench::registerCase("sum_loop/do_not_optimize", sumDoNotOptimize);
+    bench::registerCase("sum_vector/accumulate", sumVector);
+    return bench::runAll(argc, argv);
+}
 
-    auto end = high_resolution_clock::now();
-    auto duration = duration_cast<milliseconds>(end - start);
+/*
+What to expect (-O2, x86-64):
+- sum_loop/volatile is typically 2x or more slower than sum_loop/do_not_optimize:
+  it measures a store to memory on every iteration, not the addition.
+- sum_vector/accumulate is bound by memory bandwidth; its GB/s figure is more
+  meaningful than its time.
+- A large gap between min and p99 means the machine is noisy; re-run before
+  drawing conclusions.
 
-    cout << "Loop took " << duration.count() << " milliseconds.\n";
-    return 0;
-}
\ No newline at end of file
+Compare runs built with -O0, -O2 and -O3 by saving JSON or CSV and diffing them.
+*/
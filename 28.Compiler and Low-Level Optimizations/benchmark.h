@@ -0,0 +1,501 @@
+/* ==========================================================================
+benchmark.h - A Small Statistical Micro-Benchmark Harness
+
+Theory:
+---------
+Timing a loop once and printing milliseconds tells you almost nothing:
+- The first run pays for page faults, cold caches and CPU frequency ramp-up.
+- A single number hides the noise (interrupts, other processes, turbo).
+- The optimizer may delete the code you are trying to measure.
+
+A useful harness therefore:
+1. Warms up the code before measuring.
+2. Calibrates the iteration count so that one sample lasts long enough for the
+   clock resolution to be irrelevant (a few milliseconds).
+3. Takes many samples and reports the distribution: min, median, p99, stddev.
+4. Uses compiler barriers (DoNotOptimize / ClobberMemory) instead of
+   `volatile`, which changes the code being measured.
+
+Key Points:
+- Header-only: every lesson can `#include` it and register its own cases.
+- `min` is the best estimate of the true cost, `median` of typical cost,
+  `p99` and `stddev` tell you how noisy the machine is.
+- Output can be printed as a table, JSON or CSV so runs built with different
+  compiler flags can be diffed.
+- Edge Cases: DoNotOptimize uses GCC/Clang inline asm; other compilers fall
+  back to a volatile store.
+
+Usage:
+---------
+    #include "benchmark.h"
+
+    static void sumLoop(bench::State& state) {
+        for (auto _ : state) {
+            long long sum = 0;
+            for (long long i = 0; i < 1000; ++i) sum += i;
+            bench::DoNotOptimize(sum);
+        }
+    }
+
+    int main(int argc, char** argv) {
+        bench::registerCase("sum_loop", sumLoop);
+        return bench::runAll(argc, argv);
+    }
+
+Command line flags understood by runAll():
+    --bench-filter=<substring>   only run cases whose name contains it
+    --bench-format=console|json|csv
+    --bench-out=<file>           write the report to a file instead of stdout
+    --bench-samples=<N>          samples per case (default 30)
+    --bench-min-time-ms=<ms>     target duration of one sample (default 10)
+    --bench-warmup-ms=<ms>       warmup duration per case (default 50)
+
+Requires C++17.
+========================================================================== */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+// --------------------------------------------------------------------------
+// Optimization barriers
+// --------------------------------------------------------------------------
+
+// Forces the compiler to assume `value` is read (and possibly modified), so the
+// computation that produced it cannot be removed. Unlike `volatile`, it does
+// not force every intermediate store to go to memory.
+template <typename T>
+inline void DoNotOptimize(T const& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+template <typename T>
+inline void DoNotOptimize(T& value) {
+#if defined(__clang__)
+    asm volatile("" : "+r,m"(value) : : "memory");
+#elif defined(__GNUC__)
+    asm volatile("" : "+m,r"(value) : : "memory");
+#else
+    static volatile void* sink;
+    sink = &value;
+#endif
+}
+
+// Forces all pending writes to memory to be considered observable.
+inline void ClobberMemory() {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#endif
+}
+
+using Clock = std::chrono::steady_clock;
+
+// --------------------------------------------------------------------------
+// State: passed to each benchmark case, drives the measured loop
+// --------------------------------------------------------------------------
+
+class State {
+public:
+    explicit State(std::uint64_t iterations) : iterations_(iterations) {}
+
+    // Range-for support: `for (auto _ : state)` runs the body iterations() times
+    // and the time between begin() and the loop exit is what gets recorded.
+    // Value is marked unused so the loop variable does not trigger warnings.
+    struct
+#if defined(__GNUC__) || defined(__clang__)
+        __attribute__((unused))
+#endif
+        Value {};
+
+    struct Iterator {
+        State* state;
+        std::uint64_t remaining;
+
+        bool operator!=(const Iterator&) {
+            if (remaining != 0) return true;
+            state->stopTimer();
+            return false;
+        }
+        void operator++() { --remaining; }
+        Value operator*() const { return {}; }
+    };
+
+    Iterator begin() {
+        startTimer();
+        return Iterator{this, iterations_};
+    }
+    Iterator end() { return Iterator{this, 0}; }
+
+    std::uint64_t iterations() const { return iterations_; }
+
+    // Stops the timer if a case left it running (e.g. returned from inside
+    // the loop); called by the harness after every run.
+    void finish() { stopTimer(); }
+
+    // Exclude setup work inside the loop from the measurement.
+    void pauseTiming() { stopTimer(); }
+    void resumeTiming() { startTimer(); }
+
+    // Throughput reporting: bytes or items handled per iteration.
+    void setBytesProcessed(std::uint64_t bytes) { bytesProcessed_ = bytes; }
+    void setItemsProcessed(std::uint64_t items) { itemsProcessed_ = items; }
+
+    // Arbitrary per-sample counters (e.g. cache misses); averaged over samples.
+    void setCounter(const std::string& name, double value) { counters_[name] = value; }
+
+    double elapsedNs() const { return elapsedNs_; }
+    std::uint64_t bytesProcessed() const { return bytesProcessed_; }
+    std::uint64_t itemsProcessed() const { return itemsProcessed_; }
+    const std::map<std::string, double>& counters() const { return counters_; }
+
+    // Hooks that run right before/after the timed region (used by extensions
+    // such as hardware counters). They are not part of the measured time.
+    std::function<void()> onStart;
+    std::function<void()> onStop;
+
+private:
+    void startTimer() {
+        if (running_) return;
+        if (onStart) onStart();
+        running_ = true;
+        start_ = Clock::now();
+    }
+    void stopTimer() {
+        if (!running_) return;
+        auto stop = Clock::now();
+        running_ = false;
+        elapsedNs_ += std::chrono::duration<double, std::nano>(stop - start_).count();
+        if (onStop) onStop();
+    }
+
+    std::uint64_t iterations_;
+    bool running_ = false;
+    Clock::time_point start_;
+    double elapsedNs_ = 0.0;
+    std::uint64_t bytesProcessed_ = 0;
+    std::uint64_t itemsProcessed_ = 0;
+    std::map<std::string, double> counters_;
+};
+
+using Function = std::function<void(State&)>;
+
+// --------------------------------------------------------------------------
+// Options and results
+// --------------------------------------------------------------------------
+
+struct Options {
+    std::string filter;
+    std::string format = "console";
+    std::string outFile;
+    int samples = 30;
+    double minSampleMs = 10.0;
+    double warmupMs = 50.0;
+};
+
+struct Result {
+    std::string name;
+    std::uint64_t iterations = 0;  // iterations per sample (after calibration)
+    int samples = 0;
+    double minNs = 0, medianNs = 0, p99Ns = 0, meanNs = 0, stddevNs = 0;  // per iteration
+    double bytesPerSecond = 0;
+    double itemsPerSecond = 0;
+    std::map<std::string, double> counters;
+};
+
+// A hook that wraps every State before it is run. Extensions (e.g. perf
+// counters) install one to attach onStart/onStop callbacks and counters.
+using StateHook = std::function<void(State&)>;
+
+struct Case {
+    std::string name;
+    Function fn;
+};
+
+inline std::vector<Case>& registry() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+inline std::vector<StateHook>& stateHooks() {
+    static std::vector<StateHook> hooks;
+    return hooks;
+}
+
+inline void registerCase(const std::string& name, Function fn) {
+    registry().push_back({name, std::move(fn)});
+}
+
+inline void addStateHook(StateHook hook) { stateHooks().push_back(std::move(hook)); }
+
+// --------------------------------------------------------------------------
+// Statistics
+// --------------------------------------------------------------------------
+
+// Linear-interpolated percentile of an already sorted vector, q in [0, 1].
+inline double percentile(const std::vector<double>& sorted, double q) {
+    if (sorted.empty()) return 0.0;
+    double pos = q * static_cast<double>(sorted.size() - 1);
+    std::size_t lo = static_cast<std::size_t>(pos);
+    std::size_t hi = std::min(lo + 1, sorted.size() - 1);
+    double frac = pos - static_cast<double>(lo);
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * frac;
+}
+
+inline void summarize(std::vector<double> perIterNs, Result& r) {
+    std::sort(perIterNs.begin(), perIterNs.end());
+    r.samples = static_cast<int>(perIterNs.size());
+    r.minNs = perIterNs.front();
+    r.medianNs = percentile(perIterNs, 0.5);
+    r.p99Ns = percentile(perIterNs, 0.99);
+
+    double sum = 0.0;
+    for (double v : perIterNs) sum += v;
+    r.meanNs = sum / perIterNs.size();
+
+    double sq = 0.0;
+    for (double v : perIterNs) sq += (v - r.meanNs) * (v - r.meanNs);
+    r.stddevNs = perIterNs.size() > 1 ? std::sqrt(sq / (perIterNs.size() - 1)) : 0.0;
+}
+
+// --------------------------------------------------------------------------
+// Running one case
+// --------------------------------------------------------------------------
+
+inline State runOnce(const Function& fn, std::uint64_t iterations, bool withHooks) {
+    State state(iterations);
+    if (withHooks) {
+        for (auto& hook : stateHooks()) hook(state);
+    }
+    fn(state);
+    state.finish();
+    return state;
+}
+
+inline Result runCase(const Case& c, const Options& opt) {
+    Result r;
+    r.name = c.name;
+
+    // 1. Warmup: run the body until warmupMs has elapsed (caches, branch
+    //    predictors and CPU frequency settle).
+    auto warmupEnd = Clock::now() + std::chrono::duration<double, std::milli>(opt.warmupMs);
+    std::uint64_t iters = 1;
+    while (Clock::now() < warmupEnd) {
+        runOnce(c.fn, iters, false);
+        if (iters < (1ull << 20)) iters *= 2;
+    }
+
+    // 2. Calibrate: grow the iteration count until one sample takes minSampleMs.
+    const double targetNs = opt.minSampleMs * 1e6;
+    iters = 1;
+    for (;;) {
+        double ns = runOnce(c.fn, iters, false).elapsedNs();
+        if (ns >= targetNs || iters >= (1ull << 40)) break;
+        // Jump straight towards the target, but never grow more than 10x at once.
+        double factor = ns > 0 ? (targetNs * 1.2) / ns : 10.0;
+        factor = std::min(10.0, std::max(2.0, factor));
+        iters = static_cast<std::uint64_t>(iters * factor);
+    }
+    r.iterations = iters;
+
+    // 3. Sample repeatedly with the calibrated count.
+    std::vector<double> perIter;
+    perIter.reserve(opt.samples);
+    std::map<std::string, double> counterSums;
+    double bytes = 0, items = 0;
+    for (int s = 0; s < opt.samples; ++s) {
+        State st = runOnce(c.fn, iters, true);
+        double ns = st.elapsedNs() / static_cast<double>(iters);
+        perIter.push_back(ns);
+        bytes += static_cast<double>(st.bytesProcessed());
+        items += static_cast<double>(st.itemsProcessed());
+        for (const auto& kv : st.counters()) counterSums[kv.first] += kv.second;
+    }
+    summarize(perIter, r);
+
+    for (const auto& kv : counterSums) r.counters[kv.first] = kv.second / opt.samples;
+    // bytes/items are reported per iteration by the case, use median time.
+    if (bytes > 0) r.bytesPerSecond = (bytes / opt.samples) / (r.medianNs * 1e-9);
+    if (items > 0) r.itemsPerSecond = (items / opt.samples) / (r.medianNs * 1e-9);
+    return r;
+}
+
+// --------------------------------------------------------------------------
+// Reporting
+// --------------------------------------------------------------------------
+
+inline std::string formatNs(double ns) {
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(2);
+    if (ns < 1e3) os << ns << " ns";
+    else if (ns < 1e6) os << ns / 1e3 << " us";
+    else if (ns < 1e9) os << ns / 1e6 << " ms";
+    else os << ns / 1e9 << " s";
+    return os.str();
+}
+
+inline std::string jsonEscape(const std::string& s) {
+    std::string out;
+    for (char ch : s) {
+        if (ch == '"' || ch == '\\') out += '\\';
+        out += ch;
+    }
+    return out;
+}
+
+inline std::string csvEscape(const std::string& s) {
+    if (s.find_first_of(",\"") == std::string::npos) return s;
+    std::string out = "\"";
+    for (char ch : s) {
+        if (ch == '"') out += '"';
+        out += ch;
+    }
+    return out + "\"";
+}
+
+inline void reportConsole(std::ostream& os, const std::vector<Result>& results) {
+    os << std::left << std::setw(36) << "Benchmark" << std::right << std::setw(12)
+       << "min" << std::setw(12) << "median" << std::setw(12) << "p99" << std::setw(12)
+       << "stddev" << std::setw(14) << "iterations" << '\n';
+    os << std::string(98, '-') << '\n';
+    for (const auto& r : results) {
+        os << std::left << std::setw(36) << r.name << std::right << std::setw(12)
+           << formatNs(r.minNs) << std::setw(12) << formatNs(r.medianNs) << std::setw(12)
+           << formatNs(r.p99Ns) << std::setw(12) << formatNs(r.stddevNs) << std::setw(14)
+           << r.iterations << '\n';
+        if (r.bytesPerSecond > 0)
+            os << "    throughput: " << std::fixed << std::setprecision(3)
+               << r.bytesPerSecond / 1e9 << " GB/s\n";
+        if (r.itemsPerSecond > 0)
+            os << "    throughput: " << std::fixed << std::setprecision(3)
+               << r.itemsPerSecond / 1e6 << " M items/s\n";
+        for (const auto& kv : r.counters)
+            os << "    " << kv.first << ": " << std::fixed << std::setprecision(3)
+               << kv.second << '\n';
+        os.unsetf(std::ios::fixed);
+    }
+}
+
+inline void reportJson(std::ostream& os, const std::vector<Result>& results) {
+    os << "{\n  \"benchmarks\": [\n";
+    os << std::setprecision(6);
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        os << "    {\"name\": \"" << jsonEscape(r.name) << "\", \"iterations\": "
+           << r.iterations << ", \"samples\": " << r.samples << ", \"min_ns\": " << r.minNs
+           << ", \"median_ns\": " << r.medianNs << ", \"p99_ns\": " << r.p99Ns
+           << ", \"mean_ns\": " << r.meanNs << ", \"stddev_ns\": " << r.stddevNs
+           << ", \"bytes_per_second\": " << r.bytesPerSecond
+           << ", \"items_per_second\": " << r.itemsPerSecond << ", \"counters\": {";
+        bool first = true;
+        for (const auto& kv : r.counters) {
+            os << (first ? "" : ", ") << '"' << jsonEscape(kv.first) << "\": " << kv.second;
+            first = false;
+        }
+        os << "}}" << (i + 1 < results.size() ? "," : "") << '\n';
+    }
+    os << "  ]\n}\n";
+}
+
+// One column per counter name seen in any result; empty where a result
+// has no such counter.
+inline void reportCsv(std::ostream& os, const std::vector<Result>& results) {
+    std::set<std::string> counterNames;
+    for (const auto& r : results)
+        for (const auto& kv : r.counters) counterNames.insert(kv.first);
+    os << "name,iterations,samples,min_ns,median_ns,p99_ns,mean_ns,stddev_ns,"
+          "bytes_per_second,items_per_second";
+    for (const auto& name : counterNames) os << ',' << csvEscape(name);
+    os << '\n';
+    os << std::setprecision(6);
+    for (const auto& r : results) {
+        os << csvEscape(r.name) << ',' << r.iterations << ',' << r.samples << ','
+           << r.minNs << ',' << r.medianNs << ',' << r.p99Ns << ',' << r.meanNs << ','
+           << r.stddevNs << ',' << r.bytesPerSecond << ',' << r.itemsPerSecond;
+        for (const auto& name : counterNames) {
+            os << ',';
+            auto it = r.counters.find(name);
+            if (it != r.counters.end()) os << it->second;
+        }
+        os << '\n';
+    }
+}
+
+inline void report(std::ostream& os, const std::vector<Result>& results,
+                   const std::string& format) {
+    if (format == "json") reportJson(os, results);
+    else if (format == "csv") reportCsv(os, results);
+    else reportConsole(os, results);
+}
+
+// --------------------------------------------------------------------------
+// Entry point
+// --------------------------------------------------------------------------
+
+// Parses --bench-* flags; unknown arguments are left for the program.
+inline Options parseOptions(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&](const std::string& key) -> const char* {
+            return arg.rfind(key, 0) == 0 ? argv[i] + key.size() : nullptr;
+        };
+        if (auto v = value("--bench-filter=")) opt.filter = v;
+        else if (auto v = value("--bench-format=")) opt.format = v;
+        else if (auto v = value("--bench-out=")) opt.outFile = v;
+        else if (auto v = value("--bench-samples=")) opt.samples = std::max(1, std::atoi(v));
+        else if (auto v = value("--bench-min-time-ms=")) opt.minSampleMs = std::atof(v);
+        else if (auto v = value("--bench-warmup-ms=")) opt.warmupMs = std::atof(v);
+    }
+    return opt;
+}
+
+inline std::vector<Result> runAll(const Options& opt) {
+    std::vector<Result> results;
+    for (const auto& c : registry()) {
+        if (!opt.filter.empty() && c.name.find(opt.filter) == std::string::npos) continue;
+        results.push_back(runCase(c, opt));
+    }
+    return results;
+}
+
+inline int runAll(int argc, char** argv) {
+    Options opt = parseOptions(argc, argv);
+    std::vector<Result> results = runAll(opt);
+    if (opt.outFile.empty()) {
+        report(std::cout, results, opt.format);
+    } else {
+        std::ofstream out(opt.outFile);
+        if (!out) {
+            std::cerr << "bench: cannot open " << opt.outFile << '\n';
+            return 1;
+        }
+        report(out, results, opt.format);
+    }
+    return 0;
+}
+
+}  // namespace bench
+
+#endif  // BENCHMARK_H
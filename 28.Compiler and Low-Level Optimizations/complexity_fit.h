@@ -0,0 +1,295 @@
+/* ==========================================================================
+complexity_fit.h - Empirical Big-O: Sweep Input Sizes and Fit Growth Models
+
+Theory:
+---------
+Big-O classes are usually stated in comments and never checked. An
+accidental copy inside a loop can turn an O(n) function into O(n^2), and a
+benchmark at one input size will not notice. Measuring the same function at
+geometrically growing sizes (16, 64, 256, ...) and fitting the timings to
+candidate growth models does notice:
+
+    t(n) ~= a + c * g(n),   g in {1, log n, n, n log n, n^2, n^3, 2^n, n!}
+
+Each model is fitted by weighted least squares on the *relative* error (a
+1 us error matters at n = 16, not at n = 1e6), and the model with the
+smallest root-mean-square relative error wins. Two extra fits help reading
+the result:
+- b^n with a fitted base b (recursive Fibonacci gives b ~= 1.618),
+- a power law c * n^k with a fitted exponent k (k ~= 1 for O(n),
+  k ~= 1.1 for O(n log n) over a few decades, k ~= 2 for O(n^2)).
+
+Once two algorithms that solve the same problem are fitted, the crossover
+point where one becomes faster than the other is found by bisection.
+
+Key Points:
+- Uses benchmark.h for each point (warmup, calibration, median of samples).
+- Output as a table or CSV. Series::expected turns a wrong class into a
+  failure, so a sweep can run in CI to catch complexity regressions.
+- Edge Cases: cache effects bend curves (an O(n) scan gets slower per element
+  once the data leaves L2), so sweep over at least 3 decades and read the
+  fitted exponent together with the class.
+========================================================================== */
+
+#ifndef COMPLEXITY_FIT_H
+#define COMPLEXITY_FIT_H
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+
+namespace bigo {
+
+struct Point {
+    double n;
+    double ns;  // median time of one call
+};
+
+// A fitted model: t(n) = a + c * g(n), or exp(a + c * n) for the free-base
+// exponential (then `base` = e^c).
+struct Fit {
+    std::string model;
+    double a = 0.0;
+    double c = 0.0;
+    double base = 0.0;
+    double rmsRelError = std::numeric_limits<double>::infinity();
+    std::function<double(double)> g;
+
+    double operator()(double n) const {
+        if (base > 0.0) return std::exp(a + c * n);
+        return a + c * g(n);
+    }
+};
+
+struct Model {
+    std::string name;
+    std::function<double(double)> g;
+};
+
+inline std::vector<Model> standardModels() {
+    return {
+        {"O(1)", [](double) { return 1.0; }},
+        {"O(log n)", [](double n) { return std::log2(std::max(n, 2.0)); }},
+        {"O(n)", [](double n) { return n; }},
+        {"O(n log n)", [](double n) { return n * std::log2(std::max(n, 2.0)); }},
+        {"O(n^2)", [](double n) { return n * n; }},
+        {"O(n^3)", [](double n) { return n * n * n; }},
+        {"O(2^n)", [](double n) { return std::exp2(n); }},
+        {"O(n!)", [](double n) { return std::exp(std::lgamma(n + 1.0)); }},
+    };
+}
+
+inline double rmsRelative(const std::vector<Point>& pts, const Fit& f) {
+    double sum = 0.0;
+    for (const Point& p : pts) {
+        double r = f(p.n) / p.ns - 1.0;
+        sum += r * r;
+    }
+    return std::sqrt(sum / pts.size());
+}
+
+// Weighted least squares of t = a + c * g(n) with weights 1/t^2, keeping
+// a >= 0 and c >= 0.
+inline Fit fitModel(const std::vector<Point>& pts, const Model& m) {
+    Fit f;
+    f.model = m.name;
+    f.g = m.g;
+    double sw = 0, sg = 0, sgg = 0, st = 0, sgt = 0;
+    for (const Point& p : pts) {
+        double g = m.g(p.n);
+        if (!std::isfinite(g)) return f;  // model does not apply at this n
+        double w = 1.0 / (p.ns * p.ns);
+        sw += w;
+        sg += w * g;
+        sgg += w * g * g;
+        st += w * p.ns;
+        sgt += w * g * p.ns;
+    }
+    double det = sw * sgg - sg * sg;
+    if (std::fabs(det) > 1e-300 * sw * sgg) {
+        f.a = (st * sgg - sg * sgt) / det;
+        f.c = (sw * sgt - sg * st) / det;
+    }
+    if (f.a < 0.0 || !std::isfinite(f.a)) {
+        f.a = 0.0;
+        f.c = sgt / sgg;
+    }
+    if (f.c < 0.0 || !std::isfinite(f.c)) {
+        f.c = 0.0;
+        f.a = st / sw;
+    }
+    f.rmsRelError = rmsRelative(pts, f);
+    return f;
+}
+
+// log t = a + c * n  ->  t = e^a * (e^c)^n
+inline Fit fitExponential(const std::vector<Point>& pts) {
+    Fit f;
+    double k = static_cast<double>(pts.size());
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (const Point& p : pts) {
+        double y = std::log(p.ns);
+        sx += p.n;
+        sy += y;
+        sxx += p.n * p.n;
+        sxy += p.n * y;
+    }
+    double det = k * sxx - sx * sx;
+    if (det <= 0.0) return f;
+    f.c = (k * sxy - sx * sy) / det;
+    f.a = (sy - f.c * sx) / k;
+    f.base = std::exp(f.c);
+    if (f.base <= 1.0) return Fit();
+    std::ostringstream name;
+    name << "O(" << std::setprecision(3) << f.base << "^n)";
+    f.model = name.str();
+    f.rmsRelError = rmsRelative(pts, f);
+    return f;
+}
+
+// Slope of log t against log n.
+inline double powerLawExponent(const std::vector<Point>& pts) {
+    double k = static_cast<double>(pts.size());
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (const Point& p : pts) {
+        double x = std::log(p.n), y = std::log(p.ns);
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+    double det = k * sxx - sx * sx;
+    return det > 0.0 ? (k * sxy - sx * sy) / det : 0.0;
+}
+
+// One algorithm measured at several sizes.
+struct Series {
+    std::string name;
+    std::string group;                  // series in one group solve the same problem
+    std::vector<std::string> expected;  // acceptable classes (empty = no check)
+    std::vector<Point> points;
+    std::vector<Fit> fits;              // best first
+    double exponent = 0.0;
+
+    const Fit& best() const { return fits.front(); }
+    bool asExpected() const {
+        if (expected.empty()) return true;
+        const std::string& m = best().model;
+        for (const std::string& e : expected) {
+            if (m == e) return true;
+            if (e == "O(b^n)" && best().base > 0.0) return true;
+        }
+        return false;
+    }
+};
+
+// Runs `body(state, n)` through benchmark.h for each size and fits the
+// standard models to the median times.
+inline Series sweep(const std::string& name, const std::string& group,
+                    const std::vector<long long>& sizes,
+                    const std::function<void(bench::State&, long long)>& body,
+                    const bench::Options& options, std::vector<std::string> expected = {}) {
+    Series s;
+    s.name = name;
+    s.group = group;
+    s.expected = std::move(expected);
+    for (long long n : sizes) {
+        bench::Case c{name + "/" + std::to_string(n),
+                      [&body, n](bench::State& state) { body(state, n); }};
+        bench::Result r = bench::runCase(c, options);
+        s.points.push_back({static_cast<double>(n), std::max(r.medianNs, 1e-3)});
+    }
+    for (const Model& m : standardModels()) s.fits.push_back(fitModel(s.points, m));
+    Fit e = fitExponential(s.points);
+    if (!e.model.empty()) s.fits.push_back(e);
+    std::sort(s.fits.begin(), s.fits.end(),
+              [](const Fit& x, const Fit& y) { return x.rmsRelError < y.rmsRelError; });
+    s.exponent = powerLawExponent(s.points);
+    return s;
+}
+
+// Smallest n in [lo, hi] where the fitted curves of x and y cross, or NaN.
+inline double crossover(const Fit& x, const Fit& y, double lo = 1.0, double hi = 1e12) {
+    auto diff = [&](double n) { return std::log(x(n)) - std::log(y(n)); };
+    double prev = lo, dPrev = diff(lo);
+    for (double n = lo * 1.1; n <= hi; n *= 1.1) {
+        double d = diff(n);
+        if (std::isfinite(d) && std::isfinite(dPrev) && (d > 0) != (dPrev > 0)) {
+            double a = prev, b = n;
+            for (int i = 0; i < 60; ++i) {
+                double m = 0.5 * (a + b);
+                if ((diff(m) > 0) == (dPrev > 0)) a = m;
+                else b = m;
+            }
+            return 0.5 * (a + b);
+        }
+        prev = n;
+        dPrev = d;
+    }
+    return std::numeric_limits<double>::quiet_NaN();
+}
+
+inline void reportTable(std::ostream& os, const std::vector<Series>& all) {
+    os << std::left << std::setw(24) << "Algorithm" << std::setw(14) << "Best fit"
+       << std::right << std::setw(14) << "c (ns)" << std::setw(12) << "a (ns)"
+       << std::setw(10) << "rms err" << std::setw(10) << "n^k: k" << "  runner-up\n";
+    os << std::string(100, '-') << '\n';
+    for (const Series& s : all) {
+        const Fit& f = s.best();
+        os << std::left << std::setw(24) << s.name << std::setw(14) << f.model << std::right
+           << std::setw(14) << std::setprecision(4) << (f.base > 0 ? std::exp(f.a) : f.c)
+           << std::setw(12) << (f.base > 0 ? 0.0 : f.a) << std::setw(9) << std::setprecision(3)
+           << f.rmsRelError * 100 << '%' << std::setw(10) << std::setprecision(3) << s.exponent
+           << "  " << (s.fits.size() > 1 ? s.fits[1].model : "") << "\n";
+        if (!s.asExpected()) {
+            os << "    ^ UNEXPECTED: expected";
+            for (const std::string& e : s.expected) os << ' ' << e;
+            os << '\n';
+        }
+    }
+
+    os << "\nCrossover points (from the fitted curves):\n";
+    for (std::size_t i = 0; i < all.size(); ++i) {
+        for (std::size_t j = i + 1; j < all.size(); ++j) {
+            if (all[i].group != all[j].group) continue;
+            const Fit& x = all[i].best();
+            const Fit& y = all[j].best();
+            double n = crossover(x, y);
+            double measuredLo = std::max(all[i].points.front().n, all[j].points.front().n);
+            double measuredHi = std::min(all[i].points.back().n, all[j].points.back().n);
+            bool extrapolated = n < measuredLo || n > measuredHi;
+            const std::string& fasterSmall = x(1.0) < y(1.0) ? all[i].name : all[j].name;
+            const std::string& other = fasterSmall == all[i].name ? all[j].name : all[i].name;
+            os << "  " << all[i].name << " vs " << all[j].name << ": ";
+            if (std::isnan(n))
+                os << fasterSmall << " is faster for every n\n";
+            else
+                os << fasterSmall << " is faster below n ~= " << std::setprecision(3) << n
+                   << ", " << other << " above" << (extrapolated ? " (extrapolated)" : "")
+                   << '\n';
+        }
+    }
+}
+
+inline void reportCsv(std::ostream& os, const std::vector<Series>& all) {
+    os << "algorithm,n,median_ns\n";
+    for (const Series& s : all)
+        for (const Point& p : s.points) os << s.name << ',' << p.n << ',' << p.ns << '\n';
+    os << "\nalgorithm,model,a,c,base,rms_rel_error,best\n";
+    for (const Series& s : all)
+        for (const Fit& f : s.fits)
+            os << s.name << ',' << f.model << ',' << f.a << ',' << f.c << ',' << f.base << ','
+               << f.rmsRelError << ',' << (&f == &s.best() ? 1 : 0) << '\n';
+}
+
+}  // namespace bigo
+
+#endif  // COMPLEXITY_FIT_H
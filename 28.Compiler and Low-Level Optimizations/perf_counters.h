@@ -0,0 +1,243 @@
+/* ==========================================================================
+perf_counters.h - Hardware Performance Counters (Linux perf_event_open)
+
+Theory:
+---------
+Wall-clock time tells you *that* code is slow, hardware counters tell you
+*why*. Every modern CPU has a Performance Monitoring Unit (PMU) that counts
+events such as:
+- cycles / instructions        -> IPC (instructions per cycle)
+- L1 data cache read misses    -> poor spatial locality, padding waste
+- last-level cache (LLC) misses-> working set larger than the cache
+- branch misses                -> unpredictable control flow
+- dTLB misses                  -> access pattern jumps across many pages
+
+On Linux these are exposed by the `perf_event_open` system call. Each counter
+is a file descriptor; it can be reset, enabled and disabled with ioctl() and
+read() returns the count.
+
+Key Points:
+- perf::Counters opens every event independently: if one is not supported
+  (virtual machine, container, perf_event_paranoid too high), the others still
+  work and the missing one is simply reported as unavailable.
+- When more events are requested than the PMU has registers, the kernel
+  multiplexes them; the value is scaled by time_enabled / time_running.
+- perf::Region is an RAII guard that measures any block of code.
+- perf::attachToBenchmarks() plugs the counters into benchmark.h so every
+  sample reports counters per iteration.
+- Edge Cases: on non-Linux systems everything compiles but reports
+  "unavailable". If nothing opens, check /proc/sys/kernel/perf_event_paranoid
+  (<= 2 allows user-space counting of your own process).
+========================================================================== */
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "benchmark.h"
+
+namespace perf {
+
+enum Event {
+    Cycles,
+    Instructions,
+    L1DMisses,
+    LLCMisses,
+    BranchMisses,
+    DTLBMisses,
+    EventCount
+};
+
+inline const char* eventName(int e) {
+    static const char* names[EventCount] = {"cycles",     "instructions",
+                                            "L1d_misses", "LLC_misses",
+                                            "branch_misses", "dTLB_misses"};
+    return names[e];
+}
+
+// One snapshot of all counters. `valid[e]` is false when the event could not
+// be opened, so callers can print "n/a" instead of a misleading zero.
+struct Sample {
+    std::array<double, EventCount> value{};
+    std::array<bool, EventCount> valid{};
+
+    double ipc() const {
+        return (valid[Cycles] && valid[Instructions] && value[Cycles] > 0)
+                   ? value[Instructions] / value[Cycles]
+                   : 0.0;
+    }
+};
+
+class Counters {
+public:
+    Counters() {
+        fds_.fill(-1);
+#ifdef __linux__
+        open(Cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        open(Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        open(L1DMisses, PERF_TYPE_HW_CACHE, cacheConfig(PERF_COUNT_HW_CACHE_L1D));
+        open(LLCMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        open(BranchMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        open(DTLBMisses, PERF_TYPE_HW_CACHE, cacheConfig(PERF_COUNT_HW_CACHE_DTLB));
+#endif
+    }
+
+    ~Counters() {
+#ifdef __linux__
+        for (int fd : fds_)
+            if (fd >= 0) close(fd);
+#endif
+    }
+
+    // File descriptors are not copyable.
+    Counters(const Counters&) = delete;
+    Counters& operator=(const Counters&) = delete;
+
+    bool available(int e) const { return fds_[e] >= 0; }
+    bool anyAvailable() const {
+        for (int fd : fds_)
+            if (fd >= 0) return true;
+        return false;
+    }
+
+    void start() {
+#ifdef __linux__
+        for (int fd : fds_) {
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    Sample stop() {
+        Sample s;
+#ifdef __linux__
+        for (int fd : fds_)
+            if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        for (int e = 0; e < EventCount; ++e) {
+            if (fds_[e] < 0) continue;
+            // Layout for PERF_FORMAT_TOTAL_TIME_ENABLED | _RUNNING.
+            std::uint64_t data[3] = {0, 0, 0};
+            if (read(fds_[e], data, sizeof(data)) != sizeof(data)) continue;
+            double scale = (data[2] > 0) ? static_cast<double>(data[1]) / data[2] : 0.0;
+            s.value[e] = static_cast<double>(data[0]) * scale;
+            s.valid[e] = data[2] > 0;
+        }
+#endif
+        return s;
+    }
+
+private:
+#ifdef __linux__
+    static std::uint64_t cacheConfig(std::uint64_t cache) {
+        return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+               (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    }
+
+    void open(Event e, std::uint32_t type, std::uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;  // required at perf_event_paranoid == 2
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        long fd = syscall(SYS_perf_event_open, &attr, 0 /* this thread */,
+                          -1 /* any cpu */, -1 /* no group */, 0);
+        fds_[e] = static_cast<int>(fd);
+    }
+#endif
+
+    std::array<int, EventCount> fds_;
+};
+
+// Prints one sample, normalised by `iterations` (use 1 for raw totals).
+inline void print(std::ostream& os, const Sample& s, double iterations = 1.0) {
+    os << std::fixed << std::setprecision(3);
+    for (int e = 0; e < EventCount; ++e) {
+        os << "  " << std::left << std::setw(14) << eventName(e) << std::right;
+        if (s.valid[e]) os << s.value[e] / iterations << '\n';
+        else os << "n/a\n";
+    }
+    os << "  " << std::left << std::setw(14) << "IPC" << std::right;
+    if (s.ipc() > 0) os << s.ipc() << '\n';
+    else os << "n/a\n";
+    os.unsetf(std::ios::fixed);
+}
+
+// RAII: counts everything executed between construction and destruction and
+// prints it under `label`.
+class Region {
+public:
+    explicit Region(std::string label, double iterations = 1.0,
+                    std::ostream& os = std::cout)
+        : label_(std::move(label)), iterations_(iterations), os_(os) {
+        counters_.start();
+    }
+    ~Region() {
+        Sample s = counters_.stop();
+        os_ << label_ << (iterations_ != 1.0 ? " (per iteration)" : "") << ":\n";
+        if (!counters_.anyAvailable()) {
+            os_ << "  hardware counters unavailable\n";
+            return;
+        }
+        print(os_, s, iterations_);
+    }
+
+private:
+    std::string label_;
+    double iterations_;
+    std::ostream& os_;
+    Counters counters_;
+};
+
+// Installs a benchmark.h hook: every measured sample opens the counters around
+// the timed loop and records "<event>/iter" and "IPC" as benchmark counters.
+// Returns false (and installs nothing) if no counter can be opened.
+inline bool attachToBenchmarks() {
+    {
+        Counters probe;
+        if (!probe.anyAvailable()) return false;
+    }
+    bench::addStateHook([](bench::State& state) {
+        // Shared so the callbacks (copied with the State) keep it alive. The
+        // totals accumulate across pauseTiming()/resumeTiming() segments.
+        auto counters = std::make_shared<Counters>();
+        auto total = std::make_shared<Sample>();
+        bench::State* st = &state;
+        state.onStart = [counters] { counters->start(); };
+        state.onStop = [counters, total, st] {
+            Sample s = counters->stop();
+            double iters = static_cast<double>(st->iterations());
+            for (int e = 0; e < EventCount; ++e) {
+                if (!s.valid[e]) continue;
+                total->value[e] += s.value[e];
+                total->valid[e] = true;
+                st->setCounter(std::string(eventName(e)) + "/iter", total->value[e] / iters);
+            }
+            if (total->ipc() > 0) st->setCounter("IPC", total->ipc());
+        };
+    });
+    return true;
+}
+
+}  // namespace perf
+
+#endif  // PERF_COUNTERS_H
@@ -0,0 +1,259 @@
+/* ==========================================================================
+Crash Course: An Async Runtime for Coroutines (C++20)
+
+Theory:
+---------
+Coroutines.cpp resumes its generator by hand. async_runtime.h resumes
+coroutines when what they wait for is done:
+
+   coroutine A                 coroutine B (a Task)
+   co_await B()  ---start--->  runs ... co_return x
+        ^                           |
+        +------ resumed directly ---+   (symmetric transfer)
+
+   co_await io.sleepFor(10ms)    frame parked in the timer heap
+   co_await io.readable(fd)      frame parked in epoll
+   co_await schedule(pool)       frame handed to a worker of the pool
+
+While it waits, a coroutine is only its frame; no thread is blocked.
+
+Key Points:
+- The await cases measure one co_await: of an awaitable that is always
+  ready, and of a Task that finishes at once (frame from the block pool,
+  two symmetric transfers). await/function_call is a plain call.
+- schedule/pool: one hop to the thread pool per item.
+- The timers cases: --ops operations that each wait --delay ms. The
+  coroutines are all waiting at once on one IoContext thread; the thread
+  version needs a thread per waiting operation, so it runs --ops/100.
+- The pipe cases: --roundtrips one-byte messages between two parties over
+  two pipes: coroutines waiting in epoll vs. threads blocked in read().
+
+Edge Cases:
+- Build with -O2: symmetric transfer relies on a tail call.
+
+Example:
+---------
+    coro::Task<int> fetch(coro::IoContext& io) {
+        co_await io.sleepFor(10ms);
+        co_return 42;
+    }
+    int v = coro::syncWait(fetch(io));
+
+Compile & run:
+    g++ -std=c++20 -O2 -pthread AsyncRuntime.cpp -o async_runtime
+    ./async_runtime --bench-samples=5
+    ./async_runtime --ops=1000000 --delay=50 --bench-samples=3
+========================================================================== */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../28.Compiler and Low-Level Optimizations/benchmark.h"
+#include "async_runtime.h"
+using namespace std;
+
+__attribute__((noinline)) long plainLeaf(long x) { return x + 1; }
+
+coro::Task<long> leaf(long x) { co_return x + 1; }
+
+coro::Task<long> awaitTasks(size_t n) {
+    long x = 0;
+    for (size_t i = 0; i < n; ++i) x = co_await leaf(x);
+    co_return x;
+}
+
+coro::Task<long> awaitReady(size_t n) {
+    long x = 0;
+    for (size_t i = 0; i < n; ++i) {
+        co_await suspend_never{};
+        x = plainLeaf(x);
+    }
+    co_return x;
+}
+
+coro::Task<void> hop(tasks::ThreadPool& pool, size_t n) {
+    for (size_t i = 0; i < n; ++i) co_await coro::schedule(pool);
+}
+
+coro::Task<void> sleeper(coro::IoContext& io, chrono::milliseconds delay) {
+    co_await io.sleepFor(delay);
+}
+
+void writeByte(int fd) {
+    char c = 1;
+    if (write(fd, &c, 1) != 1) throw runtime_error("pipe write failed");
+}
+
+// Reads one byte from a non-blocking fd, waiting in epoll if needed.
+coro::Task<void> readByte(coro::IoContext& io, int fd) {
+    char c;
+    while (read(fd, &c, 1) != 1) co_await io.readable(fd);
+}
+
+coro::Task<void> ping(coro::IoContext& io, int out, int in, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        writeByte(out);
+        co_await readByte(io, in);
+    }
+}
+
+coro::Task<void> pong(coro::IoContext& io, int in, int out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        co_await readByte(io, in);
+        writeByte(out);
+    }
+}
+
+struct Pipe {
+    int fd[2];
+    explicit Pipe(int flags) {
+        if (pipe2(fd, flags) != 0) throw runtime_error("pipe2 failed");
+    }
+    ~Pipe() {
+        close(fd[0]);
+        close(fd[1]);
+    }
+};
+
+int main(int argc, char** argv) {
+    size_t awaits = 1000000, ops = 100000, roundtrips = 50000;
+    long delayMs = 10;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.rfind("--ops=", 0) == 0) ops = strtoull(arg.c_str() + 6, nullptr, 10);
+        if (arg.rfind("--delay=", 0) == 0) delayMs = atol(arg.c_str() + 8);
+        if (arg.rfind("--roundtrips=", 0) == 0)
+            roundtrips = strtoull(arg.c_str() + 13, nullptr, 10);
+    }
+    const chrono::milliseconds delay(delayMs);
+
+    tasks::ThreadPool pool;
+    coro::IoContext io;
+    thread ioThread([&io] { io.run(); });
+    cout << pool.size() << " pool workers + 1 IoContext thread; " << ops << " timer ops of "
+         << delayMs << " ms\n\n";
+
+    bench::registerCase("await/function_call", [&](bench::State& state) {
+        for (auto _ : state) {
+            long x = 0;
+            for (size_t i = 0; i < awaits; ++i) x = plainLeaf(x);
+            bench::DoNotOptimize(x);
+        }
+        state.setItemsProcessed(awaits);
+    });
+
+    bench::registerCase("await/ready_awaitable", [&](bench::State& state) {
+        for (auto _ : state) bench::DoNotOptimize(coro::syncWait(awaitReady(awaits)));
+        state.setItemsProcessed(awaits);
+    });
+
+    bench::registerCase("await/task", [&](bench::State& state) {
+        for (auto _ : state) bench::DoNotOptimize(coro::syncWait(awaitTasks(awaits)));
+        state.setItemsProcessed(awaits);
+    });
+
+    bench::registerCase("schedule/pool", [&](bench::State& state) {
+        const size_t hops = 100000;
+        for (auto _ : state) coro::syncWait(hop(pool, hops));
+        state.setItemsProcessed(hops);
+    });
+
+    bench::registerCase("timers/coroutines", [&](bench::State& state) {
+        for (auto _ : state) {
+            vector<coro::Task<void>> sleepers;
+            sleepers.reserve(ops);
+            for (size_t i = 0; i < ops; ++i) sleepers.push_back(sleeper(io, delay));
+            coro::syncWait(coro::whenAll(std::move(sleepers)));
+        }
+        state.setItemsProcessed(ops);
+        state.setCounter("threads", 1);
+    });
+
+    bench::registerCase("timers/threads", [&](bench::State& state) {
+        const size_t count = max<size_t>(1, ops / 100);
+        for (auto _ : state) {
+            vector<thread> threads;
+            threads.reserve(count);
+            for (size_t i = 0; i < count; ++i)
+                threads.emplace_back([delay] { this_thread::sleep_for(delay); });
+            for (thread& t : threads) t.join();
+        }
+        state.setItemsProcessed(count);
+        state.setCounter("threads", static_cast<double>(count));
+    });
+
+    bench::registerCase("pipe/coroutines", [&](bench::State& state) {
+        Pipe there(O_NONBLOCK | O_CLOEXEC), back(O_NONBLOCK | O_CLOEXEC);
+        for (auto _ : state) {
+            vector<coro::Task<void>> parties;
+            parties.push_back(ping(io, there.fd[1], back.fd[0], roundtrips));
+            parties.push_back(pong(io, there.fd[0], back.fd[1], roundtrips));
+            coro::syncWait(coro::whenAll(std::move(parties)));
+        }
+        state.setItemsProcessed(roundtrips);
+    });
+
+    bench::registerCase("pipe/threads", [&](bench::State& state) {
+        Pipe there(O_CLOEXEC), back(O_CLOEXEC);
+        for (auto _ : state) {
+            thread ponger([&] {
+                char c;
+                for (size_t i = 0; i < roundtrips; ++i)
+                    if (read(there.fd[0], &c, 1) == 1) writeByte(back.fd[1]);
+            });
+            char c;
+            for (size_t i = 0; i < roundtrips; ++i) {
+                writeByte(there.fd[1]);
+                if (read(back.fd[0], &c, 1) != 1) throw runtime_error("pipe read failed");
+            }
+            ponger.join();
+        }
+        state.setItemsProcessed(roundtrips);
+    });
+
+    int rc = bench::runAll(argc, argv);
+
+    // Timers and the pool together: the result of three staggered waits.
+    auto staged = [&](int id) -> coro::Task<string> {
+        co_await io.sleepFor(chrono::milliseconds(30 * (3 - id)));
+        co_await coro::schedule(pool);
+        co_return "task " + to_string(id) + " done on the pool";
+    };
+    vector<coro::Task<string>> staggered;
+    for (int id = 0; id < 3; ++id) staggered.push_back(staged(id));
+    for (const string& line : coro::syncWait(coro::whenAll(std::move(staggered))))
+        cout << line << '\n';
+
+    io.stop();
+    ioThread.join();
+    return rc;
+}
+
+/*
+What to expect:
+- await/ready_awaitable costs about what await/function_call costs, a
+  nanosecond or two: an await that does not suspend compiles to almost
+  nothing.
+- await/task is 10-20 ns: creating the Task's frame (a block from the
+  pool, not malloc; with plain operator new it is about twice as slow),
+  a symmetric transfer there and back, and destroying the frame.
+- schedule/pool costs a pool task per hop, tens of nanoseconds.
+- timers/coroutines keeps all --ops operations waiting at once on a
+  single thread: the case takes about --delay ms plus a fraction of a
+  microsecond per operation. timers/threads starts a thread per waiting
+  operation, tens of microseconds each, even with a hundredth of them.
+- pipe/coroutines and pipe/threads are of the same order: both make a
+  read and a write per message and wake the other side through the
+  kernel (epoll or a blocked read), but the coroutines need no thread per
+  party.
+- The last lines print the three staged tasks in order 0, 1, 2 although
+  they finish in the opposite order: whenAll returns values in order.
+*/
@@ -22,6 +22,8 @@ in a coroutine frame (usually allocated on the heap). The key components include
 Key Keywords:
 - co_await, co_yield, and co_return are used to suspend and resume execution.
 - A promise_type defines how to store state and how to yield values.
+- Here the caller resumes the coroutine; AsyncRuntime.cpp (async_runtime.h) resumes
+  coroutines when a task, timer or socket they wait for is ready.
 
 Edge Cases:
 - Proper exception handling and cleanup within coroutines is essential.
@@ -29,11 +31,23 @@ Edge Cases:
 
 Example:
 ---------
-A minimal generator that yields integers from 0 to max - 1 using co_yield.
+A minimal generator that yields integers from 0 to max - 1 using co_yield: the
+promise_type stores the current value, the handle resumes the coroutine.
+
+coro::Generator (generator.h) is the same promise_type/handle pair, made cheaper and
+safer: co_yield hands out the address of the value instead of a copy, frames come
+from a per-thread free list instead of operator new, an exception in the coroutine
+comes out of the loop that iterates it, and it is a range. Generators.cpp compares
+the two with a hand-written loop; Pipelines.cpp (pipeline.h) fuses a chain of
+stages into one loop instead of one generator per stage.
 ========================================================================== */
 
 #include <coroutine>
+#include <cstdlib>
 #include <iostream>
+#include <ranges>
+#include <stdexcept>
+#include "generator.h"
 using namespace std;
 
 template<typename T>
@@ -80,11 +94,36 @@ Generator<int> counter(int max) {
     }
 }
 
+// The same generator with coro::Generator.
+coro::Generator<int> upTo(int max) {
+    for (int i = 0; i < max; i++) {
+        co_yield i;
+    }
+}
+
+coro::Generator<int> failing() {
+    co_yield 1;
+    throw runtime_error("sensor offline");
+}
+
 int main() {
     cout << "Coroutine Generator Example:" << endl;
     auto gen = counter(5);
     while (gen.next()) {
         cout << "Value: " << gen.current() << endl;
     }
+
+    // coro::Generator is a range: range-for, and it composes with std::views.
+    auto multiplesOf7 = views::filter([](int v) { return v % 7 == 0; });
+    for (int value : upTo(100) | multiplesOf7 | views::take(3)) {
+        cout << "Multiple of 7: " << value << endl;
+    }
+
+    // Exceptions reach the caller instead of ending the program.
+    try {
+        for (int value : failing()) cout << "Reading: " << value << endl;
+    } catch (const runtime_error& e) {
+        cout << "Caught: " << e.what() << endl;
+    }
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,228 @@
+/* ==========================================================================
+Crash Course: What a Generator Costs (C++20)
+
+Theory:
+---------
+A generator turns a loop inside out: the loop body moves to the caller,
+and every element costs a resume and a suspend of the coroutine:
+
+   caller                        coroutine frame
+   ++it  ---- resume -------->   ... compute x ...
+         <--- suspend (co_yield x) ---+
+   use *it
+
+coro::Generator (generator.h) keeps the rest of the cost down: *it refers
+to the yielded object itself, and the frame comes from a recycled pool.
+CopyingGenerator below is the Generator that Coroutines.cpp used to have:
+it copies each value into the promise and copies it out again, and
+allocates frames with operator new.
+
+Key Points:
+- The ints cases yield --n small values; the records cases yield --n
+  128-byte records built in place, which the copying generator copies
+  twice each.
+- The frames cases run a million generators of 4 elements each, so the
+  frame allocation is a large part of the cost.
+- hand_loop is the same loop without a coroutine. mix() keeps the
+  compiler from turning it into a formula, so every case does the same
+  work per element.
+
+Compile & run:
+    g++ -std=c++20 -O2 -pthread Generators.cpp -o generators
+    ./generators --bench-samples=5
+    ./generators --n=100000000 --bench-samples=3
+========================================================================== */
+
+#include <coroutine>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "../28.Compiler and Low-Level Optimizations/benchmark.h"
+#include "generator.h"
+using namespace std;
+
+// The original Generator of Coroutines.cpp, kept for comparison.
+template <typename T>
+struct CopyingGenerator {
+    struct promise_type {
+        T current_value;
+        suspend_always yield_value(T value) {
+            current_value = value;
+            return {};
+        }
+        suspend_always initial_suspend() { return {}; }
+        suspend_always final_suspend() noexcept { return {}; }
+        CopyingGenerator get_return_object() {
+            return CopyingGenerator{coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        void unhandled_exception() { exit(1); }
+        void return_void() {}
+    };
+
+    coroutine_handle<promise_type> handle;
+    CopyingGenerator(coroutine_handle<promise_type> h) : handle(h) {}
+    ~CopyingGenerator() {
+        if (handle) handle.destroy();
+    }
+    CopyingGenerator(const CopyingGenerator&) = delete;
+    CopyingGenerator& operator=(const CopyingGenerator&) = delete;
+    bool next() {
+        handle.resume();
+        return !handle.done();
+    }
+    T current() { return handle.promise().current_value; }
+};
+
+struct Record {
+    uint64_t id;
+    uint64_t fields[15];
+};
+
+// Some per-element work the compiler cannot fold into a formula.
+inline uint64_t mix(uint64_t x) {
+    x ^= x >> 31;
+    x *= 0x9E3779B97F4A7C15ull;
+    return x ^ (x >> 29);
+}
+
+inline void fill(Record& r, uint64_t i) {
+    r.id = i;
+    for (int f = 0; f < 15; ++f) r.fields[f] = i + f;
+}
+
+coro::Generator<uint64_t> ints(uint64_t n) {
+    for (uint64_t i = 0; i < n; ++i) co_yield mix(i);
+}
+
+CopyingGenerator<uint64_t> copyingInts(uint64_t n) {
+    for (uint64_t i = 0; i < n; ++i) co_yield mix(i);
+}
+
+coro::Generator<Record> records(uint64_t n) {
+    Record r;
+    for (uint64_t i = 0; i < n; ++i) {
+        fill(r, i);
+        co_yield r;
+    }
+}
+
+CopyingGenerator<Record> copyingRecords(uint64_t n) {
+    Record r;
+    for (uint64_t i = 0; i < n; ++i) {
+        fill(r, i);
+        co_yield r;
+    }
+}
+
+int main(int argc, char** argv) {
+    uint64_t n = 10000000;
+    const uint64_t generators = 1000000;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.rfind("--n=", 0) == 0) n = strtoull(arg.c_str() + 4, nullptr, 10);
+    }
+    cout << n << " elements per pass\n\n";
+
+    bench::registerCase("ints/hand_loop", [&](bench::State& state) {
+        for (auto _ : state) {
+            uint64_t sum = 0;
+            for (uint64_t i = 0; i < n; ++i) sum += mix(i);
+            bench::DoNotOptimize(sum);
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("ints/generator", [&](bench::State& state) {
+        for (auto _ : state) {
+            uint64_t sum = 0;
+            for (uint64_t v : ints(n)) sum += v;
+            bench::DoNotOptimize(sum);
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("ints/copying_generator", [&](bench::State& state) {
+        for (auto _ : state) {
+            uint64_t sum = 0;
+            auto gen = copyingInts(n);
+            while (gen.next()) sum += gen.current();
+            bench::DoNotOptimize(sum);
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("records/hand_loop", [&](bench::State& state) {
+        for (auto _ : state) {
+            uint64_t sum = 0;
+            Record r;
+            for (uint64_t i = 0; i < n; ++i) {
+                fill(r, i);
+                bench::DoNotOptimize(&r);
+                sum += r.id + r.fields[14];
+            }
+            bench::DoNotOptimize(sum);
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("records/generator", [&](bench::State& state) {
+        for (auto _ : state) {
+            uint64_t sum = 0;
+            for (const Record& r : records(n)) sum += r.id + r.fields[14];
+            bench::DoNotOptimize(sum);
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("records/copying_generator", [&](bench::State& state) {
+        for (auto _ : state) {
+            uint64_t sum = 0;
+            auto gen = copyingRecords(n);
+            while (gen.next()) {
+                Record r = gen.current();
+                sum += r.id + r.fields[14];
+            }
+            bench::DoNotOptimize(sum);
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("frames/pooled", [&](bench::State& state) {
+        for (auto _ : state) {
+            uint64_t sum = 0;
+            for (uint64_t g = 0; g < generators; ++g)
+                for (uint64_t v : ints(4)) sum += v;
+            bench::DoNotOptimize(sum);
+        }
+        state.setItemsProcessed(generators);
+    });
+
+    bench::registerCase("frames/operator_new", [&](bench::State& state) {
+        for (auto _ : state) {
+            uint64_t sum = 0;
+            for (uint64_t g = 0; g < generators; ++g) {
+                auto gen = copyingInts(4);
+                while (gen.next()) sum += gen.current();
+            }
+            bench::DoNotOptimize(sum);
+        }
+        state.setItemsProcessed(generators);
+    });
+
+    return bench::runAll(argc, argv);
+}
+
+/*
+What to expect:
+- ints/generator costs a couple of nanoseconds per element more than
+  ints/hand_loop: the resume and suspend. ints/copying_generator adds a
+  little more for its copies and next()/current() calls.
+- records/generator adds the same few nanoseconds to records/hand_loop;
+  records/copying_generator copies 128 bytes into the promise and 128
+  bytes out of it per element and is about a quarter slower again.
+- frames/pooled beats frames/operator_new by about a quarter per
+  generator: a block from the pool's free list instead of malloc and
+  free.
+*/
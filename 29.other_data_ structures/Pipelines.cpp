@@ -0,0 +1,211 @@
+/* ==========================================================================
+Crash Course: Lazy Pipelines Without a Resume per Stage (C++20)
+
+Theory:
+---------
+With generators, a data pipeline is a chain of coroutines: the last one
+pulls from the one before it, and so on down to the source. Every element
+costs a resume and a suspend in every stage:
+
+   source --resume--> stage 1 --resume--> stage 2 --resume--> consumer
+
+pipeline.h builds the same pipeline from lazy adaptors joined with |.
+Nothing runs until a terminal such as sum(); then the source pushes each
+element through all stages, which the compiler inlines into one loop.
+When the result has to be a generator, chunks(pipeline, n) yields spans
+of n elements: one resume per span.
+
+Key Points:
+- Every case computes the same sum over --n elements:
+      x = 3 * i + 1;  keep x unless x % 5 == 0;  add x ^ (x >> 7)
+- hand_loop is the loop written out; std_views uses
+  views::iota | views::transform | views::filter | views::transform.
+- generators/nested is one coro::Generator per stage;
+  generators/chunked is chunks() of the fused pipeline, 4096 per span.
+- pipeline/chunk_stage runs the fused stages, then chunk(4096) and a
+  forEach over the spans, as code that wants whole blocks would.
+
+Example:
+---------
+    using namespace pipeline;   // without using namespace std: std::map
+    uint64_t total = iota<uint64_t>(0, n) | map(f) | filter(p) | map(g) | sum();
+
+Compile & run:
+    g++ -std=c++20 -O2 -pthread Pipelines.cpp -o pipelines
+    ./pipelines --bench-samples=5
+    ./pipelines --n=1000000000 --bench-samples=3
+========================================================================== */
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../28.Compiler and Low-Level Optimizations/benchmark.h"
+#include "generator.h"
+#include "pipeline.h"
+using namespace std;
+
+const auto scale = [](uint64_t i) { return 3 * i + 1; };
+const auto keep = [](uint64_t x) { return x % 5 != 0; };
+const auto mix = [](uint64_t x) { return x ^ (x >> 7); };
+
+coro::Generator<uint64_t> source(uint64_t n) {
+    for (uint64_t i = 0; i < n; ++i) co_yield i;
+}
+
+coro::Generator<uint64_t> scaled(coro::Generator<uint64_t> in) {
+    for (uint64_t x : in) co_yield scale(x);
+}
+
+coro::Generator<uint64_t> kept(coro::Generator<uint64_t> in) {
+    for (uint64_t x : in)
+        if (keep(x)) co_yield x;
+}
+
+coro::Generator<uint64_t> mixed(coro::Generator<uint64_t> in) {
+    for (uint64_t x : in) co_yield mix(x);
+}
+
+auto fused(uint64_t n) {
+    return pipeline::iota<uint64_t>(0, n) | pipeline::map(scale) | pipeline::filter(keep) |
+           pipeline::map(mix);
+}
+
+int main(int argc, char** argv) {
+    uint64_t n = 100000000;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.rfind("--n=", 0) == 0) n = strtoull(arg.c_str() + 4, nullptr, 10);
+    }
+    cout << n << " elements per pass\n\n";
+
+    uint64_t expected = 0;
+    for (uint64_t i = 0; i < n; ++i) {
+        uint64_t x = scale(i);
+        if (keep(x)) expected += mix(x);
+    }
+    auto check = [&](uint64_t total) {
+        if (total != expected) throw logic_error("wrong sum");
+    };
+
+    bench::registerCase("hand_loop", [&](bench::State& state) {
+        for (auto _ : state) {
+            uint64_t total = 0;
+            for (uint64_t i = 0; i < n; ++i) {
+                uint64_t x = 3 * i + 1;
+                if (x % 5 != 0) total += x ^ (x >> 7);
+            }
+            bench::DoNotOptimize(total);
+            check(total);
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("std_views", [&](bench::State& state) {
+        for (auto _ : state) {
+            uint64_t total = 0;
+            for (uint64_t x : views::iota(uint64_t(0), n) | views::transform(scale) |
+                                  views::filter(keep) | views::transform(mix))
+                total += x;
+            bench::DoNotOptimize(total);
+            check(total);
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("pipeline/fused", [&](bench::State& state) {
+        for (auto _ : state) {
+            uint64_t total = fused(n) | pipeline::sum();
+            bench::DoNotOptimize(total);
+            check(total);
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("pipeline/chunk_stage", [&](bench::State& state) {
+        for (auto _ : state) {
+            uint64_t total = 0;
+            auto add = [&](span<const uint64_t> block) {
+                for (uint64_t x : block) total += x;
+            };
+            fused(n) | pipeline::chunk(4096) | pipeline::forEach(add);
+            bench::DoNotOptimize(total);
+            check(total);
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("generators/nested", [&](bench::State& state) {
+        for (auto _ : state) {
+            uint64_t total = 0;
+            for (uint64_t x : mixed(kept(scaled(source(n))))) total += x;
+            bench::DoNotOptimize(total);
+            check(total);
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("generators/chunked", [&](bench::State& state) {
+        for (auto _ : state) {
+            uint64_t total = 0;
+            for (span<const uint64_t> block : pipeline::chunks(fused(n), 4096))
+                for (uint64_t x : block) total += x;
+            bench::DoNotOptimize(total);
+            check(total);
+        }
+        state.setItemsProcessed(n);
+    });
+
+    int rc = bench::runAll(argc, argv);
+
+    // map | map and filter | filter merge into one stage each.
+    auto merged = pipeline::iota<uint64_t>(0, 100) | pipeline::map(scale) | pipeline::map(mix) |
+                  pipeline::filter(keep) | pipeline::filter(keep);
+    cout << "\nmap | map | filter | filter has " << decltype(merged)::stageCount << " stages\n";
+    cout << "first five: ";
+    for (uint64_t x : std::move(merged) | pipeline::take(5) | pipeline::toVector())
+        cout << x << ' ';
+    cout << '\n';
+
+    // Terminals run a copy: a pipeline over a container lvalue runs again.
+    vector<uint64_t> values{1, 2, 3, 4, 5};
+    auto doubled = pipeline::from(values) | pipeline::map([](uint64_t x) { return 2 * x; });
+    uint64_t first = doubled | pipeline::sum();
+    uint64_t second = doubled | pipeline::sum();
+    cout << "run twice: " << first << ' ' << second << '\n';
+    if (first != second) throw logic_error("pipeline not reusable");
+
+    // Collected chunks are copies: they outlive the chunk stage's buffer.
+    vector<vector<int>> blocks = pipeline::iota(0, 10) | pipeline::chunk(4) | pipeline::toVector();
+    vector<vector<int>> expectedBlocks{{0, 1, 2, 3}, {4, 5, 6, 7}, {8, 9}};
+    size_t spans = 0;
+    auto chunked = pipeline::iota(0, 10) | pipeline::chunk(4);
+    for (span<const vector<int>> part : pipeline::chunks(chunked, 2))
+        for (const vector<int>& block : part)
+            if (block != expectedBlocks[spans++]) throw logic_error("chunks() lost a chunk");
+    cout << "chunk(4) collected: " << blocks.size() << " blocks, last " << blocks.back().size()
+         << " long\n";
+    if (blocks != expectedBlocks || spans != 3) throw logic_error("collected chunks dangle");
+    return rc;
+}
+
+/*
+What to expect:
+- pipeline/fused runs as fast as hand_loop: after inlining it is the same
+  loop. std_views is a little slower; filter's iterator tests the
+  predicate in ++ and checks for the end again in the range-for.
+- generators/nested is about nine times slower than hand_loop: four
+  coroutines, each resumed and suspended for every element.
+- generators/chunked hands out a generator too, but resumes it once per
+  4096 elements: several times faster than generators/nested. It and
+  pipeline/chunk_stage pay for storing each element into the chunk
+  buffer and reading it back, about half again the fused loop.
+- The last lines show that map | map | filter | filter became 2 stages,
+  the first five values, the same sum (30) from two runs of one
+  pipeline, and the three chunks of iota(0, 10) | chunk(4).
+*/
@@ -0,0 +1,600 @@
+/* ==========================================================================
+async_runtime.h - Tasks, Timers and I/O for Coroutines (C++20)
+
+Theory:
+---------
+Coroutines.cpp shows a generator: the caller resumes the coroutine by hand.
+For asynchronous work the coroutine should be resumed when what it waits
+for is done: another coroutine, a thread of a pool, a timer, a socket.
+This header has the pieces for that:
+
+1. coro::Task<T>: a coroutine that produces a T. It starts when it is
+   co_awaited; when it finishes it resumes the awaiting coroutine directly
+   (symmetric transfer: await_suspend returns the handle to resume, so a
+   chain of a million awaits uses no stack).
+2. `co_await coro::schedule(pool)`: continue on a worker of a
+   tasks::ThreadPool (27.Concurrency.../thread_pool.h).
+3. coro::IoContext: an event loop on one thread with a timer heap and
+   epoll. `co_await io.sleepFor(1ms)`, `co_await io.readable(fd)`.
+4. `co_await coro::whenAll(tasks)`: run several tasks at once and wait
+   for all of them. coro::syncWait(task) blocks a normal thread until a
+   task is done.
+
+A suspended coroutine is just its frame (a few hundred bytes), so 100k
+operations waiting on timers or sockets need 100k frames, not 100k
+threads. Frames come from the recycled block pool of future.h.
+
+Key Points:
+- A Task is lazy and move-only; `co_await std::move(task)` or
+  `co_await f()` starts it and returns its value or rethrows its
+  exception.
+- After `co_await io.sleepFor(...)` or `io.readable(fd)` the coroutine
+  runs on the thread of io.run(); `co_await coro::schedule(pool)` moves it
+  back to the pool.
+- readable()/writable() use EPOLLONESHOT: one coroutine may wait per fd
+  at a time. Set the fd non-blocking and read until EAGAIN.
+- Timers have millisecond resolution (epoll_wait's timeout).
+- Symmetric transfer needs a tail call: GCC makes it with -O2, not with
+  -O0 or -fsanitize=address, where very deep synchronous chains of
+  co_await overflow the stack.
+- Edge Cases: coroutines still suspended when the IoContext stops are
+  never resumed; their frames leak. whenAll starts every task even if
+  one fails; the first failed one (in order) is rethrown.
+========================================================================== */
+
+#ifndef ASYNC_RUNTIME_H
+#define ASYNC_RUNTIME_H
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../27.Concurrency and Multithreading (Optional/future.h"
+
+namespace coro {
+
+template <class T = void>
+class Task;
+
+namespace detail {
+
+// Coroutine frames come from future.h's recycled blocks.
+struct PooledFrame {
+    static void* operator new(std::size_t size) {
+        return tasks::detail::BlockPool::allocate(size);
+    }
+    static void operator delete(void* p, std::size_t size) {
+        tasks::detail::BlockPool::free(p, size);
+    }
+};
+
+struct PromiseBase : PooledFrame {
+    // Resumes the awaiting coroutine, if any, in place of returning.
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        template <class P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) const noexcept {
+            std::coroutine_handle<> next = h.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { error = std::current_exception(); }
+
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+};
+
+template <class T>
+struct Promise : PromiseBase {
+    Task<T> get_return_object() noexcept;
+
+    template <class U>
+    void return_value(U&& value) {
+        result.emplace(std::forward<U>(value));
+    }
+
+    T take() {
+        if (error) std::rethrow_exception(error);
+        return std::move(*result);
+    }
+
+    std::optional<T> result;
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object() noexcept;
+    void return_void() const noexcept {}
+
+    void take() const {
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+}  // namespace detail
+
+template <class T>
+class [[nodiscard]] Task {
+public:
+    using promise_type = detail::Promise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Task() = default;
+    explicit Task(Handle handle) : handle_(handle) {}
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    ~Task() {
+        if (handle_) handle_.destroy();
+    }
+
+    bool done() const { return handle_.done(); }
+
+    // Starts the task (or takes the value of a finished one).
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            Handle handle;
+            bool await_ready() const noexcept { return handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+            T await_resume() { return handle.promise().take(); }
+        };
+        return Awaiter{handle_};
+    }
+
+    // Waits for the task without taking its value or exception.
+    auto whenReady() noexcept {
+        struct Awaiter {
+            Handle handle;
+            bool await_ready() const noexcept { return handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{handle_};
+    }
+
+    // The value of a finished task.
+    T result() { return handle_.promise().take(); }
+
+private:
+    Handle handle_;
+};
+
+namespace detail {
+
+template <class T>
+Task<T> Promise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<Promise>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() noexcept {
+    return Task<void>(std::coroutine_handle<Promise>::from_promise(*this));
+}
+
+}  // namespace detail
+
+// ---------------------------------------------------------------------------
+// Executors
+// ---------------------------------------------------------------------------
+
+// co_await schedule(executor): continue inside executor.submit(), e.g. on a
+// worker of a tasks::ThreadPool.
+template <class Executor>
+auto schedule(Executor& executor) {
+    struct Awaiter {
+        Executor& executor;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) {
+            executor.submit([h] { h.resume(); });
+        }
+        void await_resume() const noexcept {}
+    };
+    return Awaiter{executor};
+}
+
+// ---------------------------------------------------------------------------
+// whenAll / syncWait
+// ---------------------------------------------------------------------------
+
+namespace detail {
+
+struct Latch {
+    std::atomic<std::size_t> count{0};
+    std::coroutine_handle<> waiter;
+};
+
+// Waits for one task and counts the latch down; the last one resumes the
+// waiter. Destroys its own frame.
+struct LatchTask {
+    struct promise_type : PooledFrame {
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<promise_type> h) const noexcept {
+                Latch* latch = h.promise().latch;
+                h.destroy();
+                if (latch->count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    return latch->waiter;
+                return std::noop_coroutine();
+            }
+            void await_resume() const noexcept {}
+        };
+
+        LatchTask get_return_object() noexcept {
+            return {std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+
+        Latch* latch = nullptr;
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+template <class T>
+LatchTask countDownWhenReady(Task<T>& task) {
+    co_await task.whenReady();
+}
+
+// Starts every LatchTask; suspends until all have finished.
+class StartAll {
+public:
+    explicit StartAll(std::vector<LatchTask> starters) : starters_(std::move(starters)) {}
+
+    bool await_ready() const noexcept { return starters_.empty(); }
+
+    bool await_suspend(std::coroutine_handle<> waiter) noexcept {
+        // One extra count, so that no task resumes the waiter before all
+        // have been started.
+        latch_.count.store(starters_.size() + 1, std::memory_order_relaxed);
+        latch_.waiter = waiter;
+        for (LatchTask& s : starters_) {
+            s.handle.promise().latch = &latch_;
+            s.handle.resume();
+        }
+        return latch_.count.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+
+    void await_resume() const noexcept {}
+
+private:
+    std::vector<LatchTask> starters_;
+    Latch latch_;
+};
+
+// syncWait's bridge to a thread: sets a flag under a mutex when the task is
+// done.
+struct Signal {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+
+    void set() {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+        cv.notify_one();
+    }
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return done; });
+    }
+};
+
+struct SignalTask {
+    struct promise_type : PooledFrame {
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<promise_type> h) const noexcept {
+                h.promise().signal->set();  // the frame may be gone after this
+            }
+            void await_resume() const noexcept {}
+        };
+
+        SignalTask get_return_object() noexcept {
+            return {std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+
+        Signal* signal = nullptr;
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+template <class T>
+SignalTask signalWhenReady(Task<T>& task) {
+    co_await task.whenReady();
+}
+
+}  // namespace detail
+
+// Runs all tasks at once; returns their values in order.
+template <class T>
+    requires(!std::is_void_v<T>)
+Task<std::vector<T>> whenAll(std::vector<Task<T>> tasks) {
+    std::vector<detail::LatchTask> starters;
+    starters.reserve(tasks.size());
+    for (Task<T>& task : tasks) starters.push_back(detail::countDownWhenReady(task));
+    co_await detail::StartAll(std::move(starters));
+    std::vector<T> values;
+    values.reserve(tasks.size());
+    for (Task<T>& task : tasks) values.push_back(co_await std::move(task));
+    co_return values;
+}
+
+inline Task<void> whenAll(std::vector<Task<void>> tasks) {
+    std::vector<detail::LatchTask> starters;
+    starters.reserve(tasks.size());
+    for (Task<void>& task : tasks) starters.push_back(detail::countDownWhenReady(task));
+    co_await detail::StartAll(std::move(starters));
+    for (Task<void>& task : tasks) co_await std::move(task);
+}
+
+// Tasks of different types (no void ones): a tuple of their values.
+template <class... Ts>
+    requires(!std::is_void_v<Ts> && ...)
+Task<std::tuple<Ts...>> whenAll(Task<Ts>... tasks) {
+    std::vector<detail::LatchTask> starters;
+    starters.reserve(sizeof...(Ts));
+    (starters.push_back(detail::countDownWhenReady(tasks)), ...);
+    co_await detail::StartAll(std::move(starters));
+    co_return std::tuple<Ts...>{co_await std::move(tasks)...};
+}
+
+// Runs the task and blocks the calling thread until it is done.
+template <class T>
+T syncWait(Task<T> task) {
+    detail::Signal signal;
+    detail::SignalTask waiter = detail::signalWhenReady(task);
+    waiter.handle.promise().signal = &signal;
+    waiter.handle.resume();
+    signal.wait();
+    waiter.handle.destroy();
+    return task.result();
+}
+
+// ---------------------------------------------------------------------------
+// IoContext: timers and epoll readiness on one thread
+// ---------------------------------------------------------------------------
+
+class IoContext {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    IoContext() {
+        epoll_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_ < 0) throw std::system_error(errno, std::generic_category(), "epoll_create1");
+        wake_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = nullptr;  // marks the wake-up eventfd
+        if (wake_ < 0 || epoll_ctl(epoll_, EPOLL_CTL_ADD, wake_, &ev) != 0) {
+            int error = errno;
+            if (wake_ >= 0) close(wake_);
+            close(epoll_);
+            throw std::system_error(error, std::generic_category(), "eventfd");
+        }
+    }
+
+    ~IoContext() {
+        close(wake_);
+        close(epoll_);
+    }
+
+    IoContext(const IoContext&) = delete;
+    IoContext& operator=(const IoContext&) = delete;
+
+    // Resumes timers, ready fds and scheduled coroutines until stop().
+    void run() {
+        std::vector<std::coroutine_handle<>> ready;
+        epoll_event events[64];
+        while (!stopped_.load(std::memory_order_acquire)) {
+            int timeoutMs = collect(ready);
+            for (std::coroutine_handle<> h : ready) h.resume();
+            ready.clear();
+            int n = epoll_wait(epoll_, events, 64, timeoutMs);
+            if (timeoutMs != 0) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                sleeping_ = false;
+            }
+            for (int i = 0; i < n; ++i) {
+                if (!events[i].data.ptr) {
+                    std::uint64_t count;
+                    while (read(wake_, &count, sizeof count) > 0) {
+                    }
+                    continue;
+                }
+                auto* waiter = static_cast<IoAwaiter*>(events[i].data.ptr);
+                waiter->revents_ = events[i].events;
+                waiter->handle_.resume();
+            }
+        }
+    }
+
+    // Makes run() return; callable from any thread.
+    void stop() {
+        stopped_.store(true, std::memory_order_release);
+        wakeLoop();
+    }
+
+    // co_await io.schedule(): continue on the thread of run().
+    auto schedule() {
+        struct Awaiter {
+            IoContext& io;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) { io.post(h); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this};
+    }
+
+    auto sleepUntil(Clock::time_point deadline) {
+        struct Awaiter {
+            IoContext& io;
+            Clock::time_point deadline;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) { io.addTimer(deadline, h); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this, deadline};
+    }
+
+    template <class Rep, class Period>
+    auto sleepFor(std::chrono::duration<Rep, Period> delay) {
+        return sleepUntil(Clock::now() + std::chrono::duration_cast<Clock::duration>(delay));
+    }
+
+    class IoAwaiter {
+    public:
+        IoAwaiter(IoContext& io, int fd, std::uint32_t events)
+            : io_(io), fd_(fd), events_(events) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> h) {
+            handle_ = h;
+            epoll_event ev{};
+            ev.events = events_ | EPOLLONESHOT;
+            ev.data.ptr = this;
+            // Once added, an fd stays in the epoll set, disarmed.
+            if (epoll_ctl(io_.epoll_, EPOLL_CTL_MOD, fd_, &ev) != 0 &&
+                (errno != ENOENT || epoll_ctl(io_.epoll_, EPOLL_CTL_ADD, fd_, &ev) != 0))
+                throw std::system_error(errno, std::generic_category(), "epoll_ctl");
+        }
+
+        // The epoll events that woke the coroutine (EPOLLIN, EPOLLHUP, ...).
+        std::uint32_t await_resume() const noexcept { return revents_; }
+
+    private:
+        friend class IoContext;
+
+        IoContext& io_;
+        int fd_;
+        std::uint32_t events_;
+        std::uint32_t revents_ = 0;
+        std::coroutine_handle<> handle_;
+    };
+
+    IoAwaiter readable(int fd) { return IoAwaiter(*this, fd, EPOLLIN); }
+    IoAwaiter writable(int fd) { return IoAwaiter(*this, fd, EPOLLOUT); }
+
+    // Timers and scheduled coroutines not yet resumed.
+    std::size_t pending() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return timers_.size() + posted_.size();
+    }
+
+private:
+    struct Timer {
+        Clock::time_point deadline;
+        std::uint64_t sequence;  // equal deadlines fire in order
+        std::coroutine_handle<> handle;
+
+        bool operator>(const Timer& other) const {
+            return deadline != other.deadline ? deadline > other.deadline
+                                              : sequence > other.sequence;
+        }
+    };
+
+    void post(std::coroutine_handle<> h) {
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            posted_.push_back(h);
+            wake = sleeping_;
+            sleeping_ = false;
+        }
+        if (wake) wakeLoop();
+    }
+
+    void addTimer(Clock::time_point deadline, std::coroutine_handle<> h) {
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            timers_.push(Timer{deadline, sequence_++, h});
+            wake = sleeping_ && deadline < sleepUntil_;
+            if (wake) sleeping_ = false;
+        }
+        if (wake) wakeLoop();
+    }
+
+    void wakeLoop() {
+        std::uint64_t one = 1;
+        [[maybe_unused]] ssize_t n = write(wake_, &one, sizeof one);
+    }
+
+    // Moves due timers and posted coroutines to `ready`; returns the
+    // epoll_wait timeout. With nothing ready, the loop is "sleeping" until
+    // the next timer and other threads wake it for earlier work.
+    int collect(std::vector<std::coroutine_handle<>>& ready) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Clock::time_point now = Clock::now();
+        while (!timers_.empty() && timers_.top().deadline <= now) {
+            ready.push_back(timers_.top().handle);
+            timers_.pop();
+        }
+        ready.insert(ready.end(), posted_.begin(), posted_.end());
+        posted_.clear();
+        if (!ready.empty()) return 0;
+        sleeping_ = true;
+        if (timers_.empty()) {
+            sleepUntil_ = Clock::time_point::max();
+            return -1;
+        }
+        sleepUntil_ = timers_.top().deadline;
+        auto wait = std::chrono::ceil<std::chrono::milliseconds>(sleepUntil_ - now);
+        return static_cast<int>(wait.count());
+    }
+
+    int epoll_ = -1;
+    int wake_ = -1;
+    std::atomic<bool> stopped_{false};
+
+    std::mutex mutex_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<>> timers_;
+    std::vector<std::coroutine_handle<>> posted_;
+    std::uint64_t sequence_ = 0;
+    bool sleeping_ = false;
+    Clock::time_point sleepUntil_;
+};
+
+}  // namespace coro
+
+#endif  // ASYNC_RUNTIME_H
@@ -0,0 +1,239 @@
+/* ==========================================================================
+generator.h - A Zero-Copy Generator (C++20)
+
+Theory:
+---------
+The Generator in the first version of Coroutines.cpp copied each value
+into the promise on co_yield and copied it out again in current(); it
+allocated its frame with the global operator new and ended the program
+on an exception. coro::Generator<T>:
+
+1. Yields by address: `co_yield x` stores a pointer to x, which stays
+   alive while the coroutine is suspended (a temporary lives until the
+   end of the full expression, which includes the suspension). `*it`
+   is a T& to that object: no copy at all.
+2. Allocates frames from per-thread free lists (detail::FramePool,
+   through promise_type::operator new/delete), so a short-lived generator
+   costs no malloc once a frame of its size has been freed.
+3. Is a std::ranges::input_range and a view: range-for,
+   `gen | std::views::take(5)`, std::ranges algorithms.
+4. Rethrows an exception of the coroutine body from begin() or ++it.
+
+Key Points:
+- Generator<T> yields T& (Generator<const T> yields const T&). Use the
+  reference before advancing; `std::move(*it)` takes the value.
+- `co_yield` of a const lvalue into a Generator<T> with non-const T makes
+  one copy (the coroutine could not hand out a T& to it otherwise).
+- A Generator is lazy (nothing runs before begin()) and move-only;
+  iterate it once.
+- Portable C++20: no threads, no operating-system calls.
+========================================================================== */
+
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+
+namespace coro {
+
+namespace detail {
+
+// Free lists of coroutine frames of up to 64, 128, 256 and 512 bytes, one
+// set per thread. A frame freed on another thread than the one that made
+// it joins the freeing thread's list; each list keeps at most kMaxFree.
+class FramePool {
+public:
+    static constexpr std::size_t kMaxFrame = 512;
+
+    static void* allocate(std::size_t size) {
+        if (size > kMaxFrame) return ::operator new(size);
+        Lists& lists = local();
+        const int c = classOf(size);
+        if (Node* n = lists.head[c]) {
+            lists.head[c] = n->next;
+            --lists.count[c];
+            return n;
+        }
+        return ::operator new(blockSize(c));
+    }
+
+    static void free(void* p, std::size_t size) {
+        if (size > kMaxFrame) return ::operator delete(p);
+        Lists& lists = local();
+        const int c = classOf(size);
+        if (lists.count[c] >= kMaxFree) return ::operator delete(p);
+        Node* n = static_cast<Node*>(p);
+        n->next = lists.head[c];
+        lists.head[c] = n;
+        ++lists.count[c];
+    }
+
+private:
+    static constexpr int kClasses = 4;
+    static constexpr std::size_t kMaxFree = 64;
+
+    struct Node {
+        Node* next;
+    };
+
+    // At thread exit the frames go back to operator delete, and the lists
+    // stay full, so a frame freed later (a generator destroyed by a static
+    // destructor) is deleted directly instead of cached.
+    struct Lists {
+        Node* head[kClasses] = {};
+        std::size_t count[kClasses] = {};
+
+        ~Lists() {
+            for (int c = 0; c < kClasses; ++c) {
+                while (Node* n = head[c]) {
+                    head[c] = n->next;
+                    ::operator delete(n);
+                }
+                count[c] = kMaxFree;
+            }
+        }
+    };
+
+    static int classOf(std::size_t size) {
+        return size <= 64 ? 0 : size <= 128 ? 1 : size <= 256 ? 2 : 3;
+    }
+    static std::size_t blockSize(int c) { return std::size_t(64) << c; }
+
+    static Lists& local() {
+        thread_local Lists lists;
+        return lists;
+    }
+};
+
+}  // namespace detail
+
+template <class T>
+class [[nodiscard]] Generator : public std::ranges::view_base {
+public:
+    using value_type = std::remove_cv_t<T>;
+    using reference = T&;
+
+    struct promise_type {
+        static void* operator new(std::size_t size) {
+            return detail::FramePool::allocate(size);
+        }
+        static void operator delete(void* p, std::size_t size) {
+            detail::FramePool::free(p, size);
+        }
+
+        Generator get_return_object() noexcept {
+            return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        std::suspend_always final_suspend() const noexcept { return {}; }
+
+        // Lvalues and temporaries: keep their address.
+        std::suspend_always yield_value(T& value) noexcept {
+            current = std::addressof(value);
+            return {};
+        }
+        std::suspend_always yield_value(T&& value) noexcept
+            requires(!std::is_const_v<T>)
+        {
+            current = std::addressof(value);
+            return {};
+        }
+
+        // A const object into a Generator of non-const T: one copy, kept in
+        // the awaiter, which lives in the frame while suspended.
+        auto yield_value(const T& value)
+            requires(!std::is_const_v<T>)
+        {
+            struct CopyAwaiter {
+                value_type copy;
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                    h.promise().current = std::addressof(copy);
+                }
+                void await_resume() const noexcept {}
+            };
+            return CopyAwaiter{value};
+        }
+
+        void return_void() const noexcept {}
+        void unhandled_exception() noexcept { error = std::current_exception(); }
+
+        // A generator cannot co_await: its caller resumes it, not an event.
+        template <class U>
+        std::suspend_never await_transform(U&&) = delete;
+
+        T* current = nullptr;
+        std::exception_ptr error;
+    };
+
+    class iterator {
+    public:
+        using iterator_concept = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = Generator::value_type;
+
+        iterator() = default;
+
+        reference operator*() const noexcept { return *handle_.promise().current; }
+        T* operator->() const noexcept { return handle_.promise().current; }
+
+        iterator& operator++() {
+            advance(handle_);
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+
+        friend bool operator==(const iterator& it, std::default_sentinel_t) noexcept {
+            return it.handle_.done();
+        }
+
+    private:
+        friend class Generator;
+        explicit iterator(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+        std::coroutine_handle<promise_type> handle_;
+    };
+
+    Generator() = default;
+    Generator(Generator&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    Generator& operator=(Generator&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    ~Generator() {
+        if (handle_) handle_.destroy();
+    }
+
+    // Runs the coroutine to its first co_yield.
+    iterator begin() {
+        advance(handle_);
+        return iterator(handle_);
+    }
+    std::default_sentinel_t end() const noexcept { return {}; }
+
+private:
+    explicit Generator(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    static void advance(std::coroutine_handle<promise_type> handle) {
+        handle.resume();
+        if (handle.done() && handle.promise().error)
+            std::rethrow_exception(std::exchange(handle.promise().error, nullptr));
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+}  // namespace coro
+
+#endif  // GENERATOR_H
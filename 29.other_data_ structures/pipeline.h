@@ -0,0 +1,623 @@
+/* ==========================================================================
+pipeline.h - Fused Lazy Pipelines (C++20)
+
+Theory:
+---------
+Stages written as generators, one feeding the next,
+
+   Generator<int> squares(Generator<int> in) { for (int x : in) co_yield x * x; }
+
+cost one resume and one suspend per element per stage. A pipeline here
+is pushed instead of pulled: the source loops over its elements and calls
+one function object per element, made by nesting the stages inside each
+other. After inlining, the whole pipeline is one loop:
+
+   iota(0, n) | map(f) | filter(p) | map(g) | sum()
+       =>  for (i = 0; i < n; ++i) { x = f(i); if (p(x)) total += g(x); }
+
+Adjacent stateless stages are also merged in the type: map(f) | map(g)
+becomes one map of g(f(x)), and filter(p) | filter(q) one filter of
+p(x) && q(x), so long chains do not nest deeper.
+
+Where a generator has to be handed out, chunks(pipeline, n) is a
+coro::Generator (generator.h) of spans of up to n elements: one resume
+per n elements instead of one per element and stage.
+
+Key Points:
+- Sources: iota(first, last), from(range) (containers, views, and
+  Generators, which are moved in).
+- Stages: map(f), filter(pred), take(n), chunk(n). chunk(n) passes
+  std::span<const T> of n elements (the last one may be shorter) to the
+  following stages.
+- Terminals run the pipeline: sum(), count(), reduce(init, op),
+  toVector(), forEach(f).
+- Nothing runs before a terminal (or chunks()) is applied. Terminals
+  take the pipeline by value, so `p | sum()` runs a copy and p can run
+  again, if its source can be copied: iota and from() of a container
+  lvalue or a copyable view can; from() of a container rvalue or of a
+  Generator is move-only (`std::move(p) | sum()`).
+- Edge Cases: a span from chunk(n) or chunks() is valid until the next
+  one is produced; copy what must outlive it. toVector() and chunks()
+  do that themselves: they collect a std::vector<T> for each span.
+========================================================================== */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "generator.h"
+
+namespace pipeline {
+
+// ---------------------------------------------------------------------------
+// Sources. run(sink) calls sink(x) for each element until the sink returns
+// false and returns whether the source is exhausted; the next run()
+// continues where the last one stopped. reset() starts over. `reference`
+// is the type of the x passed to the sink.
+// ---------------------------------------------------------------------------
+
+template <class I>
+class Iota {
+public:
+    using value_type = I;
+    using reference = I&;
+
+    Iota(I first, I last) : first_(first), next_(first), last_(last) {}
+
+    template <class Sink>
+    bool run(Sink& sink) {
+        I next = next_, last = last_;
+        while (next < last) {
+            I value = next++;
+            if (!sink(value)) break;
+        }
+        next_ = next;
+        return next == last;
+    }
+
+    void reset() { next_ = first_; }
+
+private:
+    I first_, next_, last_;
+};
+
+template <class View>
+class FromRange {
+public:
+    using value_type = std::ranges::range_value_t<View>;
+    using reference = std::ranges::range_reference_t<View>;
+
+    explicit FromRange(View view) : view_(std::move(view)) {}
+
+    // An iterator into the old view is no use to the new one: a copy or a
+    // moved-to source starts from the beginning.
+    FromRange(const FromRange& other)
+        requires std::copy_constructible<View>
+        : view_(other.view_) {}
+    FromRange(FromRange&& other) noexcept : view_(std::move(other.view_)) {}
+
+    template <class Sink>
+    bool run(Sink& sink) {
+        if (!it_) it_.emplace(std::ranges::begin(view_));
+        auto& it = *it_;
+        const auto end = std::ranges::end(view_);
+        while (it != end) {
+            bool more = sink(*it);
+            ++it;
+            if (!more) break;
+        }
+        return it == end;
+    }
+
+    void reset() { it_.reset(); }
+
+private:
+    View view_;
+    std::optional<std::ranges::iterator_t<View>> it_;
+};
+
+// ---------------------------------------------------------------------------
+// Stages. wrap<In>(down) returns the sink that feeds `down` from elements of
+// type In; Output<In> is the type it passes on. In and Output keep their
+// value category (int& for an lvalue, int for a temporary), so Output is
+// the type of the call the sink actually makes.
+// ---------------------------------------------------------------------------
+
+// f is called as a non-const F&, so a mutable lambda works; each run
+// starts from a copy of the f given to map().
+template <class F>
+struct Map {
+    F f;
+
+    template <class In>
+    using Output = std::invoke_result_t<F&, In>;
+
+    template <class Down>
+    struct Sink {
+        F f;
+        Down down;
+        template <class X>
+        bool operator()(X&& x) {
+            return down(std::invoke(f, std::forward<X>(x)));
+        }
+        void finish() { down.finish(); }
+    };
+
+    template <class In, class Down>
+    Sink<Down> wrap(Down down) const {
+        return Sink<Down>{f, std::move(down)};
+    }
+};
+
+template <class P>
+struct Filter {
+    P pred;
+
+    template <class In>
+    using Output = In;
+
+    template <class Down>
+    struct Sink {
+        P pred;
+        Down down;
+        template <class X>
+        bool operator()(X&& x) {
+            return std::invoke(pred, std::as_const(x)) ? down(std::forward<X>(x)) : true;
+        }
+        void finish() { down.finish(); }
+    };
+
+    template <class In, class Down>
+    Sink<Down> wrap(Down down) const {
+        return Sink<Down>{pred, std::move(down)};
+    }
+};
+
+struct Take {
+    std::size_t count;
+
+    template <class In>
+    using Output = In;
+
+    template <class Down>
+    struct Sink {
+        std::size_t left;
+        Down down;
+        template <class X>
+        bool operator()(X&& x) {
+            if (left == 0) return false;
+            --left;
+            return down(std::forward<X>(x)) && left != 0;
+        }
+        void finish() { down.finish(); }
+    };
+
+    template <class In, class Down>
+    Sink<Down> wrap(Down down) const {
+        return Sink<Down>{count, std::move(down)};
+    }
+};
+
+struct Chunk {
+    std::size_t size;
+
+    template <class In>
+    using Output = std::span<const std::remove_cvref_t<In>>;
+
+    template <class In, class Down>
+    struct Sink {
+        std::vector<In> buffer;
+        std::size_t size;
+        Down down;
+        template <class X>
+        bool operator()(X&& x) {
+            buffer.push_back(std::forward<X>(x));
+            if (buffer.size() < size) return true;
+            bool more = down(std::span<const In>(buffer));
+            buffer.clear();
+            return more;
+        }
+        void finish() {
+            if (!buffer.empty()) down(std::span<const In>(buffer));
+            buffer.clear();
+            down.finish();
+        }
+    };
+
+    template <class In, class Down>
+    auto wrap(Down down) const {
+        Sink<std::remove_cvref_t<In>, Down> sink{{}, size, std::move(down)};
+        sink.buffer.reserve(size);
+        return sink;
+    }
+};
+
+namespace detail {
+
+template <class F, class G>
+struct Compose {
+    F f;
+    G g;
+    template <class X>
+    decltype(auto) operator()(X&& x) {
+        return std::invoke(g, std::invoke(f, std::forward<X>(x)));
+    }
+};
+
+template <class P, class Q>
+struct Both {
+    P p;
+    Q q;
+    template <class X>
+    bool operator()(const X& x) {
+        return std::invoke(p, x) && std::invoke(q, x);
+    }
+};
+
+// Merges two adjacent stages into one, where that is possible.
+template <class A, class B>
+struct Fuse {
+    static constexpr bool value = false;
+};
+
+template <class F, class G>
+struct Fuse<Map<F>, Map<G>> {
+    static constexpr bool value = true;
+    static Map<Compose<F, G>> apply(Map<F> a, Map<G> b) {
+        return {{std::move(a.f), std::move(b.f)}};
+    }
+};
+
+template <class P, class Q>
+struct Fuse<Filter<P>, Filter<Q>> {
+    static constexpr bool value = true;
+    static Filter<Both<P, Q>> apply(Filter<P> a, Filter<Q> b) {
+        return {{std::move(a.pred), std::move(b.pred)}};
+    }
+};
+
+// The terminal's sink, held by reference at the end of the chain.
+template <class Terminal>
+struct TerminalRef {
+    Terminal* terminal;
+    template <class X>
+    bool operator()(X&& x) {
+        return (*terminal)(std::forward<X>(x));
+    }
+    void finish() {}
+};
+
+}  // namespace detail
+
+template <class Source, class... Stages>
+class Pipeline {
+    template <class T>
+    struct TypeBox {
+        using type = T;
+    };
+
+    template <std::size_t I, class In>
+    static constexpr auto outputOf() {
+        if constexpr (I == sizeof...(Stages)) {
+            return TypeBox<In>{};
+        } else {
+            using Stage = std::tuple_element_t<I, std::tuple<Stages...>>;
+            return outputOf<I + 1, typename Stage::template Output<In>>();
+        }
+    }
+
+public:
+    using value_type = typename Source::value_type;
+    using reference = typename Source::reference;
+    static constexpr std::size_t stageCount = sizeof...(Stages);
+
+    Pipeline(Source source, std::tuple<Stages...> stages)
+        : source_(std::move(source)), stages_(std::move(stages)) {}
+
+    // The type of the elements at the end of the pipeline.
+    using Output = std::remove_cvref_t<typename decltype(outputOf<0, reference>())::type>;
+
+    // Appends a stage, merging it into the last one where possible.
+    template <class Stage>
+    auto then(Stage stage) && {
+        if constexpr (sizeof...(Stages) > 0 && detail::Fuse<Last, Stage>::value) {
+            return replaceLast(std::make_index_sequence<sizeof...(Stages) - 1>{},
+                               detail::Fuse<Last, Stage>::apply(
+                                   std::get<sizeof...(Stages) - 1>(std::move(stages_)),
+                                   std::move(stage)));
+        } else {
+            return Pipeline<Source, Stages..., Stage>(
+                std::move(source_),
+                std::tuple_cat(std::move(stages_), std::tuple<Stage>(std::move(stage))));
+        }
+    }
+
+    // Builds the sink chain in front of `terminal` and runs the source
+    // until it is exhausted or a stage stops it. Returns whether the
+    // source is exhausted.
+    template <class Terminal>
+    bool runInto(Terminal& terminal) {
+        auto sink = makeSink<0, reference>(detail::TerminalRef<Terminal>{&terminal});
+        bool exhausted = source_.run(sink);
+        sink.finish();
+        return exhausted;
+    }
+
+    // As runInto(), but keeps the sink chain (and the state of take and
+    // chunk stages) between calls; used by chunks().
+    template <class Terminal>
+    auto resumable(Terminal& terminal) {
+        return makeSink<0, reference>(detail::TerminalRef<Terminal>{&terminal});
+    }
+
+    Source& source() { return source_; }
+
+private:
+    using Last = std::tuple_element_t<sizeof...(Stages) - (sizeof...(Stages) > 0),
+                                      std::tuple<Stages..., void>>;
+
+    template <std::size_t... Is, class Fused>
+    auto replaceLast(std::index_sequence<Is...>, Fused fused) {
+        using Result = Pipeline<Source, std::tuple_element_t<Is, std::tuple<Stages...>>...,
+                                Fused>;
+        return Result(std::move(source_),
+                      std::tuple<std::tuple_element_t<Is, std::tuple<Stages...>>..., Fused>(
+                          std::get<Is>(std::move(stages_))..., std::move(fused)));
+    }
+
+    template <std::size_t I, class In, class Down>
+    auto makeSink(Down down) const {
+        if constexpr (I == sizeof...(Stages)) {
+            return down;
+        } else {
+            using Stage = std::tuple_element_t<I, std::tuple<Stages...>>;
+            using Out = typename Stage::template Output<In>;
+            return std::get<I>(stages_).template wrap<In>(makeSink<I + 1, Out>(std::move(down)));
+        }
+    }
+
+    Source source_;
+    std::tuple<Stages...> stages_;
+};
+
+// ---------------------------------------------------------------------------
+// Building pipelines
+// ---------------------------------------------------------------------------
+
+template <class I>
+Pipeline<Iota<I>> iota(I first, I last) {
+    return Pipeline<Iota<I>>(Iota<I>(first, last), {});
+}
+
+template <std::ranges::viewable_range R>
+auto from(R&& range) {
+    using View = std::views::all_t<R>;
+    return Pipeline<FromRange<View>>(FromRange<View>(std::views::all(std::forward<R>(range))),
+                                     {});
+}
+
+template <class F>
+Map<std::decay_t<F>> map(F&& f) {
+    return {std::forward<F>(f)};
+}
+
+template <class P>
+Filter<std::decay_t<P>> filter(P&& pred) {
+    return {std::forward<P>(pred)};
+}
+
+inline Take take(std::size_t count) { return {count}; }
+inline Chunk chunk(std::size_t size) { return {size}; }
+
+template <class T>
+inline constexpr bool isStage = false;
+template <class F>
+inline constexpr bool isStage<Map<F>> = true;
+template <class P>
+inline constexpr bool isStage<Filter<P>> = true;
+template <>
+inline constexpr bool isStage<Take> = true;
+template <>
+inline constexpr bool isStage<Chunk> = true;
+
+template <class Source, class... Stages, class Stage>
+    requires isStage<Stage>
+auto operator|(Pipeline<Source, Stages...> p, Stage stage) {
+    return std::move(p).then(std::move(stage));
+}
+
+// ---------------------------------------------------------------------------
+// Terminals
+// ---------------------------------------------------------------------------
+
+namespace detail {
+
+// The spans from chunk() point into the stage's buffer, which is reused
+// for the next chunk and freed at the end of the run. Sinks that keep
+// elements store Owned<T>: a vector copy of a span, anything else as is.
+template <class T>
+struct OwnedType {
+    using type = T;
+};
+template <class U>
+struct OwnedType<std::span<const U>> {
+    using type = std::vector<U>;
+};
+template <class T>
+using Owned = typename OwnedType<T>::type;
+
+template <class T, class X>
+void keep(std::vector<T>& values, X&& x) {
+    if constexpr (std::is_same_v<T, std::remove_cvref_t<X>>)
+        values.push_back(std::forward<X>(x));
+    else
+        values.emplace_back(x.begin(), x.end());
+}
+
+template <class T>
+struct SumSink {
+    T total{};
+    bool operator()(const T& x) {
+        total += x;
+        return true;
+    }
+};
+
+struct CountSink {
+    std::size_t n = 0;
+    template <class X>
+    bool operator()(X&&) {
+        ++n;
+        return true;
+    }
+};
+
+template <class T, class Op>
+struct ReduceSink {
+    T acc;
+    Op op;
+    template <class X>
+    bool operator()(X&& x) {
+        acc = std::invoke(op, std::move(acc), std::forward<X>(x));
+        return true;
+    }
+};
+
+template <class T>
+struct VectorSink {
+    std::vector<T> values;
+    template <class X>
+    bool operator()(X&& x) {
+        keep(values, std::forward<X>(x));
+        return true;
+    }
+};
+
+template <class F>
+struct ForEachSink {
+    F f;
+    template <class X>
+    bool operator()(X&& x) {
+        std::invoke(f, std::forward<X>(x));
+        return true;
+    }
+};
+
+}  // namespace detail
+
+struct Sum {};
+struct Count {};
+struct ToVector {};
+template <class T, class Op>
+struct Reduce {
+    T init;
+    Op op;
+};
+template <class F>
+struct ForEach {
+    F f;
+};
+
+inline Sum sum() { return {}; }
+inline Count count() { return {}; }
+inline ToVector toVector() { return {}; }
+
+template <class T, class Op>
+Reduce<T, std::decay_t<Op>> reduce(T init, Op&& op) {
+    return {std::move(init), std::forward<Op>(op)};
+}
+
+template <class F>
+ForEach<std::decay_t<F>> forEach(F&& f) {
+    return {std::forward<F>(f)};
+}
+
+template <class Source, class... Stages>
+auto operator|(Pipeline<Source, Stages...> p, Sum) {
+    detail::SumSink<typename Pipeline<Source, Stages...>::Output> sink;
+    p.runInto(sink);
+    return sink.total;
+}
+
+template <class Source, class... Stages>
+std::size_t operator|(Pipeline<Source, Stages...> p, Count) {
+    detail::CountSink sink;
+    p.runInto(sink);
+    return sink.n;
+}
+
+template <class Source, class... Stages>
+auto operator|(Pipeline<Source, Stages...> p, ToVector) {
+    detail::VectorSink<detail::Owned<typename Pipeline<Source, Stages...>::Output>> sink;
+    p.runInto(sink);
+    return std::move(sink.values);
+}
+
+template <class Source, class... Stages, class T, class Op>
+T operator|(Pipeline<Source, Stages...> p, Reduce<T, Op> r) {
+    detail::ReduceSink<T, Op> sink{std::move(r.init), std::move(r.op)};
+    p.runInto(sink);
+    return std::move(sink.acc);
+}
+
+template <class Source, class... Stages, class F>
+void operator|(Pipeline<Source, Stages...> p, ForEach<F> each) {
+    detail::ForEachSink<F> sink{std::move(each.f)};
+    p.runInto(sink);
+}
+
+// ---------------------------------------------------------------------------
+// chunks(): the pipeline as a generator of spans
+// ---------------------------------------------------------------------------
+
+namespace detail {
+
+// Collects up to `limit` elements, then pauses the source.
+template <class T>
+struct BufferSink {
+    std::vector<T> values;
+    std::size_t limit;
+    template <class X>
+    bool operator()(X&& x) {
+        keep(values, std::forward<X>(x));
+        return values.size() < limit;
+    }
+};
+
+}  // namespace detail
+
+// Runs the pipeline size elements at a time; each resume yields a span of
+// up to `size` elements (vectors, if the pipeline ends in chunk()).
+template <class Source, class... Stages>
+coro::Generator<std::span<const detail::Owned<typename Pipeline<Source, Stages...>::Output>>>
+chunks(Pipeline<Source, Stages...> p, std::size_t size) {
+    using T = detail::Owned<typename Pipeline<Source, Stages...>::Output>;
+    detail::BufferSink<T> buffer{{}, size == 0 ? 1 : size};
+    buffer.values.reserve(buffer.limit);
+    auto sink = p.resumable(buffer);
+    bool exhausted = false;
+    while (!exhausted) {
+        exhausted = p.source().run(sink);
+        // A stage that stopped (take) ends the pipeline even if the
+        // source has elements left.
+        if (!exhausted && buffer.values.size() < buffer.limit) exhausted = true;
+        if (exhausted) sink.finish();
+        if (!buffer.values.empty()) co_yield std::span<const T>(buffer.values);
+        buffer.values.clear();
+    }
+}
+
+}  // namespace pipeline
+
+#endif  // PIPELINE_H
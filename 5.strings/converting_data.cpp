@@ -1,12 +1,19 @@
 /* ### Course 4: Converting Data to `std::string` ###
 
-   This course explains how to convert other data types into strings using 
+   This course explains how to convert other data types into strings using
    `std::to_string`, which can be useful for creating complex text outputs.
+
+   `std::to_string` always prints doubles with 6 decimals ("3.900000") and
+   every `+` builds a new temporary string. `number_format.h` prints the
+   shortest text that reads back to the same value ("3.9") and builds the
+   whole result with a single allocation (see fast_number_formatting.cpp).
 */
 
 #include <iostream>
 #include <string>
 
+#include "number_format.h"
+
 int main() {
     int year = 2024;
     double gpa = 3.9;
@@ -17,7 +24,15 @@ int main() {
 
     // Create a formatted string
     std::string info = "Year: " + yearStr + ", GPA: " + gpaStr;
-    std::cout << info << '\n';
+    std::cout << info << '\n';  // Year: 2024, GPA: 3.900000
+
+    // The same text, sized once and written in place
+    std::cout << numfmt::concat("Year: ", year, ", GPA: ", gpa) << '\n';  // Year: 2024, GPA: 3.9
+    std::cout << numfmt::format("Year: {}, GPA: {}", year, gpa) << '\n';
+
+    // Shortest round trip: the text converts back to exactly the same double
+    std::cout << std::to_string(0.1 + 0.2) << " vs " << numfmt::toString(0.1 + 0.2) << '\n';
+    std::cout << std::to_string(1e-9) << " vs " << numfmt::toString(1e-9) << '\n';
 
     return 0;
-}
\ No newline at end of file
+}
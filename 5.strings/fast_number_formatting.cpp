@@ -0,0 +1,223 @@
+/* ### Course 8: Fast Number Formatting ###
+
+   Course 4 builds "Year: 2024, GPA: 3.9" with `std::to_string` and `+`.
+   This course measures that line against the alternatives, and compares
+   the conversion of single numbers:
+
+   1. concat/to_string_plus   "Year: " + std::to_string(year) + ...
+   2. concat/ostringstream    ostringstream << "Year: " << year << ...
+   3. concat/snprintf         snprintf(buf, ..., "Year: %d, GPA: %g", ...)
+   4. concat/numfmt           numfmt::concat("Year: ", year, ...)
+   5. concat/numfmt_format    numfmt::format("Year: {}, GPA: {}", ...)
+   6. concat/numfmt_reuse     numfmt::concatTo into one cleared string
+   7. doubles/to_string, doubles/to_chars, doubles/numfmt
+   8. ints/to_string, ints/to_chars, ints/numfmt
+
+   **Key Concepts:**
+   - `std::to_string(double)` goes through a printf-style parser and
+     always prints 6 decimals; each `+` creates a temporary string.
+   - `numfmt::concat` converts every argument into a small stack buffer,
+     adds up the lengths, allocates once and copies each piece in place.
+   - `numfmt::toChars` prints the shortest text that reads back to the
+     same double (Schubfach algorithm), like C++17 `std::to_chars`.
+   - The doubles are random bit patterns (all magnitudes, 15-17 digits)
+     and GPAs like 3.9 (short); the integers cover all digit counts.
+
+   Compile & run:
+       g++ -std=c++17 -O2 fast_number_formatting.cpp -o numfmt
+       ./numfmt --bench-samples=5
+       ./numfmt --n=100000 --bench-filter=doubles
+*/
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../28.Compiler and Low-Level Optimizations/benchmark.h"
+#include "number_format.h"
+
+int main(int argc, char** argv) {
+    std::size_t n = 1000000;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--n=", 0) == 0) n = std::strtoull(arg.c_str() + 4, nullptr, 10);
+    }
+
+    std::mt19937_64 rng(42);
+    std::vector<int> years(n);
+    std::vector<double> gpas(n), doubles(n);
+    std::vector<long long> ints(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        years[i] = 1950 + static_cast<int>(rng() % 100);
+        gpas[i] = static_cast<double>(rng() % 401) / 100.0;  // 0.00 .. 4.00
+        std::uint64_t bits = rng();
+        std::memcpy(&doubles[i], &bits, 8);
+        if (!std::isfinite(doubles[i])) doubles[i] = static_cast<double>(bits >> 12);
+        ints[i] = static_cast<long long>(rng() >> (rng() % 64));  // 1 to 19 digits
+    }
+    std::cout << n << " values per run\n\n";
+
+    bench::registerCase("concat/to_string_plus", [&](bench::State& state) {
+        for (auto _ : state) {
+            for (std::size_t i = 0; i < n; ++i) {
+                std::string info = "Year: " + std::to_string(years[i]) +
+                                   ", GPA: " + std::to_string(gpas[i]);
+                bench::DoNotOptimize(info);
+            }
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("concat/ostringstream", [&](bench::State& state) {
+        for (auto _ : state) {
+            for (std::size_t i = 0; i < n; ++i) {
+                std::ostringstream out;
+                out << "Year: " << years[i] << ", GPA: " << gpas[i];
+                std::string info = out.str();
+                bench::DoNotOptimize(info);
+            }
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("concat/snprintf", [&](bench::State& state) {
+        for (auto _ : state) {
+            for (std::size_t i = 0; i < n; ++i) {
+                char buf[64];
+                int len = std::snprintf(buf, sizeof(buf), "Year: %d, GPA: %g", years[i], gpas[i]);
+                std::string info(buf, static_cast<std::size_t>(len));
+                bench::DoNotOptimize(info);
+            }
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("concat/numfmt", [&](bench::State& state) {
+        for (auto _ : state) {
+            for (std::size_t i = 0; i < n; ++i) {
+                std::string info = numfmt::concat("Year: ", years[i], ", GPA: ", gpas[i]);
+                bench::DoNotOptimize(info);
+            }
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("concat/numfmt_format", [&](bench::State& state) {
+        for (auto _ : state) {
+            for (std::size_t i = 0; i < n; ++i) {
+                std::string info = numfmt::format("Year: {}, GPA: {}", years[i], gpas[i]);
+                bench::DoNotOptimize(info);
+            }
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("concat/numfmt_reuse", [&](bench::State& state) {
+        std::string info;
+        for (auto _ : state) {
+            for (std::size_t i = 0; i < n; ++i) {
+                info.clear();  // keeps the capacity: no allocation after the first
+                numfmt::concatTo(info, "Year: ", years[i], ", GPA: ", gpas[i]);
+                bench::DoNotOptimize(info);
+            }
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("doubles/to_string", [&](bench::State& state) {
+        for (auto _ : state) {
+            for (double x : doubles) {
+                std::string s = std::to_string(x);
+                bench::DoNotOptimize(s);
+            }
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("doubles/to_chars", [&](bench::State& state) {
+        for (auto _ : state) {
+            for (double x : doubles) {
+                char buf[numfmt::kMaxChars];
+                char* end = std::to_chars(buf, buf + sizeof(buf), x).ptr;
+                bench::DoNotOptimize(end);
+            }
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("doubles/numfmt", [&](bench::State& state) {
+        for (auto _ : state) {
+            for (double x : doubles) {
+                char buf[numfmt::kMaxChars];
+                char* end = numfmt::toChars(buf, x);
+                bench::DoNotOptimize(end);
+            }
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("ints/to_string", [&](bench::State& state) {
+        for (auto _ : state) {
+            for (long long x : ints) {
+                std::string s = std::to_string(x);
+                bench::DoNotOptimize(s);
+            }
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("ints/to_chars", [&](bench::State& state) {
+        for (auto _ : state) {
+            for (long long x : ints) {
+                char buf[numfmt::kMaxChars];
+                char* end = std::to_chars(buf, buf + sizeof(buf), x).ptr;
+                bench::DoNotOptimize(end);
+            }
+        }
+        state.setItemsProcessed(n);
+    });
+
+    bench::registerCase("ints/numfmt", [&](bench::State& state) {
+        for (auto _ : state) {
+            for (long long x : ints) {
+                char buf[numfmt::kMaxChars];
+                char* end = numfmt::toChars(buf, x);
+                bench::DoNotOptimize(end);
+            }
+        }
+        state.setItemsProcessed(n);
+    });
+
+    int rc = bench::runAll(argc, argv);
+
+    std::string before = "Year: " + std::to_string(2024) + ", GPA: " + std::to_string(3.9);
+    std::cout << "\nto_string: " << before
+              << "\nnumfmt:    " << numfmt::concat("Year: ", 2024, ", GPA: ", 3.9) << '\n';
+    return rc;
+}
+
+/*
+   What to expect:
+   - concat/to_string_plus and concat/snprintf build about 2 million lines
+     per second; concat/ostringstream is 2-3x slower still (it constructs
+     a stream and a locale per line).
+   - concat/numfmt is about 3x faster than concat/to_string_plus, and
+     concat/numfmt_reuse about 4x, because it does not allocate at all.
+     concat/numfmt_format pays a little for scanning the format.
+   - doubles/numfmt runs at the speed of doubles/to_chars and prints the
+     same characters. doubles/to_string is 40x slower here: with 6 fixed
+     decimals a double like 1e300 prints all of its 301 integer digits,
+     and 1e-9 prints as "0.000000".
+   - ints/numfmt is slightly faster than ints/to_chars; ints/to_string
+     pays for the std::string it returns.
+   - The last lines compare the two versions of Course 4:
+         to_string: Year: 2024, GPA: 3.900000
+         numfmt:    Year: 2024, GPA: 3.9
+*/
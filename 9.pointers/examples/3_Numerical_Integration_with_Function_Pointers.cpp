@@ -7,20 +7,22 @@ This example demonstrates using function pointers for numerical integration, inc
 
 We use function pointers to dynamically specify the function to integrate, showcasing 
 the flexibility of function pointers in numerical computation.
+
+Both functions are thin adapters over integration_engine.h. A function pointer
+is an indirect call the compiler cannot inline, so the engine calls it once
+per sample; see 6_Vectorized_Integration_Engine.cpp for the inlined and SIMD
+versions.
 */
 
 #include <iostream>
 #include <cmath>
+
+#include "integration_engine.h"
 using namespace std;
 
 // Trapezoidal Rule Function
 double trapezoidalIntegration(double (*f)(double), double a, double b, int n) {
-    double h = (b - a) / n;
-    double integral = 0.5 * (f(a) + f(b));
-    for (int i = 1; i < n; ++i) {
-        integral += f(a + i * h);
-    }
-    return integral * h;
+    return integration::trapezoid(f, a, b, n);
 }
 
 // Simpson's Rule Function
@@ -29,13 +31,7 @@ double simpsonsIntegration(double (*f)(double), double a, double b, int n) {
         cerr << "Simpson's rule requires an even number of intervals.\n";
         return NAN;
     }
-    double h = (b - a) / n;
-    double integral = f(a) + f(b);
-    for (int i = 1; i < n; ++i) {
-        double x = a + i * h;
-        integral += (i % 2 == 0) ? 2 * f(x) : 4 * f(x);
-    }
-    return integral * (h / 3.0);
+    return integration::simpson(f, a, b, n);
 }
 
 // Example function to integrate
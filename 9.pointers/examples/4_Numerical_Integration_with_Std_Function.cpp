@@ -4,20 +4,23 @@ Numerical Integration Using std::function
 This example demonstrates using `std::function` for numerical integration. Unlike
 function pointers, `std::function` supports any callable, including lambdas, functors,
 and regular functions.
+
+The price is type erasure: every call goes through a pointer, so it cannot be
+inlined. Both functions are thin adapters over integration_engine.h; pass the
+lambda to `integration::trapezoid`/`integration::simpson` directly to let the
+compiler inline and vectorize it (see 6_Vectorized_Integration_Engine.cpp).
 */
 
 #include <iostream>
 #include <functional>
+#include <cmath>
+
+#include "integration_engine.h"
 using namespace std;
 
 // Function to perform Trapezoidal Integration
 double trapezoidalIntegration(const function<double(double)>& f, double a, double b, int n) {
-    double h = (b - a) / n;
-    double integral = 0.5 * (f(a) + f(b));
-    for (int i = 1; i < n; ++i) {
-        integral += f(a + i * h);
-    }
-    return integral * h;
+    return integration::trapezoid(f, a, b, n);
 }
 
 // Function to perform Simpson's Integration
@@ -26,13 +29,7 @@ double simpsonsIntegration(const function<double(double)>& f, double a, double b
         cerr << "Simpson's rule requires an even number of intervals.\n";
         return NAN;
     }
-    double h = (b - a) / n;
-    double integral = f(a) + f(b);
-    for (int i = 1; i < n; ++i) {
-        double x = a + i * h;
-        integral += (i % 2 == 0) ? 2 * f(x) : 4 * f(x);
-    }
-    return integral * (h / 3.0);
+    return integration::simpson(f, a, b, n);
 }
 
 int main() {
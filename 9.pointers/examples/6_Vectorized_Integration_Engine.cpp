@@ -0,0 +1,119 @@
+/*
+Vectorized Numerical Integration with Inlineable Callables
+-----------------------------------------------------------
+Examples 3 and 4 pass the integrand as a function pointer or a `std::function`.
+Both are indirect calls: the compiler cannot see the function body inside the
+integration loop, so it cannot inline it, and a loop containing an opaque call
+cannot be vectorized.
+
+integration_engine.h takes the integrand as a template parameter instead. This
+file compares four ways of calling the same engine on f(x) = x^2 + sqrt(x):
+1. Function pointer      - one indirect call per sample.
+2. std::function         - one indirect call per sample (type-erased).
+3. Scalar lambda         - `[](double x)`, inlined, one call per lane.
+4. Generic lambda        - `[](auto x)` wrapped in `integration::vectorized`,
+                           evaluated on a whole Vec of 4 or 8 doubles with
+                           AVX2 / AVX-512 instructions.
+
+A generic lambda that is not wrapped is called once per lane with a double,
+so any body compiles; the program checks this with exp(-x^2) before the
+benchmarks, both per lane and wrapped (exp then runs lane by lane).
+
+Compile & run:
+    g++ -std=c++17 -O2 -march=native 6_Vectorized_Integration_Engine.cpp -o integrate
+    ./integrate
+    ./integrate --bench-filter=simpson
+*/
+
+#include <cmath>
+#include <functional>
+#include <iostream>
+
+#include "../../28.Compiler and Low-Level Optimizations/benchmark.h"
+#include "integration_engine.h"
+using namespace std;
+
+const long long N = 1'000'000;
+
+double exampleFunction(double x) {
+    return x * x + sqrt(x);
+}
+
+// Exact value of the integral of x^2 + sqrt(x) over [0, 1].
+const double EXACT = 1.0 / 3.0 + 2.0 / 3.0;
+
+// Integral of exp(-x^2) over [0, 1]: sqrt(pi) / 2 * erf(1).
+const double EXACT_GAUSSIAN = 0.7468241328124270;
+
+template <class F>
+void registerRule(const string& name, F f) {
+    bench::registerCase("trapezoid/" + name, [f](bench::State& state) {
+        for (auto _ : state) {
+            double a = 0.0;
+            bench::DoNotOptimize(a);  // else a pure f is hoisted out of the loop
+            double r = integration::trapezoid(f, a, 1.0, N);
+            bench::DoNotOptimize(r);
+        }
+        state.setItemsProcessed(N);
+    });
+    bench::registerCase("simpson/" + name, [f](bench::State& state) {
+        for (auto _ : state) {
+            double a = 0.0;
+            bench::DoNotOptimize(a);  // else a pure f is hoisted out of the loop
+            double r = integration::simpson(f, a, 1.0, N);
+            bench::DoNotOptimize(r);
+        }
+        state.setItemsProcessed(N);
+    });
+}
+
+int main(int argc, char** argv) {
+    double (*pointer)(double) = exampleFunction;
+    function<double(double)> erased = exampleFunction;
+    auto scalarLambda = [](double x) { return x * x + sqrt(x); };
+    auto genericLambda = integration::vectorized([](auto x) {
+        using integration::sqrt;
+        using std::sqrt;
+        return x * x + sqrt(x);
+    });
+    auto gaussian = [](auto x) {
+        using integration::exp;
+        using std::exp;
+        return exp(-x * x);
+    };
+
+    cout << "Vec width: " << integration::Vec::width << " doubles\n";
+    cout << "Exact:        " << EXACT << '\n';
+    cout.precision(15);
+    cout << "Trapezoidal:  " << integration::trapezoid(genericLambda, 0.0, 1.0, N) << '\n';
+    cout << "Simpson:      " << integration::simpson(genericLambda, 0.0, 1.0, N) << '\n';
+    cout << "Simpson (fn): " << integration::simpson(pointer, 0.0, 1.0, N) << "\n\n";
+
+    double perLane = integration::simpson(gaussian, 0.0, 1.0, N);
+    double batched = integration::simpson(integration::vectorized(gaussian), 0.0, 1.0, N);
+    cout << "exp(-x^2), per lane: " << perLane << ", vectorized: " << batched
+         << ", exact: " << EXACT_GAUSSIAN << '\n';
+    if (fabs(perLane - EXACT_GAUSSIAN) > 1e-12 || fabs(batched - EXACT_GAUSSIAN) > 1e-12) {
+        cerr << "generic lambda integrated wrongly\n";
+        return 1;
+    }
+    cout << '\n';
+
+    registerRule("function_pointer", pointer);
+    registerRule("std_function", erased);
+    registerRule("scalar_lambda", scalarLambda);
+    registerRule("generic_lambda", genericLambda);
+    return bench::runAll(argc, argv);
+}
+
+/*
+What to expect (per sample, with -march=native):
+- function_pointer and std_function: a few nanoseconds, dominated by the
+  indirect call; both are about the same speed.
+- scalar_lambda: faster, since the body is inlined, although each lane is
+  still computed with scalar instructions.
+- generic_lambda: several times faster again; x*x and sqrt are done for
+  4 (AVX2) or 8 (AVX-512) samples per instruction.
+- Simpson costs the same as the trapezoidal rule: the odd and even samples
+  are summed in separate accumulators, so there is no `i % 2` branch.
+*/
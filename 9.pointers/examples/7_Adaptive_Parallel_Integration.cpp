@@ -0,0 +1,109 @@
+/*
+Adaptive, Multi-Threaded Numerical Integration
+-----------------------------------------------
+Examples 3, 4 and 6 use a fixed number of intervals `n` chosen by the caller.
+For an integrand with a sharp local feature that is a bad trade: n must be
+large enough to resolve the feature, so the smooth parts are oversampled by
+the same factor.
+
+This example integrates a sum of narrow Lorentzian peaks on [0, 1]:
+    f(x) = sum_k  eps / ((x - c_k)^2 + eps^2)     (eps = 1e-4)
+whose exact integral is known, and compares:
+1. Uniform Simpson (integration::simpson): doubling n until the error is
+   below the tolerance.
+2. Adaptive Gauss-Kronrod (integration::adaptiveIntegrate) with the same
+   tolerance, on the calling thread alone and on 4 threads: the caller and
+   a pool of worker threads that is started once and reused by every call.
+   The pool (thread_pool.h) makes this example Linux only.
+
+Compile & run:
+    g++ -std=c++17 -O2 -march=native -pthread 7_Adaptive_Parallel_Integration.cpp -o adaptive
+    ./adaptive
+*/
+
+#include <cmath>
+#include <iostream>
+#include <string>
+
+#include "../../28.Compiler and Low-Level Optimizations/benchmark.h"
+#include "adaptive_integration.h"
+using namespace std;
+
+const double EPS = 1e-4;
+const double CENTERS[] = {0.1234, 0.3141, 0.5, 0.7071, 0.9};
+const double TOLERANCE = 1e-8;
+
+double peaks(double x) {
+    double sum = 0.0;
+    for (double c : CENTERS) sum += EPS / ((x - c) * (x - c) + EPS * EPS);
+    return sum;
+}
+
+double exactIntegral() {
+    double sum = 0.0;
+    for (double c : CENTERS) sum += atan((1.0 - c) / EPS) - atan((0.0 - c) / EPS);
+    return sum;
+}
+
+int main(int argc, char** argv) {
+    const double exact = exactIntegral();
+    auto f = [](double x) { return peaks(x); };
+    cout.precision(12);
+    cout << "Exact integral:  " << exact << "\n\n";
+
+    // 1. Uniform refinement: how large must n be?
+    long long n = 16;
+    double uniform = integration::simpson(f, 0.0, 1.0, n);
+    while (fabs(uniform - exact) > TOLERANCE && n < (1LL << 30)) {
+        n *= 2;
+        uniform = integration::simpson(f, 0.0, 1.0, n);
+    }
+    cout << "Uniform Simpson:  " << uniform << "  error " << fabs(uniform - exact)
+         << "  (" << n + 1 << " evaluations)\n";
+
+    // 2. Adaptive refinement.
+    integration::AdaptiveOptions options;
+    options.absTol = TOLERANCE;
+    options.threads = 1;
+    integration::AdaptiveResult r = integration::adaptiveIntegrate(f, 0.0, 1.0, options);
+    cout << "Adaptive G7K15:   " << r.value << "  error " << fabs(r.value - exact)
+         << "  (estimate " << r.errorEstimate << ", " << r.evaluations << " evaluations, "
+         << r.intervals << " intervals" << (r.converged ? "" : ", NOT converged") << ")\n\n";
+
+    // 3. Timing: uniform vs adaptive, adaptive on 1 thread vs a pool.
+    tasks::ThreadPool pool(3);  // with the calling thread: 4
+    bench::registerCase("uniform_simpson", [f, n](bench::State& state) {
+        for (auto _ : state) {
+            double v = integration::simpson(f, 0.0, 1.0, n);
+            bench::DoNotOptimize(v);
+        }
+    });
+    for (unsigned threads : {1u, 4u}) {
+        string name = "adaptive/threads_" + to_string(threads);
+        bench::registerCase(name, [f, threads, &pool](bench::State& state) {
+            integration::AdaptiveOptions o;
+            o.absTol = TOLERANCE;
+            o.threads = threads;
+            o.pool = &pool;
+            for (auto _ : state) {
+                double v = integration::adaptiveIntegrate(f, 0.0, 1.0, o).value;
+                bench::DoNotOptimize(v);
+            }
+        });
+    }
+    return bench::runAll(argc, argv);
+}
+
+/*
+What to expect:
+- Uniform Simpson needs ~65000 evaluations: the step must be small compared
+  with eps = 1e-4 everywhere, although only the neighbourhood of the five
+  peaks needs it.
+- Adaptive G7K15 reaches a far smaller error with ~4600 evaluations,
+  concentrated around the peaks, and is several times faster.
+- threads_4 starts no threads per call: each split costs one task of the
+  pool. More threads help when the integrand is expensive or the
+  tolerance is tight; for a cheap integrand like this one the task and
+  wake-up costs eat much of the gain (compare threads_1 with threads_4, on a
+  machine with at least 4 cores).
+*/
@@ -0,0 +1,221 @@
+/*
+adaptive_integration.h - Adaptive, Multi-Threaded Gauss-Kronrod Quadrature
+---------------------------------------------------------------------------
+`trapezoidalIntegration(f, a, b, n)` refines the whole interval uniformly: to
+resolve a narrow peak, every part of [a, b] gets the same tiny step, even
+where f is a straight line. Adaptive quadrature refines only where it is
+needed:
+
+1. Integrate [a, b] with the 15-point Gauss-Kronrod rule (G7K15). The
+   embedded 7-point Gauss rule reuses 7 of the 15 samples, and |K15 - G7| is
+   an estimate of the error.
+2. If the error of an interval is small enough, accept it. Otherwise split
+   it in two and repeat on each half.
+
+An interval of width w is accepted when its error is below tol * w / (b - a).
+That test depends only on the interval itself, so the two halves of a split
+are independent and can be refined by different threads:
+
+- The work runs on a tasks::ThreadPool (27.Concurrency.../thread_pool.h),
+  by default one shared by all calls and started on the first one. No
+  threads are created per call, and idle workers sleep in the pool.
+- A split hands the right half to the pool as a task and refines the left
+  half itself, then waits; a waiting worker runs other tasks meanwhile.
+  Idle workers steal the oldest, widest pending halves. With
+  `threads = n`, at most n - 1 halves are in the pool at a time, so at
+  most n threads work on one integral.
+- thread_pool.h sleeps on a futex, so this header is Linux only, and
+  needs -pthread; integration_engine.h alone is portable.
+- The halves' results are added in the order of the intervals, so the
+  result does not depend on which thread refined what.
+
+Key Points:
+- The returned error estimate is the sum of |K15 - G7| over the accepted
+  intervals: a conservative bound for smooth integrands.
+- The integrand is called concurrently from several threads; it must not
+  modify shared state. Use threads = 1 otherwise: everything then runs on
+  the calling thread.
+- Edge Cases: singularities or discontinuities can make an interval never
+  converge; refinement then stops at maxDepth, and `converged` is false if
+  the total error estimate is still above the tolerance.
+*/
+
+#ifndef ADAPTIVE_INTEGRATION_H
+#define ADAPTIVE_INTEGRATION_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <type_traits>
+
+#include "../../27.Concurrency and Multithreading (Optional/thread_pool.h"
+#include "integration_engine.h"
+
+namespace integration {
+
+struct AdaptiveOptions {
+    double absTol = 1e-10;     // target for the total error estimate
+    double relTol = 0.0;       // or relative to |integral| (the looser wins)
+    int maxDepth = 50;         // an interval is never split more than this
+    unsigned threads = 0;      // most threads on one integral; 0 = the pool's + caller
+    tasks::ThreadPool* pool = nullptr;  // where they run; nullptr = sharedPool()
+};
+
+struct AdaptiveResult {
+    double value = 0.0;
+    double errorEstimate = 0.0;
+    long long evaluations = 0;  // calls of the integrand
+    long long intervals = 0;    // accepted subintervals
+    bool converged = true;      // false if some interval hit maxDepth
+};
+
+namespace detail {
+
+struct KronrodEstimate {
+    double value;
+    double error;
+};
+
+// G7K15 on [a, b]: the Kronrod nodes in decreasing order; the Gauss nodes
+// are the odd entries (0.949.., 0.741.., 0.405.., 0).
+template <class F>
+KronrodEstimate gaussKronrod15(F& f, double a, double b) {
+    static const double xgk[8] = {
+        0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+        0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+        0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+        0.207784955007898467600689403773245, 0.000000000000000000000000000000000};
+    static const double wgk[8] = {
+        0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+        0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+        0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+        0.204432940075298892414161999234649, 0.209482141084727828012999174891714};
+    static const double wg[4] = {
+        0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+        0.381830050505118944950369775488975, 0.417959183673469387755102040816327};
+
+    double center = 0.5 * (a + b);
+    double halfWidth = 0.5 * (b - a);
+    double fc = at(f, center);
+    double kronrod = wgk[7] * fc;
+    double gauss = wg[3] * fc;
+    for (int j = 0; j < 7; ++j) {
+        double dx = halfWidth * xgk[j];
+        double pair = at(f, center - dx) + at(f, center + dx);
+        kronrod += wgk[j] * pair;
+        if (j % 2 == 1) gauss += wg[j / 2] * pair;
+    }
+    return {kronrod * halfWidth, std::fabs((kronrod - gauss) * halfWidth)};
+}
+
+struct Interval {
+    double a, b;
+    double value, error;  // G7K15 estimate, computed when the interval is created
+    int depth;
+};
+
+template <class F>
+class AdaptiveSolver {
+public:
+    AdaptiveSolver(F& f, double width, double tol, int maxDepth, tasks::ThreadPool* pool,
+                   unsigned maxTasks)
+        : f_(f), width_(width), tol_(tol), maxDepth_(maxDepth), pool_(pool),
+          maxTasks_(maxTasks) {}
+
+    // Refines iv until every piece is accepted; returns the sums over the pieces.
+    AdaptiveResult solve(const Interval& iv) {
+        AdaptiveResult r;
+        double allowed = tol_ * ((iv.b - iv.a) / width_);
+        if (iv.error <= allowed || iv.depth >= maxDepth_) {
+            r.value = iv.value;
+            r.errorEstimate = iv.error;
+            r.intervals = 1;
+            r.converged = iv.error <= allowed;
+            return r;
+        }
+        double mid = 0.5 * (iv.a + iv.b);
+        KronrodEstimate l = gaussKronrod15(f_, iv.a, mid);
+        KronrodEstimate h = gaussKronrod15(f_, mid, iv.b);
+        const Interval lower{iv.a, mid, l.value, l.error, iv.depth + 1};
+        const Interval upper{mid, iv.b, h.value, h.error, iv.depth + 1};
+        AdaptiveResult left, right;
+        if (pool_ && claimTask()) {
+            tasks::TaskGroup group(*pool_);
+            group.run([this, &upper, &right] {
+                right = solve(upper);
+                tasks_.fetch_sub(1, std::memory_order_relaxed);
+            });
+            left = solve(lower);
+            group.wait();
+        } else {
+            left = solve(lower);
+            right = solve(upper);
+        }
+        r.value = left.value + right.value;
+        r.errorEstimate = left.errorEstimate + right.errorEstimate;
+        r.evaluations = 30 + left.evaluations + right.evaluations;
+        r.intervals = left.intervals + right.intervals;
+        r.converged = left.converged && right.converged;
+        return r;
+    }
+
+private:
+    // A slot for one more half in the pool, if fewer than maxTasks_ are.
+    bool claimTask() {
+        unsigned n = tasks_.load(std::memory_order_relaxed);
+        while (n < maxTasks_)
+            if (tasks_.compare_exchange_weak(n, n + 1, std::memory_order_relaxed)) return true;
+        return false;
+    }
+
+    F& f_;
+    double width_, tol_;
+    int maxDepth_;
+    tasks::ThreadPool* pool_;  // nullptr: everything on the calling thread
+    unsigned maxTasks_;
+    std::atomic<unsigned> tasks_{0};  // halves handed to the pool and not done
+};
+
+}  // namespace detail
+
+// The pool used when AdaptiveOptions::pool is nullptr: one worker per
+// hardware thread, started by the first call and kept for the program.
+inline tasks::ThreadPool& sharedPool() {
+    static tasks::ThreadPool pool;
+    return pool;
+}
+
+// Integrates f over [a, b] to the requested tolerance. Accepts the same
+// callables as trapezoid()/simpson().
+template <class F>
+AdaptiveResult adaptiveIntegrate(F&& f, double a, double b,
+                                 const AdaptiveOptions& options = AdaptiveOptions()) {
+    using Fn = std::remove_reference_t<F>;
+    if (a == b) return AdaptiveResult();
+    if (a > b) {
+        AdaptiveResult r = adaptiveIntegrate(f, b, a, options);
+        r.value = -r.value;
+        return r;
+    }
+
+    detail::KronrodEstimate whole = detail::gaussKronrod15(f, a, b);
+    double tol = std::max(options.absTol, options.relTol * std::fabs(whole.value));
+    tasks::ThreadPool* pool = nullptr;
+    unsigned maxTasks = 0;
+    if (options.threads != 1) {
+        pool = options.pool ? options.pool : &sharedPool();
+        maxTasks = options.threads ? options.threads - 1 : static_cast<unsigned>(pool->size());
+    }
+
+    detail::AdaptiveSolver<Fn> solver(f, b - a, tol, options.maxDepth, pool, maxTasks);
+    AdaptiveResult r = solver.solve({a, b, whole.value, whole.error, 0});
+    r.evaluations += 15;
+    // An interval stopped at maxDepth is harmless if the total still meets
+    // the target (typical next to an integrable singularity).
+    r.converged = r.converged || r.errorEstimate <= tol;
+    return r;
+}
+
+}  // namespace integration
+
+#endif  // ADAPTIVE_INTEGRATION_H